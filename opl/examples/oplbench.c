@@ -0,0 +1,214 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//     Benchmark for the OPL3 emulator.  Plays a generated sequence
+//     of notes on all 18 channels, once a sample at a time and once
+//     through OPL3_GenerateStream, as the SDL backend does, checks
+//     that both give the same output and reports how many samples per
+//     second each managed.
+//
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "opl3.h"
+
+// Samples generated per call, as for an SDL mixer callback.
+
+#define CHUNK_SAMPLES 512
+
+// Offsets of the operators of each channel in the register map.
+
+static const int op_offsets[9] = { 0x00, 0x01, 0x02, 0x08, 0x09, 0x0a,
+                                   0x10, 0x11, 0x12 };
+
+static unsigned int rand_state;
+
+static unsigned int Random(void)
+{
+    rand_state = rand_state * 1103515245 + 12345;
+    return (rand_state >> 16) & 0x7fff;
+}
+
+static void WriteOperator(opl3_chip *chip, int bank, int op)
+{
+    int reg;
+
+    reg = (bank << 8) | op;
+
+    OPL3_WriteRegBuffered(chip, 0x20 + reg, Random() & 0xff);
+    OPL3_WriteRegBuffered(chip, 0x40 + reg, Random() & 0x3f);
+    OPL3_WriteRegBuffered(chip, 0x60 + reg, 0x80 | (Random() & 0x7f));
+    OPL3_WriteRegBuffered(chip, 0x80 + reg, Random() & 0xff);
+    OPL3_WriteRegBuffered(chip, 0xe0 + reg, Random() & 0x07);
+}
+
+// Set up a random instrument on every channel.
+
+static void SetupChip(opl3_chip *chip)
+{
+    int bank, ch;
+
+    rand_state = 1;
+
+    OPL3_WriteRegBuffered(chip, 0x105, 0x01);     // OPL3 mode
+    OPL3_WriteRegBuffered(chip, 0x104, 0x03);     // two 4-op channels
+    OPL3_WriteRegBuffered(chip, 0x01, 0x20);
+
+    for (bank = 0; bank < 2; ++bank)
+    {
+        for (ch = 0; ch < 9; ++ch)
+        {
+            WriteOperator(chip, bank, op_offsets[ch]);
+            WriteOperator(chip, bank, op_offsets[ch] + 3);
+            OPL3_WriteRegBuffered(chip, (bank << 8) | (0xc0 + ch),
+                                  0x30 | (Random() & 0x0f));
+        }
+    }
+}
+
+// Key a new note on or off on a random channel.
+
+static void PlayNote(opl3_chip *chip)
+{
+    int reg;
+    int freq;
+
+    reg = ((Random() & 1) << 8) | (Random() % 9);
+    freq = 0x100 + (Random() & 0x1ff);
+
+    OPL3_WriteRegBuffered(chip, 0xa0 + reg, freq & 0xff);
+    OPL3_WriteRegBuffered(chip, 0xb0 + reg,
+                          (Random() & 0x20) | ((Random() & 7) << 2)
+                        | (freq >> 8));
+
+    // Switch rhythm mode on and off from time to time.
+
+    if ((Random() & 0x1f) == 0)
+    {
+        OPL3_WriteRegBuffered(chip, 0xbd, Random() & 0xff);
+    }
+}
+
+typedef void (*generate_func_t)(opl3_chip *chip, Bit16s *buf,
+                                Bit32u numsamples);
+
+static void GeneratePerSample(opl3_chip *chip, Bit16s *buf,
+                              Bit32u numsamples)
+{
+    Bit32u i;
+
+    for (i = 0; i < numsamples; ++i)
+    {
+        OPL3_GenerateResampled(chip, buf + i * 2);
+    }
+}
+
+// Generate the given number of samples, returning the time taken in
+// seconds.
+
+static double Run(generate_func_t func, Bit16s *output,
+                  unsigned int samplerate, unsigned int numsamples)
+{
+    static opl3_chip chip;
+    unsigned int i, n;
+    clock_t start;
+
+    OPL3_Reset(&chip, samplerate);
+    SetupChip(&chip);
+
+    start = clock();
+
+    for (i = 0; i < numsamples; i += n)
+    {
+        n = numsamples - i;
+
+        if (n > CHUNK_SAMPLES)
+        {
+            n = CHUNK_SAMPLES;
+        }
+
+        // A few notes every chunk.
+
+        PlayNote(&chip);
+        PlayNote(&chip);
+
+        func(&chip, output + i * 2, n);
+    }
+
+    return (double) (clock() - start) / CLOCKS_PER_SEC;
+}
+
+// Time a block function against the equivalent sample-at-a-time
+// function and check that they produce the same output.
+
+static int Compare(const char *name, generate_func_t per_sample,
+                   generate_func_t block, Bit16s *reference,
+                   Bit16s *output, unsigned int samplerate,
+                   unsigned int numsamples)
+{
+    double t1, t2;
+
+    t1 = Run(per_sample, reference, samplerate, numsamples);
+    t2 = Run(block, output, samplerate, numsamples);
+
+    printf("%s: %u samples at %u Hz\n", name, numsamples, samplerate);
+    printf("  per sample:  %12.0f samples/s\n", numsamples / t1);
+    printf("  block:       %12.0f samples/s\n", numsamples / t2);
+
+    if (memcmp(reference, output, numsamples * 2 * sizeof(Bit16s)) != 0)
+    {
+        printf("  Output differs!\n");
+        return 0;
+    }
+
+    return 1;
+}
+
+int main(int argc, char *argv[])
+{
+    Bit16s *reference, *output;
+    unsigned int samplerate;
+    unsigned int numsamples;
+    double seconds;
+    int success;
+
+    seconds = argc > 1 ? atof(argv[1]) : 60;
+    samplerate = argc > 2 ? atoi(argv[2]) : 44100;
+    numsamples = (unsigned int) (seconds * samplerate);
+
+    if (numsamples == 0)
+    {
+        printf("Usage: %s [seconds] [sample rate]\n", argv[0]);
+        exit(-1);
+    }
+
+    reference = malloc(numsamples * 2 * sizeof(Bit16s));
+    output = malloc(numsamples * 2 * sizeof(Bit16s));
+
+    if (reference == NULL || output == NULL)
+    {
+        fprintf(stderr, "Failed to allocate output buffers\n");
+        exit(-1);
+    }
+
+    success = Compare("OPL3_GenerateStream", GeneratePerSample,
+                      OPL3_GenerateStream, reference, output,
+                      samplerate, numsamples);
+
+    return success ? 0 : 1;
+}
@@ -159,6 +159,24 @@ opl_init_result_t OPL_Init(unsigned int port_base)
     }
 }
 
+// Initialize the OPL library for offline rendering.  There is no chip
+// to detect, so this always succeeds with an emulated OPL3.
+
+opl_init_result_t OPL_InitOffline(void)
+{
+    OPL_Shutdown();
+
+    if (!opl_offline_driver.init_func(0))
+    {
+        return OPL_INIT_NONE;
+    }
+
+    driver = &opl_offline_driver;
+    init_stage_reg_writes = 0;
+
+    return OPL_INIT_OPL3;
+}
+
 // Shut down the OPL library.
 
 void OPL_Shutdown(void)
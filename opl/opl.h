@@ -77,6 +77,10 @@ typedef enum
 
 opl_init_result_t OPL_Init(unsigned int port_base);
 
+// Initialize the OPL subsystem for offline rendering with OPL_Render().
+
+opl_init_result_t OPL_InitOffline(void);
+
 // Shut down the OPL subsystem.
 
 void OPL_Shutdown(void);
@@ -149,5 +153,11 @@ void OPL_Delay(uint64_t us);
 
 void OPL_SetPaused(int paused);
 
+// Generate the given number of stereo samples at the configured sample
+// rate when initialized with OPL_InitOffline(), invoking callbacks as
+// the virtual clock passes them.
+
+void OPL_Render(int16_t *buffer, unsigned int nsamples);
+
 #endif
 
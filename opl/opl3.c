@@ -372,6 +372,14 @@ static void OPL3_EnvelopeCalc(opl3_slot *slot)
     Bit8u reset = 0;
     slot->eg_out = slot->eg_rout + (slot->reg_tl << 2)
                  + (slot->eg_ksl >> kslshift[slot->reg_ksl]) + *slot->trem;
+    if (!slot->key && slot->eg_gen == envelope_gen_num_release
+     && slot->eg_rout == 0x1ff)
+    {
+        // Released and fully attenuated: the envelope cannot change
+        // until the slot is keyed on again, so skip the rate logic.
+        slot->pg_reset = 0;
+        return;
+    }
     if (slot->key && slot->eg_gen == envelope_gen_num_release)
     {
         reset = 1;
@@ -660,9 +668,37 @@ static void OPL3_SlotWriteE0(opl3_slot *slot, Bit8u data)
     }
 }
 
+// Output of a slot attenuated so far (envelope >= 0x180) that
+// OPL3_EnvelopeCalcExp always shifts the result down to zero: only the
+// sign of the waveform is left.
+
+static Bit16s OPL3_EnvelopeCalcSilent(Bit8u wf, Bit16u phase)
+{
+    switch (wf)
+    {
+    case 0:
+    case 6:
+    case 7:
+        return (phase & 0x200) ? -1 : 0;
+    case 4:
+        return ((phase & 0x300) == 0x100) ? -1 : 0;
+    default:
+        return 0;
+    }
+}
+
 static void OPL3_SlotGenerate(opl3_slot *slot)
 {
-    slot->out = envelope_sin[slot->reg_wf](slot->pg_phase_out + *slot->mod, slot->eg_out);
+    Bit16u phase = slot->pg_phase_out + *slot->mod;
+
+    if (slot->eg_out >= 0x180)
+    {
+        slot->out = OPL3_EnvelopeCalcSilent(slot->reg_wf, phase);
+    }
+    else
+    {
+        slot->out = envelope_sin[slot->reg_wf](phase, slot->eg_out);
+    }
 }
 
 static void OPL3_SlotCalcFB(opl3_slot *slot)
@@ -0,0 +1,240 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//     OPL offline renderer.  Like the SDL driver, but rather than
+//     being driven by an audio callback, output is generated on
+//     demand by OPL_Render() against a virtual clock, so it runs as
+//     fast as the CPU allows.
+//
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "opl3.h"
+
+#include "opl.h"
+#include "opl_internal.h"
+
+#include "opl_queue.h"
+
+// Queue of callbacks waiting to be invoked.
+
+static opl_callback_queue_t *callback_queue = NULL;
+
+// Current time, in us since the renderer was initialized.
+
+static uint64_t current_time;
+
+// If non-zero, playback is currently paused.
+
+static int opl_offline_paused;
+
+// Time offset (in us) due to the fact that callbacks
+// were previously paused.
+
+static uint64_t pause_offset;
+
+// OPL software emulator structure.
+
+static opl3_chip opl_chip;
+
+// Register number that was written.
+
+static int register_num = 0;
+
+// Advance time by the specified number of samples, invoking any
+// callback functions as appropriate.
+
+static void AdvanceTime(unsigned int nsamples)
+{
+    opl_callback_t callback;
+    void *callback_data;
+    uint64_t us;
+
+    us = ((uint64_t) nsamples * OPL_SECOND) / opl_sample_rate;
+    current_time += us;
+
+    if (opl_offline_paused)
+    {
+        pause_offset += us;
+    }
+
+    while (!OPL_Queue_IsEmpty(callback_queue)
+        && current_time >= OPL_Queue_Peek(callback_queue) + pause_offset)
+    {
+        if (!OPL_Queue_Pop(callback_queue, &callback, &callback_data))
+        {
+            break;
+        }
+
+        callback(callback_data);
+    }
+}
+
+void OPL_Render(int16_t *buffer, unsigned int nsamples)
+{
+    unsigned int filled;
+
+    // Not initialized (no music playing): output silence.
+
+    if (callback_queue == NULL)
+    {
+        memset(buffer, 0, nsamples * 4);
+        return;
+    }
+
+    filled = 0;
+
+    while (filled < nsamples)
+    {
+        uint64_t next_callback_time;
+        uint64_t n;
+
+        // Generate samples up to the time of the next callback, as
+        // is done by the SDL mixing callback.
+
+        if (opl_offline_paused || OPL_Queue_IsEmpty(callback_queue))
+        {
+            n = nsamples - filled;
+        }
+        else
+        {
+            next_callback_time = OPL_Queue_Peek(callback_queue) + pause_offset;
+
+            n = (next_callback_time - current_time) * opl_sample_rate;
+            n = (n + OPL_SECOND - 1) / OPL_SECOND;
+
+            if (n > nsamples - filled)
+            {
+                n = nsamples - filled;
+            }
+        }
+
+        OPL3_GenerateStream(&opl_chip, (Bit16s *) buffer + filled * 2, n);
+        filled += n;
+
+        AdvanceTime(n);
+    }
+}
+
+static void OPL_Offline_Shutdown(void)
+{
+    if (callback_queue != NULL)
+    {
+        OPL_Queue_Destroy(callback_queue);
+        callback_queue = NULL;
+    }
+}
+
+static int OPL_Offline_Init(unsigned int port_base)
+{
+    callback_queue = OPL_Queue_Create();
+    current_time = 0;
+    opl_offline_paused = 0;
+    pause_offset = 0;
+
+    OPL3_Reset(&opl_chip, opl_sample_rate);
+
+    return 1;
+}
+
+static unsigned int OPL_Offline_PortRead(opl_port_t port)
+{
+    // No timers: the chip is never probed, see OPL_InitOffline().
+
+    if (port == OPL_REGISTER_PORT_OPL3)
+    {
+        return 0xff;
+    }
+
+    return 0;
+}
+
+static void OPL_Offline_PortWrite(opl_port_t port, unsigned int value)
+{
+    if (port == OPL_REGISTER_PORT)
+    {
+        register_num = value;
+    }
+    else if (port == OPL_REGISTER_PORT_OPL3)
+    {
+        register_num = value | 0x100;
+    }
+    else if (port == OPL_DATA_PORT)
+    {
+        switch (register_num)
+        {
+            case OPL_REG_TIMER1:
+            case OPL_REG_TIMER2:
+            case OPL_REG_TIMER_CTRL:
+                break;
+
+            default:
+                OPL3_WriteRegBuffered(&opl_chip, register_num, value);
+                break;
+        }
+    }
+}
+
+static void OPL_Offline_SetCallback(uint64_t us, opl_callback_t callback,
+                                    void *data)
+{
+    OPL_Queue_Push(callback_queue, callback, data,
+                   current_time - pause_offset + us);
+}
+
+static void OPL_Offline_ClearCallbacks(void)
+{
+    OPL_Queue_Clear(callback_queue);
+}
+
+// Callbacks are only ever invoked from OPL_Render(), on the calling
+// thread, so there is nothing to lock.
+
+static void OPL_Offline_Lock(void)
+{
+}
+
+static void OPL_Offline_Unlock(void)
+{
+}
+
+static void OPL_Offline_SetPaused(int paused)
+{
+    opl_offline_paused = paused;
+}
+
+static void OPL_Offline_AdjustCallbacks(float factor)
+{
+    OPL_Queue_AdjustCallbacks(callback_queue, current_time, factor);
+}
+
+opl_driver_t opl_offline_driver =
+{
+    "offline",
+    OPL_Offline_Init,
+    OPL_Offline_Shutdown,
+    OPL_Offline_PortRead,
+    OPL_Offline_PortWrite,
+    OPL_Offline_SetCallback,
+    OPL_Offline_ClearCallbacks,
+    OPL_Offline_Lock,
+    OPL_Offline_Unlock,
+    OPL_Offline_SetPaused,
+    OPL_Offline_AdjustCallbacks,
+};
+
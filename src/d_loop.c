@@ -37,6 +37,7 @@
 #include "net_server.h"
 #include "net_sdl.h"
 #include "net_loop.h"
+#include "net_udp.h"
 
 // TODO: Move nonvanilla demo functions into a dedicated file.
 #include "m_misc.h"
@@ -375,7 +376,8 @@ boolean D_InitNetGame(net_connect_data_t *connect_data)
     {
         NET_SV_Init();
         NET_SV_AddModule(&net_loop_server_module);
-        NET_SV_AddModule(&net_sdl_module);
+        NET_SV_AddModule(NET_UDP_Requested() ? &net_udp_module
+                                             : &net_sdl_module);
         NET_SV_RegisterWithMaster();
 
         net_loop_client_module.InitClient();
@@ -49,6 +49,7 @@
 #include "m_config.h"
 #include "m_controls.h"
 #include "m_misc.h"
+#include "m_profile.h"
 #include "m_menu.h"
 #include "p_saveg.h"
 
@@ -200,7 +201,9 @@ boolean D_Display (void)
         }
         
         fullscreen = viewheight == SCREENHEIGHT;
+        M_ProfileStart(PROF_HUD);
         ST_Drawer(fullscreen, redrawsbar);
+        M_ProfileStop(PROF_HUD);
         break;
       case GS_INTERMISSION:
         WI_Drawer();
@@ -221,7 +224,9 @@ boolean D_Display (void)
 
     if (gamestate == GS_LEVEL && gametic)
     {
+        M_ProfileStart(PROF_HUD);
         HU_Drawer();
+        M_ProfileStop(PROF_HUD);
     }
     
     // clean up border stuff
@@ -411,7 +416,10 @@ void D_RunFrame()
         wipestart = nowtime;
         wipe = !wipe_ScreenWipe(wipe_Melt, 0, 0, SCREENWIDTH, SCREENHEIGHT, tics);
         M_Drawer();                            // menu is drawn even on top of wipes
+        M_ProfileStart(PROF_UPDATE);
         I_FinishUpdate();                      // page flip or blit buffer
+        M_ProfileStop(PROF_UPDATE);
+        M_ProfileEndFrame(gametic);
         return;
     }
 
@@ -430,9 +438,13 @@ void D_RunFrame()
         } else {
             // normal update
             // page flip or blit buffer
+            M_ProfileStart(PROF_UPDATE);
             I_FinishUpdate();              
+            M_ProfileStop(PROF_UPDATE);
         }
     }
+
+    M_ProfileEndFrame(gametic);
 }
 
 //
@@ -1776,6 +1788,8 @@ void D_DoomMain (void)
     DEH_printf("S_Init: Setting up sound.\n");
     S_Init (sfxVolume * 8, musicVolume * 8);
 
+    I_CheckRenderMusic();
+
     DEH_printf("D_CheckNetGame: Checking network game status.\n");
     D_CheckNetGame();
 
@@ -1793,6 +1807,8 @@ void D_DoomMain (void)
     if (gamemode == commercial && W_CheckNumForName("map01") < 0)
         storedemo = true;
 
+    M_InitProfile();
+
     if (M_CheckParmWithArgs("-statdump", 1))
     {
         I_AtExit(StatDump, true);
@@ -27,6 +27,7 @@
 #include "m_argv.h"
 #include "m_controls.h"
 #include "m_misc.h"
+#include "m_profile.h"
 #include "m_menu.h"
 #include "m_random.h"
 #include "i_system.h"
@@ -930,7 +931,9 @@ void G_Ticker (void)
     switch (gamestate) 
     { 
       case GS_LEVEL: 
+        M_ProfileStart(PROF_TICKER);
         P_Ticker (); 
+        M_ProfileStop(PROF_TICKER);
         ST_Ticker (); 
         AM_Ticker (); 
         HU_Ticker ();            
@@ -1503,9 +1506,7 @@ void G_DoLoadGame (void)
          
     gameaction = ga_nothing; 
          
-    save_stream = M_fopen(savename, "rb");
-
-    if (save_stream == NULL)
+    if (!P_ReadSaveGameFile(savename))
     {
         I_Error("Could not load savegame %s", savename);
     }
@@ -1514,7 +1515,7 @@ void G_DoLoadGame (void)
 
     if (!P_ReadSaveGameHeader())
     {
-        fclose(save_stream);
+        P_CloseSaveGame();
         return;
     }
 
@@ -1534,7 +1535,7 @@ void G_DoLoadGame (void)
     if (!P_ReadSaveGameEOF())
         I_Error ("Bad savegame");
 
-    fclose(save_stream);
+    P_CloseSaveGame();
     
     if (setsizeneeded)
         R_ExecuteSetViewSize ();
@@ -1565,31 +1566,19 @@ void G_DoSaveGame (void)
     char *temp_savegame_file;
     char *recovery_savegame_file;
 
+    FILE *save_stream;
+
     recovery_savegame_file = NULL;
     temp_savegame_file = P_TempSaveGameFile();
     savegame_file = P_SaveGameFile(savegameslot);
 
-    // Open the savegame file for writing.  We write to a temporary file
-    // and then rename it at the end if it was successfully written.
-    // This prevents an existing savegame from being overwritten by
-    // a corrupted one, or if a savegame buffer overrun occurs.
-    save_stream = M_fopen(temp_savegame_file, "wb");
-
-    if (save_stream == NULL)
-    {
-        // Failed to save the game, so we're going to have to abort. But
-        // to be nice, save to somewhere else before we call I_Error().
-        recovery_savegame_file = M_TempFile("recovery.dsg");
-        save_stream = M_fopen(recovery_savegame_file, "wb");
-        if (save_stream == NULL)
-        {
-            I_Error("Failed to open either '%s' or '%s' to write savegame.",
-                    temp_savegame_file, recovery_savegame_file);
-        }
-    }
+    // Serialize the game into memory first; it is written to disk in
+    // one go below.
 
     savegame_error = false;
 
+    P_StartSaveGame();
+
     P_WriteSaveGameHeader(savedescription);
 
     P_ArchivePlayers ();
@@ -1602,30 +1591,49 @@ void G_DoSaveGame (void)
     // Enforce the same savegame size limit as in Vanilla Doom,
     // except if the vanilla_savegame_limit setting is turned off.
 
-    if (vanilla_savegame_limit && ftell(save_stream) > SAVEGAMESIZE)
+    if (vanilla_savegame_limit && P_SaveGameLength() > SAVEGAMESIZE)
     {
         I_Error("Savegame buffer overrun");
     }
 
-    // Finish up, close the savegame file.
+    // A previous savegame may still be on its way to the temporary
+    // file.
 
-    fclose(save_stream);
+    P_WaitSaveGame();
 
-    if (recovery_savegame_file != NULL)
+    // Open the savegame file for writing.  We write to a temporary file
+    // and then rename it at the end if it was successfully written.
+    // This prevents an existing savegame from being overwritten by
+    // a corrupted one, or if a savegame buffer overrun occurs.
+    save_stream = M_fopen(temp_savegame_file, "wb");
+
+    if (save_stream == NULL)
     {
-        // We failed to save to the normal location, but we wrote a
-        // recovery file to the temp directory. Now we can bomb out
-        // with an error.
+        // Failed to save the game, so we're going to have to abort. But
+        // to be nice, save to somewhere else before we call I_Error().
+        recovery_savegame_file = M_TempFile("recovery.dsg");
+        save_stream = M_fopen(recovery_savegame_file, "wb");
+        if (save_stream == NULL)
+        {
+            I_Error("Failed to open either '%s' or '%s' to write savegame.",
+                    temp_savegame_file, recovery_savegame_file);
+        }
+
+        // We failed to save to the normal location, but we can write a
+        // recovery file to the temp directory. Then we bomb out with
+        // an error.
+        P_WriteSaveGame(save_stream, NULL, NULL);
+
         I_Error("Failed to open savegame file '%s' for writing.\n"
                 "But your game has been saved to '%s' for recovery.",
                 temp_savegame_file, recovery_savegame_file);
     }
 
-    // Now rename the temporary savegame file to the actual savegame
-    // file, overwriting the old savegame if there was one there.
+    // Write the file out, then rename the temporary savegame file to
+    // the actual savegame file, overwriting the old savegame if there
+    // was one there.
 
-    M_remove(savegame_file);
-    M_rename(temp_savegame_file, savegame_file);
+    P_WriteSaveGame(save_stream, temp_savegame_file, savegame_file);
 
     gameaction = ga_nothing;
     M_StringCopy(savedescription, "", sizeof(savedescription));
@@ -2231,6 +2239,16 @@ boolean G_CheckDemoStatus (void)
         timingdemo = false;
         demoplayback = false;
 
+        // When profiling, the timedemo is the benchmark run rather
+        // than a failure: report the result and exit normally so that
+        // the profile is written and the exit status is zero.
+        if (profiling)
+        {
+            printf("timed %i gametics in %i realtics (%f fps)\n",
+                   gametic, realtics, fps);
+            I_Quit();
+        }
+
         I_Error ("timed %i gametics in %i realtics (%f fps)",
                  gametic, realtics, fps);
     } 
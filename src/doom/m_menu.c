@@ -474,6 +474,9 @@ void M_ReadSaveStrings(void)
     char name[256];
     size_t return_value;
 
+    // Don't look at the files while a savegame is still being written.
+    P_WaitSaveGame();
+
     for (int i = 0;i < load_end;i++)
     {
         return_value = 0;
@@ -64,7 +64,7 @@ void P_SpawnFireFlicker (sector_t*	sector)
     // Nothing special about it during gameplay.
     sector->special = 0; 
 	
-    flick = Z_Malloc ( sizeof(*flick), PU_LEVSPEC, 0);
+    flick = P_AllocThinker (sizeof(*flick));
 
     P_AddThinker (&flick->thinker);
 
@@ -119,7 +119,7 @@ void P_SpawnLightFlash (sector_t*	sector)
     // nothing special about it during gameplay
     sector->special = 0;	
 	
-    flash = Z_Malloc ( sizeof(*flash), PU_LEVSPEC, 0);
+    flash = P_AllocThinker (sizeof(*flash));
 
     P_AddThinker (&flash->thinker);
 
@@ -176,7 +176,7 @@ P_SpawnStrobeFlash
 {
     strobe_t*	flash;
 	
-    flash = Z_Malloc ( sizeof(*flash), PU_LEVSPEC, 0);
+    flash = P_AllocThinker (sizeof(*flash));
 
     P_AddThinker (&flash->thinker);
 
@@ -233,24 +233,22 @@ void EV_TurnTagLightsOff(line_t* line)
     sector_t*		tsec;
     line_t*		templine;
 	
-    sector = sectors;
-    
-    for (j = 0;j < numsectors; j++, sector++)
+    j = -1;
+
+    while ((j = P_FindSectorFromLineTag(line, j)) >= 0)
     {
-	if (sector->tag == line->tag)
+	sector = &sectors[j];
+	min = sector->lightlevel;
+	for (i = 0;i < sector->linecount; i++)
 	{
-	    min = sector->lightlevel;
-	    for (i = 0;i < sector->linecount; i++)
-	    {
-		templine = sector->lines[i];
-		tsec = getNextSector(templine,sector);
-		if (!tsec)
-		    continue;
-		if (tsec->lightlevel < min)
-		    min = tsec->lightlevel;
-	    }
-	    sector->lightlevel = min;
+	    templine = sector->lines[i];
+	    tsec = getNextSector(templine,sector);
+	    if (!tsec)
+		continue;
+	    if (tsec->lightlevel < min)
+		min = tsec->lightlevel;
 	}
+	sector->lightlevel = min;
     }
 }
 
@@ -269,31 +267,29 @@ EV_LightTurnOn
     sector_t*	temp;
     line_t*	templine;
 	
-    sector = sectors;
-	
-    for (i=0;i<numsectors;i++, sector++)
+    i = -1;
+
+    while ((i = P_FindSectorFromLineTag(line, i)) >= 0)
     {
-	if (sector->tag == line->tag)
+	sector = &sectors[i];
+	// bright = 0 means to search
+	// for highest light level
+	// surrounding sector
+	if (!bright)
 	{
-	    // bright = 0 means to search
-	    // for highest light level
-	    // surrounding sector
-	    if (!bright)
+	    for (j = 0;j < sector->linecount; j++)
 	    {
-		for (j = 0;j < sector->linecount; j++)
-		{
-		    templine = sector->lines[j];
-		    temp = getNextSector(templine,sector);
+		templine = sector->lines[j];
+		temp = getNextSector(templine,sector);
 
-		    if (!temp)
-			continue;
+		if (!temp)
+		    continue;
 
-		    if (temp->lightlevel > bright)
-			bright = temp->lightlevel;
-		}
+		if (temp->lightlevel > bright)
+		    bright = temp->lightlevel;
 	    }
-	    sector-> lightlevel = bright;
 	}
+	sector-> lightlevel = bright;
     }
 }
 
@@ -333,7 +329,7 @@ void P_SpawnGlowingLight(sector_t*	sector)
 {
     glow_t*	g;
 	
-    g = Z_Malloc( sizeof(*g), PU_LEVSPEC, 0);
+    g = P_AllocThinker (sizeof(*g));
 
     P_AddThinker(&g->thinker);
 
@@ -68,6 +68,8 @@ extern	thinker_t	thinkercap;
 
 
 void P_InitThinkers (void);
+void* P_AllocThinker (int size);
+void P_FreeThinker (thinker_t* thinker);
 void P_AddThinker (thinker_t* thinker);
 void P_RemoveThinker (thinker_t* thinker);
 
@@ -227,6 +229,8 @@ boolean P_TryMove (mobj_t* thing, fixed_t x, fixed_t y);
 boolean P_TeleportMove (mobj_t* thing, fixed_t x, fixed_t y);
 void	P_SlideMove (mobj_t* mo);
 boolean P_CheckSight (mobj_t* t1, mobj_t* t2);
+void	P_ClearSightCache (void);
+void	P_InitSight (void);
 void 	P_UseLines (player_t* player);
 
 boolean P_ChangeSector (sector_t* sector, boolean crunch);
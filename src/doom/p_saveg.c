@@ -23,6 +23,8 @@
 #include "dstrings.h"
 #include "deh_main.h"
 #include "i_system.h"
+#include "i_thread.h"
+#include "m_argv.h"
 #include "z_zone.h"
 #include "p_local.h"
 #include "p_saveg.h"
@@ -33,10 +35,31 @@
 #include "m_misc.h"
 #include "r_state.h"
 
-FILE *save_stream;
 int savegamelength;
 boolean savegame_error;
 
+// The savegame is serialized to and from this buffer rather than
+// going through stdio a byte at a time; the file is then read or
+// written in one go.
+
+static byte *save_buffer = NULL;
+static size_t save_buffer_size;
+static size_t save_length;
+static size_t save_pos;
+
+// Background thread writing out the last savegame, if any.
+
+typedef struct
+{
+    FILE *stream;
+    byte *data;
+    size_t length;
+    char *temp_file;
+    char *savegame_file;
+} saveflush_t;
+
+static ithread_t *flush_thread = NULL;
+
 // Get the filename of a temporary file to write the savegame to.  After
 // the file has been successfully saved, it will be renamed to the 
 // real file.
@@ -73,13 +96,169 @@ char *P_SaveGameFile(int slot)
     return filename;
 }
 
+// Wait for a savegame being written in the background to reach the
+// disk.
+
+void P_WaitSaveGame(void)
+{
+    if (flush_thread != NULL)
+    {
+        I_WaitThread(flush_thread);
+        flush_thread = NULL;
+    }
+}
+
+// Read a whole savegame file into the buffer.  Returns false if the
+// file could not be opened.
+
+boolean P_ReadSaveGameFile(char *filename)
+{
+    FILE *stream;
+    long length;
+
+    P_WaitSaveGame();
+
+    stream = M_fopen(filename, "rb");
+
+    if (stream == NULL)
+    {
+        return false;
+    }
+
+    length = M_FileLength(stream);
+
+    free(save_buffer);
+    save_buffer = I_Realloc(NULL, length > 0 ? length : 1);
+    save_buffer_size = length > 0 ? length : 1;
+    save_length = fread(save_buffer, 1, length, stream);
+    save_pos = 0;
+
+    fclose(stream);
+
+    return true;
+}
+
+// Start serializing a new savegame into the buffer.
+
+void P_StartSaveGame(void)
+{
+    free(save_buffer);
+    save_buffer_size = SAVEGAMEBUFFERSIZE;
+    save_buffer = I_Realloc(NULL, save_buffer_size);
+    save_pos = 0;
+}
+
+// Number of bytes read or written so far.
+
+size_t P_SaveGameLength(void)
+{
+    return save_pos;
+}
+
+// Release the savegame buffer after loading.
+
+void P_CloseSaveGame(void)
+{
+    free(save_buffer);
+    save_buffer = NULL;
+    save_length = 0;
+    save_pos = 0;
+}
+
+static void FlushSaveGame(void *data)
+{
+    saveflush_t *flush = data;
+    boolean written;
+
+    written = fwrite(flush->data, 1, flush->length, flush->stream)
+           == flush->length;
+
+    if (fclose(flush->stream) != 0)
+    {
+        written = false;
+    }
+
+    if (!written)
+    {
+        fprintf(stderr, "FlushSaveGame: Error while writing save game\n");
+    }
+    else if (flush->temp_file != NULL)
+    {
+        // Now rename the temporary savegame file to the actual savegame
+        // file, overwriting the old savegame if there was one there.
+
+        M_remove(flush->savegame_file);
+        M_rename(flush->temp_file, flush->savegame_file);
+    }
+
+    free(flush->data);
+    free(flush->temp_file);
+    free(flush->savegame_file);
+    free(flush);
+}
+
+// Write the savegame buffer to stream with a single write and close
+// it.  If temp_file is not NULL it is then renamed to savegame_file.
+// With -asyncsave this is done by a background thread so that the
+// game does not stall on the disk.
+
+void P_WriteSaveGame(FILE *stream, char *temp_file, char *savegame_file)
+{
+    static boolean asyncsave_checked = false, asyncsave;
+    saveflush_t *flush;
+
+    if (!asyncsave_checked)
+    {
+        //!
+        // @category game
+        //
+        // Write savegames to disk in a background thread.
+        //
+
+        asyncsave = M_ParmExists("-asyncsave");
+        asyncsave_checked = true;
+
+        if (asyncsave)
+        {
+            I_AtExit(P_WaitSaveGame, true);
+        }
+    }
+
+    // The buffer now belongs to the flush.
+
+    flush = malloc(sizeof(saveflush_t));
+    flush->stream = stream;
+    flush->data = save_buffer;
+    flush->length = save_pos;
+    flush->temp_file = NULL;
+    flush->savegame_file = NULL;
+
+    if (temp_file != NULL)
+    {
+        flush->temp_file = M_StringDuplicate(temp_file);
+        flush->savegame_file = M_StringDuplicate(savegame_file);
+    }
+
+    save_buffer = NULL;
+    save_pos = 0;
+
+    P_WaitSaveGame();
+
+    if (asyncsave && temp_file != NULL)
+    {
+        flush_thread = I_StartThread(FlushSaveGame, flush, "SaveGame");
+    }
+    else
+    {
+        FlushSaveGame(flush);
+    }
+}
+
 // Endian-safe integer read/write functions
 
 static byte saveg_read8(void)
 {
-    byte result = -1;
-
-    if (fread(&result, 1, 1, save_stream) < 1)
+    if (save_pos >= save_length)
     {
         if (!savegame_error)
         {
@@ -88,22 +267,22 @@ static byte saveg_read8(void)
 
             savegame_error = true;
         }
+
+        return -1;
     }
 
-    return result;
+    return save_buffer[save_pos++];
 }
 
 static void saveg_write8(byte value)
 {
-    if (fwrite(&value, 1, 1, save_stream) < 1)
+    if (save_pos >= save_buffer_size)
     {
-        if (!savegame_error)
-        {
-            fprintf(stderr, "saveg_write8: Error while writing save game\n");
-
-            savegame_error = true;
-        }
+        save_buffer_size *= 2;
+        save_buffer = I_Realloc(save_buffer, save_buffer_size);
     }
+
+    save_buffer[save_pos++] = value;
 }
 
 static short saveg_read16(void)
@@ -150,7 +329,7 @@ static void saveg_read_pad(void)
     int padding;
     int i;
 
-    pos = ftell(save_stream);
+    pos = save_pos;
 
     padding = (4 - (pos & 3)) & 3;
 
@@ -166,7 +345,7 @@ static void saveg_write_pad(void)
     int padding;
     int i;
 
-    pos = ftell(save_stream);
+    pos = save_pos;
 
     padding = (4 - (pos & 3)) & 3;
 
@@ -1621,7 +1800,9 @@ void P_UnArchiveThinkers (void)
     thinker_t*		next;
     mobj_t*		mobj;
     
-    // remove all the current thinkers
+    // remove all the current thinkers; their memory is not freed one
+    // by one, as P_InitThinkers starts the pools over and the old
+    // slabs go with the level
     currentthinker = thinkercap.next;
     while (currentthinker != &thinkercap)
     {
@@ -1629,8 +1810,6 @@ void P_UnArchiveThinkers (void)
 	
 	if (currentthinker->function.acp1 == (actionf_p1)P_MobjThinker)
 	    P_RemoveMobj ((mobj_t *)currentthinker);
-	else
-	    Z_Free (currentthinker);
 
 	currentthinker = next;
     }
@@ -1647,7 +1826,7 @@ void P_UnArchiveThinkers (void)
 			
 	  case tc_mobj:
 	    saveg_read_pad();
-	    mobj = Z_Malloc (sizeof(*mobj), PU_LEVEL, NULL);
+	    mobj = P_AllocThinker (sizeof(*mobj));
             saveg_read_mobj_t(mobj);
 
 	    mobj->target = NULL;
@@ -1811,7 +1990,7 @@ void P_UnArchiveSpecials (void)
 			
 	  case tc_ceiling:
 	    saveg_read_pad();
-	    ceiling = Z_Malloc (sizeof(*ceiling), PU_LEVEL, NULL);
+	    ceiling = P_AllocThinker (sizeof(*ceiling));
             saveg_read_ceiling_t(ceiling);
 	    ceiling->sector->specialdata = ceiling;
 
@@ -1824,7 +2003,7 @@ void P_UnArchiveSpecials (void)
 				
 	  case tc_door:
 	    saveg_read_pad();
-	    door = Z_Malloc (sizeof(*door), PU_LEVEL, NULL);
+	    door = P_AllocThinker (sizeof(*door));
             saveg_read_vldoor_t(door);
 	    door->sector->specialdata = door;
 	    door->thinker.function.acp1 = (actionf_p1)T_VerticalDoor;
@@ -1833,7 +2012,7 @@ void P_UnArchiveSpecials (void)
 				
 	  case tc_floor:
 	    saveg_read_pad();
-	    floor = Z_Malloc (sizeof(*floor), PU_LEVEL, NULL);
+	    floor = P_AllocThinker (sizeof(*floor));
             saveg_read_floormove_t(floor);
 	    floor->sector->specialdata = floor;
 	    floor->thinker.function.acp1 = (actionf_p1)T_MoveFloor;
@@ -1842,7 +2021,7 @@ void P_UnArchiveSpecials (void)
 				
 	  case tc_plat:
 	    saveg_read_pad();
-	    plat = Z_Malloc (sizeof(*plat), PU_LEVEL, NULL);
+	    plat = P_AllocThinker (sizeof(*plat));
             saveg_read_plat_t(plat);
 	    plat->sector->specialdata = plat;
 
@@ -1855,7 +2034,7 @@ void P_UnArchiveSpecials (void)
 				
 	  case tc_flash:
 	    saveg_read_pad();
-	    flash = Z_Malloc (sizeof(*flash), PU_LEVEL, NULL);
+	    flash = P_AllocThinker (sizeof(*flash));
             saveg_read_lightflash_t(flash);
 	    flash->thinker.function.acp1 = (actionf_p1)T_LightFlash;
 	    P_AddThinker (&flash->thinker);
@@ -1863,7 +2042,7 @@ void P_UnArchiveSpecials (void)
 				
 	  case tc_strobe:
 	    saveg_read_pad();
-	    strobe = Z_Malloc (sizeof(*strobe), PU_LEVEL, NULL);
+	    strobe = P_AllocThinker (sizeof(*strobe));
             saveg_read_strobe_t(strobe);
 	    strobe->thinker.function.acp1 = (actionf_p1)T_StrobeFlash;
 	    P_AddThinker (&strobe->thinker);
@@ -1871,7 +2050,7 @@ void P_UnArchiveSpecials (void)
 				
 	  case tc_glow:
 	    saveg_read_pad();
-	    glow = Z_Malloc (sizeof(*glow), PU_LEVEL, NULL);
+	    glow = P_AllocThinker (sizeof(*glow));
             saveg_read_glow_t(glow);
 	    glow->thinker.function.acp1 = (actionf_p1)T_Glow;
 	    P_AddThinker (&glow->thinker);
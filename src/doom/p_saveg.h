@@ -37,6 +37,25 @@ char *P_TempSaveGameFile(void);
 
 char *P_SaveGameFile(int slot);
 
+// initial size of the buffer savegames are serialized into
+
+#define SAVEGAMEBUFFERSIZE 0x2c000
+
+// Savegames are serialized to and from memory.  P_ReadSaveGameFile
+// loads a whole file for the P_UnArchive* functions; P_StartSaveGame
+// begins a buffer for the P_Archive* functions which P_WriteSaveGame
+// then writes out (and renames into place) with a single write.
+
+boolean P_ReadSaveGameFile(char *filename);
+void P_CloseSaveGame(void);
+void P_StartSaveGame(void);
+size_t P_SaveGameLength(void);
+void P_WriteSaveGame(FILE *stream, char *temp_file, char *savegame_file);
+
+// Wait for a savegame being written by -asyncsave to finish.
+
+void P_WaitSaveGame(void);
+
 // Savegame file header read/write functions
 
 boolean P_ReadSaveGameHeader(void);
@@ -58,7 +77,6 @@ void P_UnArchiveThinkers (void);
 void P_ArchiveSpecials (void);
 void P_UnArchiveSpecials (void);
 
-extern FILE *save_stream;
 extern boolean savegame_error;
 
 
@@ -18,16 +18,24 @@
 //
 
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include "z_zone.h"
 
 #include "deh_main.h"
 #include "i_swap.h"
 #include "m_argv.h"
 #include "m_bbox.h"
+#include "m_misc.h"
+#include "sha1.h"
 
 #include "g_game.h"
 
 #include "i_system.h"
+#include "w_checksum.h"
+#include "w_file.h"
 #include "w_wad.h"
 
 #include "doomdef.h"
@@ -68,6 +76,9 @@ side_t*		sides;
 
 static int      totallines;
 
+// Sector line lists, built by P_GroupLines.
+static line_t**	linebuffer;
+
 // BLOCKMAP
 // Created from axis aligned bounding box
 // of the map, a rectangular array of
@@ -81,6 +92,7 @@ int		bmapheight;	// size in mapblocks
 short*		blockmap;	// int for larger maps
 // offsets in blockmap are from here
 short*		blockmaplump;		
+static int	blockmapcount;	// shorts in blockmaplump
 // origin of block map
 fixed_t		bmaporgx;
 fixed_t		bmaporgy;
@@ -517,28 +529,15 @@ void P_LoadSideDefs (int lump)
 
 
 //
-// P_LoadBlockMap
+// P_SetupBlockMap
+// Reads the header of blockmaplump and clears the mobj chains.
 //
-void P_LoadBlockMap (int lump)
+static void P_SetupBlockMap (void)
 {
-    int i;
     int count;
-    int lumplen;
 
-    lumplen = W_LumpLength(lump);
-    count = lumplen / 2;
-	
-    blockmaplump = Z_Malloc(lumplen, PU_LEVEL, NULL);
-    W_ReadLump(lump, blockmaplump);
     blockmap = blockmaplump + 4;
 
-    // Swap all short integers to native byte ordering.
-  
-    for (i=0; i<count; i++)
-    {
-	blockmaplump[i] = SHORT(blockmaplump[i]);
-    }
-		
     // Read the header
 
     bmaporgx = blockmaplump[0]<<FRACBITS;
@@ -553,6 +552,30 @@ void P_LoadBlockMap (int lump)
     memset(blocklinks, 0, count);
 }
 
+//
+// P_LoadBlockMap
+//
+void P_LoadBlockMap (int lump)
+{
+    int i;
+    int lumplen;
+
+    lumplen = W_LumpLength(lump);
+    blockmapcount = lumplen / 2;
+	
+    blockmaplump = Z_Malloc(lumplen, PU_LEVEL, NULL);
+    W_ReadLump(lump, blockmaplump);
+
+    // Swap all short integers to native byte ordering.
+  
+    for (i=0; i<blockmapcount; i++)
+    {
+	blockmaplump[i] = SHORT(blockmaplump[i]);
+    }
+
+    P_SetupBlockMap ();
+}
+
 
 
 //
@@ -562,7 +585,7 @@ void P_LoadBlockMap (int lump)
 //
 void P_GroupLines (void)
 {
-    line_t**		linebuffer;
+    line_t**		buffer;
     int			i;
     int			j;
     line_t*		li;
@@ -597,13 +620,14 @@ void P_GroupLines (void)
 
     // build line tables for each sector	
     linebuffer = Z_Malloc (totallines*sizeof(line_t *), PU_LEVEL, 0);
+    buffer = linebuffer;
 
     for (i=0; i<numsectors; ++i)
     {
         // Assign the line buffer for this sector
 
-        sectors[i].lines = linebuffer;
-        linebuffer += sectors[i].linecount;
+        sectors[i].lines = buffer;
+        buffer += sectors[i].linecount;
 
         // Reset linecount to zero so in the next stage we can count
         // lines into the list.
@@ -757,6 +781,678 @@ static void P_LoadReject(int lumpnum)
     }
 }
 
+//
+// LEVEL CACHE
+// With -levelcache, the level structures built by the P_Load*
+//  functions and P_GroupLines are kept as a relocatable image, keyed
+//  on a hash of the map lumps and the WAD directory.  Pointers in the
+//  image are stored as array indices.  Images are written to the
+//  cache directory and kept in memory, outside the zone, up to
+//  MAXLEVELIMAGEBYTES, so that loading the same map again only has
+//  to copy and relocate them.
+//
+
+#define LEVELCACHE_ID		"LVLCACHE"
+#define LEVELCACHE_VERSION	2
+#define LEVELCACHE_BYTEORDER	0x01020304
+
+#define MAXLEVELIMAGEBYTES	(32 * 1024 * 1024)
+
+typedef struct
+{
+    char		id[8];
+    int			version;
+    int			byteorder;
+    int			pointersize;
+    sha1_digest_t	key;
+
+    int			numvertexes;
+    int			numsectors;
+    int			numsides;
+    int			numlines;
+    int			numsubsectors;
+    int			numnodes;
+    int			numsegs;
+    int			totallines;
+    int			blockmapcount;
+} levelcacheheader_t;
+
+enum
+{
+    LC_VERTEXES,
+    LC_SECTORS,
+    LC_SIDES,
+    LC_LINES,
+    LC_SUBSECTORS,
+    LC_NODES,
+    LC_SEGS,
+    LC_LINEBUFFER,	// int[totallines], line numbers
+    LC_BLOCKMAP,	// short[blockmapcount], native byte order
+    NUMLCSECTIONS
+};
+
+// Pointer fields hold an index; -1 is NULL and -2 the sector
+//  returned by GetSectorAtNullAddress.
+#define LC_ENCODE(i)	((void *) (intptr_t) (i))
+#define LC_INDEX(p)	((int) (intptr_t) (p))
+
+#define LC_ALIGN(x)	(((x) + 7) & ~7)
+
+typedef struct levelimage_s
+{
+    sha1_digest_t	key;
+    byte*		data;
+    unsigned int	length;
+    wad_file_t*		file;	// if the image is a mapped file
+    struct levelimage_s*	next;
+} levelimage_t;
+
+static const char*	levelcachedir = NULL;
+static sha1_digest_t	wadchecksum;
+
+// Oldest first.
+static levelimage_t*	levelimages = NULL;
+static levelimage_t*	lastlevelimage = NULL;
+static unsigned int	levelimagebytes;
+
+
+//
+// P_LevelImageLayout
+// Fills in the offset of each section and returns the image length,
+//  or 0 if the counts are not sane.
+//
+static unsigned int
+P_LevelImageLayout
+( levelcacheheader_t*	header,
+  unsigned int*		ofs )
+{
+    int			counts[NUMLCSECTIONS];
+    static const int	sizes[NUMLCSECTIONS] =
+    {
+	sizeof(vertex_t), sizeof(sector_t), sizeof(side_t),
+	sizeof(line_t), sizeof(subsector_t), sizeof(node_t),
+	sizeof(seg_t), sizeof(int), sizeof(short)
+    };
+    unsigned int	length;
+    int			i;
+
+    counts[LC_VERTEXES] = header->numvertexes;
+    counts[LC_SECTORS] = header->numsectors;
+    counts[LC_SIDES] = header->numsides;
+    counts[LC_LINES] = header->numlines;
+    counts[LC_SUBSECTORS] = header->numsubsectors;
+    counts[LC_NODES] = header->numnodes;
+    counts[LC_SEGS] = header->numsegs;
+    counts[LC_LINEBUFFER] = header->totallines;
+    counts[LC_BLOCKMAP] = header->blockmapcount;
+
+    length = LC_ALIGN(sizeof(*header));
+
+    for (i=0 ; i<NUMLCSECTIONS ; i++)
+    {
+	if (counts[i] < 0 || counts[i] > 0x100000)
+	    return 0;
+
+	ofs[i] = length;
+	length += LC_ALIGN(counts[i] * sizes[i]);
+    }
+
+    return length;
+}
+
+
+//
+// P_CheckLevelImage
+// Checks the header and that every index in the image is in range.
+//
+static boolean
+P_CheckLevelImage
+( byte*		data,
+  unsigned int	length,
+  sha1_digest_t	key )
+{
+    levelcacheheader_t*	header;
+    unsigned int	ofs[NUMLCSECTIONS];
+    sector_t*		sector;
+    side_t*		side;
+    line_t*		line;
+    subsector_t*	ss;
+    seg_t*		seg;
+    int*		lineindex;
+    int			nsectors;
+    int			nvertexes;
+    int			i;
+
+    header = (levelcacheheader_t *) data;
+
+    if (length < sizeof(*header)
+     || memcmp (header->id, LEVELCACHE_ID, sizeof(header->id)) != 0
+     || header->version != LEVELCACHE_VERSION
+     || header->byteorder != LEVELCACHE_BYTEORDER
+     || header->pointersize != sizeof(void *)
+     || memcmp (header->key, key, sizeof(sha1_digest_t)) != 0
+     || P_LevelImageLayout (header, ofs) != length
+     || header->blockmapcount < 4)
+    {
+	return false;
+    }
+
+    nsectors = header->numsectors;
+    nvertexes = header->numvertexes;
+
+#define CHECK(i, min, max) \
+    if ((i) < (min) || (i) >= (max)) return false
+
+    sector = (sector_t *) (data + ofs[LC_SECTORS]);
+    for (i=0 ; i<nsectors ; i++, sector++)
+    {
+	CHECK (sector->linecount, 0, header->totallines + 1);
+	CHECK (LC_INDEX(sector->lines), 0,
+	       header->totallines - sector->linecount + 1);
+    }
+
+    side = (side_t *) (data + ofs[LC_SIDES]);
+    for (i=0 ; i<header->numsides ; i++, side++)
+    {
+	CHECK (LC_INDEX(side->sector), 0, nsectors);
+    }
+
+    line = (line_t *) (data + ofs[LC_LINES]);
+    for (i=0 ; i<header->numlines ; i++, line++)
+    {
+	CHECK (LC_INDEX(line->v1), 0, nvertexes);
+	CHECK (LC_INDEX(line->v2), 0, nvertexes);
+	CHECK (LC_INDEX(line->frontsector), -1, nsectors);
+	CHECK (LC_INDEX(line->backsector), -1, nsectors);
+    }
+
+    ss = (subsector_t *) (data + ofs[LC_SUBSECTORS]);
+    for (i=0 ; i<header->numsubsectors ; i++, ss++)
+    {
+	CHECK (LC_INDEX(ss->sector), 0, nsectors);
+    }
+
+    seg = (seg_t *) (data + ofs[LC_SEGS]);
+    for (i=0 ; i<header->numsegs ; i++, seg++)
+    {
+	CHECK (LC_INDEX(seg->v1), 0, nvertexes);
+	CHECK (LC_INDEX(seg->v2), 0, nvertexes);
+	CHECK (LC_INDEX(seg->sidedef), 0, header->numsides);
+	CHECK (LC_INDEX(seg->linedef), 0, header->numlines);
+	CHECK (LC_INDEX(seg->frontsector), 0, nsectors);
+	CHECK (LC_INDEX(seg->backsector), -2, nsectors);
+    }
+
+    lineindex = (int *) (data + ofs[LC_LINEBUFFER]);
+    for (i=0 ; i<header->totallines ; i++)
+    {
+	CHECK (lineindex[i], 0, header->numlines);
+    }
+
+#undef CHECK
+
+    return true;
+}
+
+
+static void *P_EncodeSector (sector_t *sector)
+{
+    if (sector == NULL)
+	return LC_ENCODE(-1);
+    else if (sector == GetSectorAtNullAddress ())
+	return LC_ENCODE(-2);
+    else
+	return LC_ENCODE(sector - sectors);
+}
+
+static sector_t *P_DecodeSector (void *p)
+{
+    int		i = LC_INDEX(p);
+
+    if (i == -1)
+	return NULL;
+    else if (i == -2)
+	return GetSectorAtNullAddress ();
+    else
+	return &sectors[i];
+}
+
+
+//
+// P_LevelCachePath
+//
+static char *P_LevelCachePath (sha1_digest_t key)
+{
+    char	name[sizeof(sha1_digest_t) * 2 + 1];
+    int		i;
+
+    for (i=0 ; i<sizeof(sha1_digest_t) ; i++)
+	M_snprintf (name + i * 2, 3, "%02x", key[i]);
+
+    return M_StringJoin (levelcachedir, DIR_SEPARATOR_S, name, ".lvl", NULL);
+}
+
+
+//
+// P_AddLevelImage
+// Keeps an image for later loads, dropping the oldest ones to stay
+//  within MAXLEVELIMAGEBYTES.  The new image is always kept, as the
+//  caller is about to use it.
+//
+static void
+P_AddLevelImage
+( sha1_digest_t	key,
+  byte*		data,
+  unsigned int	length,
+  wad_file_t*	file )
+{
+    levelimage_t*	image;
+
+    while (levelimages != NULL
+	   && levelimagebytes + length > MAXLEVELIMAGEBYTES)
+    {
+	image = levelimages;
+	levelimages = image->next;
+	if (levelimages == NULL)
+	    lastlevelimage = NULL;
+
+	levelimagebytes -= image->length;
+
+	if (image->file != NULL)
+	    W_CloseFile (image->file);
+	else
+	    free (image->data);
+
+	free (image);
+    }
+
+    image = malloc (sizeof(*image));
+
+    if (image == NULL)
+	I_Error ("P_AddLevelImage: out of memory");
+
+    memcpy (image->key, key, sizeof(sha1_digest_t));
+    image->data = data;
+    image->length = length;
+    image->file = file;
+    image->next = NULL;
+
+    if (lastlevelimage != NULL)
+	lastlevelimage->next = image;
+    else
+	levelimages = image;
+    lastlevelimage = image;
+
+    levelimagebytes += length;
+}
+
+
+//
+// P_LevelCacheKey
+// Hashes the map lumps that the cached structures are built from,
+//  along with the WAD directory, which determines the texture and
+//  flat numbers, and the sizes of the structures, so that images
+//  from a build with different structures are not picked up.
+//
+static void P_LevelCacheKey (int lumpnum, sha1_digest_t key)
+{
+    static const int	maplumps[] =
+    {
+	ML_LINEDEFS, ML_SIDEDEFS, ML_VERTEXES, ML_SEGS,
+	ML_SSECTORS, ML_NODES, ML_SECTORS, ML_BLOCKMAP
+    };
+    sha1_context_t	context;
+    byte*		data;
+    int			lump;
+    int			i;
+
+    SHA1_Init (&context);
+    SHA1_Update (&context, wadchecksum, sizeof(sha1_digest_t));
+
+    SHA1_UpdateInt32 (&context, sizeof(vertex_t));
+    SHA1_UpdateInt32 (&context, sizeof(sector_t));
+    SHA1_UpdateInt32 (&context, sizeof(side_t));
+    SHA1_UpdateInt32 (&context, sizeof(line_t));
+    SHA1_UpdateInt32 (&context, sizeof(subsector_t));
+    SHA1_UpdateInt32 (&context, sizeof(node_t));
+    SHA1_UpdateInt32 (&context, sizeof(seg_t));
+
+    for (i=0 ; i<arrlen(maplumps) ; i++)
+    {
+	lump = lumpnum + maplumps[i];
+	data = W_CacheLumpNum (lump, PU_STATIC);
+	SHA1_UpdateInt32 (&context, W_LumpLength (lump));
+	SHA1_Update (&context, data, W_LumpLength (lump));
+	W_ReleaseLumpNum (lump);
+    }
+
+    SHA1_Final (key, &context);
+}
+
+
+//
+// P_FindLevelImage
+// Returns the image for the given key from memory or the cache
+//  directory, or NULL if there is none.
+//
+static byte *P_FindLevelImage (sha1_digest_t key)
+{
+    levelimage_t*	image;
+    wad_file_t*		file;
+    byte*		data;
+    unsigned int	length;
+    char*		path;
+
+    for (image = levelimages ; image != NULL ; image = image->next)
+    {
+	if (!memcmp (image->key, key, sizeof(sha1_digest_t)))
+	    return image->data;
+    }
+
+    path = P_LevelCachePath (key);
+    file = W_OpenFile (path);
+    free (path);
+
+    if (file == NULL)
+	return NULL;
+
+    length = file->length;
+
+    if (file->mapped != NULL)
+    {
+	data = file->mapped;
+    }
+    else
+    {
+	data = malloc (length);
+
+	if (data == NULL)
+	{
+	    W_CloseFile (file);
+	    return NULL;
+	}
+
+	length = W_Read (file, 0, data, length);
+    }
+
+    if (!P_CheckLevelImage (data, length, key))
+    {
+	if (file->mapped == NULL)
+	    free (data);
+
+	W_CloseFile (file);
+	return NULL;
+    }
+
+    if (file->mapped == NULL)
+    {
+	W_CloseFile (file);
+	file = NULL;
+    }
+
+    P_AddLevelImage (key, data, length, file);
+
+    return data;
+}
+
+
+//
+// P_LoadLevelCache
+// Sets up the level structures from a cached image.
+//  Returns false if there is none.
+//
+static boolean P_LoadLevelCache (sha1_digest_t key)
+{
+    byte*		data;
+    levelcacheheader_t*	header;
+    unsigned int	ofs[NUMLCSECTIONS];
+    sector_t*		sector;
+    side_t*		side;
+    line_t*		line;
+    subsector_t*	ss;
+    seg_t*		seg;
+    int*		lineindex;
+    int			i;
+
+    data = P_FindLevelImage (key);
+
+    if (data == NULL)
+	return false;
+
+    header = (levelcacheheader_t *) data;
+    P_LevelImageLayout (header, ofs);
+
+    numvertexes = header->numvertexes;
+    numsectors = header->numsectors;
+    numsides = header->numsides;
+    numlines = header->numlines;
+    numsubsectors = header->numsubsectors;
+    numnodes = header->numnodes;
+    numsegs = header->numsegs;
+    totallines = header->totallines;
+    blockmapcount = header->blockmapcount;
+
+    vertexes = Z_Malloc (numvertexes*sizeof(vertex_t), PU_LEVEL, 0);
+    sectors = Z_Malloc (numsectors*sizeof(sector_t), PU_LEVEL, 0);
+    sides = Z_Malloc (numsides*sizeof(side_t), PU_LEVEL, 0);
+    lines = Z_Malloc (numlines*sizeof(line_t), PU_LEVEL, 0);
+    subsectors = Z_Malloc (numsubsectors*sizeof(subsector_t), PU_LEVEL, 0);
+    nodes = Z_Malloc (numnodes*sizeof(node_t), PU_LEVEL, 0);
+    segs = Z_Malloc (numsegs*sizeof(seg_t), PU_LEVEL, 0);
+    linebuffer = Z_Malloc (totallines*sizeof(line_t *), PU_LEVEL, 0);
+    blockmaplump = Z_Malloc (blockmapcount*sizeof(short), PU_LEVEL, NULL);
+
+    memcpy (vertexes, data + ofs[LC_VERTEXES], numvertexes*sizeof(vertex_t));
+    memcpy (sectors, data + ofs[LC_SECTORS], numsectors*sizeof(sector_t));
+    memcpy (sides, data + ofs[LC_SIDES], numsides*sizeof(side_t));
+    memcpy (lines, data + ofs[LC_LINES], numlines*sizeof(line_t));
+    memcpy (subsectors, data + ofs[LC_SUBSECTORS],
+	    numsubsectors*sizeof(subsector_t));
+    memcpy (nodes, data + ofs[LC_NODES], numnodes*sizeof(node_t));
+    memcpy (segs, data + ofs[LC_SEGS], numsegs*sizeof(seg_t));
+    memcpy (blockmaplump, data + ofs[LC_BLOCKMAP],
+	    blockmapcount*sizeof(short));
+
+    // Relocate.
+
+    for (i=0, sector=sectors ; i<numsectors ; i++, sector++)
+	sector->lines = linebuffer + LC_INDEX(sector->lines);
+
+    for (i=0, side=sides ; i<numsides ; i++, side++)
+	side->sector = &sectors[LC_INDEX(side->sector)];
+
+    for (i=0, line=lines ; i<numlines ; i++, line++)
+    {
+	line->v1 = &vertexes[LC_INDEX(line->v1)];
+	line->v2 = &vertexes[LC_INDEX(line->v2)];
+	line->frontsector = P_DecodeSector (line->frontsector);
+	line->backsector = P_DecodeSector (line->backsector);
+    }
+
+    for (i=0, ss=subsectors ; i<numsubsectors ; i++, ss++)
+	ss->sector = &sectors[LC_INDEX(ss->sector)];
+
+    for (i=0, seg=segs ; i<numsegs ; i++, seg++)
+    {
+	seg->v1 = &vertexes[LC_INDEX(seg->v1)];
+	seg->v2 = &vertexes[LC_INDEX(seg->v2)];
+	seg->sidedef = &sides[LC_INDEX(seg->sidedef)];
+	seg->linedef = &lines[LC_INDEX(seg->linedef)];
+	seg->frontsector = P_DecodeSector (seg->frontsector);
+	seg->backsector = P_DecodeSector (seg->backsector);
+    }
+
+    lineindex = (int *) (data + ofs[LC_LINEBUFFER]);
+    for (i=0 ; i<totallines ; i++)
+	linebuffer[i] = &lines[lineindex[i]];
+
+    P_SetupBlockMap ();
+
+    return true;
+}
+
+
+//
+// P_SaveLevelCache
+// Builds an image of the level structures as loaded, keeps it and
+//  writes it to the cache directory.
+//
+static void P_SaveLevelCache (sha1_digest_t key)
+{
+    levelcacheheader_t	header;
+    unsigned int	ofs[NUMLCSECTIONS];
+    unsigned int	length;
+    byte*		data;
+    sector_t*		sector;
+    side_t*		side;
+    line_t*		line;
+    subsector_t*	ss;
+    seg_t*		seg;
+    int*		lineindex;
+    FILE*		stream;
+    char*		path;
+    int			i;
+
+    memset (&header, 0, sizeof(header));
+    memcpy (header.id, LEVELCACHE_ID, sizeof(header.id));
+    header.version = LEVELCACHE_VERSION;
+    header.byteorder = LEVELCACHE_BYTEORDER;
+    header.pointersize = sizeof(void *);
+    memcpy (header.key, key, sizeof(sha1_digest_t));
+    header.numvertexes = numvertexes;
+    header.numsectors = numsectors;
+    header.numsides = numsides;
+    header.numlines = numlines;
+    header.numsubsectors = numsubsectors;
+    header.numnodes = numnodes;
+    header.numsegs = numsegs;
+    header.totallines = totallines;
+    header.blockmapcount = blockmapcount;
+
+    length = P_LevelImageLayout (&header, ofs);
+
+    if (length == 0)
+	return;
+
+    data = calloc (1, length);
+
+    if (data == NULL)
+	return;
+
+    memcpy (data, &header, sizeof(header));
+
+    memcpy (data + ofs[LC_VERTEXES], vertexes, numvertexes*sizeof(vertex_t));
+    memcpy (data + ofs[LC_SECTORS], sectors, numsectors*sizeof(sector_t));
+    memcpy (data + ofs[LC_SIDES], sides, numsides*sizeof(side_t));
+    memcpy (data + ofs[LC_LINES], lines, numlines*sizeof(line_t));
+    memcpy (data + ofs[LC_SUBSECTORS], subsectors,
+	    numsubsectors*sizeof(subsector_t));
+    memcpy (data + ofs[LC_NODES], nodes, numnodes*sizeof(node_t));
+    memcpy (data + ofs[LC_SEGS], segs, numsegs*sizeof(seg_t));
+    memcpy (data + ofs[LC_BLOCKMAP], blockmaplump,
+	    blockmapcount*sizeof(short));
+
+    // Replace pointers with indices.
+
+    sector = (sector_t *) (data + ofs[LC_SECTORS]);
+    for (i=0 ; i<numsectors ; i++, sector++)
+	sector->lines = LC_ENCODE(sectors[i].lines - linebuffer);
+
+    side = (side_t *) (data + ofs[LC_SIDES]);
+    for (i=0 ; i<numsides ; i++, side++)
+	side->sector = LC_ENCODE(sides[i].sector - sectors);
+
+    line = (line_t *) (data + ofs[LC_LINES]);
+    for (i=0 ; i<numlines ; i++, line++)
+    {
+	line->v1 = LC_ENCODE(lines[i].v1 - vertexes);
+	line->v2 = LC_ENCODE(lines[i].v2 - vertexes);
+	line->frontsector = P_EncodeSector (lines[i].frontsector);
+	line->backsector = P_EncodeSector (lines[i].backsector);
+    }
+
+    ss = (subsector_t *) (data + ofs[LC_SUBSECTORS]);
+    for (i=0 ; i<numsubsectors ; i++, ss++)
+	ss->sector = LC_ENCODE(subsectors[i].sector - sectors);
+
+    seg = (seg_t *) (data + ofs[LC_SEGS]);
+    for (i=0 ; i<numsegs ; i++, seg++)
+    {
+	seg->v1 = LC_ENCODE(segs[i].v1 - vertexes);
+	seg->v2 = LC_ENCODE(segs[i].v2 - vertexes);
+	seg->sidedef = LC_ENCODE(segs[i].sidedef - sides);
+	seg->linedef = LC_ENCODE(segs[i].linedef - lines);
+	seg->frontsector = P_EncodeSector (segs[i].frontsector);
+	seg->backsector = P_EncodeSector (segs[i].backsector);
+    }
+
+    lineindex = (int *) (data + ofs[LC_LINEBUFFER]);
+    for (i=0 ; i<totallines ; i++)
+	lineindex[i] = linebuffer[i] - lines;
+
+    // Maps that reference missing sectors or vertices are not cached.
+
+    if (!P_CheckLevelImage (data, length, key))
+    {
+	free (data);
+	return;
+    }
+
+    P_AddLevelImage (key, data, length, NULL);
+
+    path = P_LevelCachePath (key);
+    stream = M_fopen (path, "wb");
+
+    if (stream == NULL)
+    {
+	printf ("P_SetupLevel: failed to open %s for writing.\n", path);
+    }
+    else
+    {
+	fwrite (data, 1, length, stream);
+
+	if (ferror (stream))
+	{
+	    printf ("P_SetupLevel: error writing %s.\n", path);
+	    fclose (stream);
+	    M_remove (path);
+	}
+	else
+	{
+	    fclose (stream);
+	}
+    }
+
+    free (path);
+}
+
+
+//
+// P_InitLevelCache
+//
+static void P_InitLevelCache (void)
+{
+    int		i;
+
+    //!
+    // @arg <directory>
+    // @category obscure
+    //
+    // Keep the level structures of each map that is loaded in the
+    // given directory, so that loading the same map again with the
+    // same WADs only has to relocate them.
+    //
+
+    i = M_CheckParmWithArgs ("-levelcache", 1);
+
+    if (i > 0)
+    {
+	levelcachedir = myargv[i + 1];
+	M_MakeDirectory (levelcachedir);
+	W_Checksum (wadchecksum);
+    }
+}
+
 // pointer to the current map lump info struct
 lumpinfo_t *maplumpinfo;
 
@@ -773,6 +1469,7 @@ P_SetupLevel
     int		i;
     char	lumpname[9];
     int		lumpnum;
+    sha1_digest_t key;
 	
     totalkills = totalitems = totalsecret = wminfo.maxfrags = 0;
     wminfo.partime = 180;
@@ -793,6 +1490,7 @@ P_SetupLevel
 
     // UNUSED W_Profile ();
     P_InitThinkers ();
+    P_ClearSightCache ();
 
     // if working with a devlopment map, reload it
     W_Reload ();
@@ -820,18 +1518,30 @@ P_SetupLevel
 
     leveltime = 0;
 	
-    // note: most of this ordering is important	
-    P_LoadBlockMap (lumpnum+ML_BLOCKMAP);
-    P_LoadVertexes (lumpnum+ML_VERTEXES);
-    P_LoadSectors (lumpnum+ML_SECTORS);
-    P_LoadSideDefs (lumpnum+ML_SIDEDEFS);
-
-    P_LoadLineDefs (lumpnum+ML_LINEDEFS);
-    P_LoadSubsectors (lumpnum+ML_SSECTORS);
-    P_LoadNodes (lumpnum+ML_NODES);
-    P_LoadSegs (lumpnum+ML_SEGS);
-
-    P_GroupLines ();
+    if (levelcachedir != NULL)
+	P_LevelCacheKey (lumpnum, key);
+
+    if (levelcachedir == NULL || !P_LoadLevelCache (key))
+    {
+	// note: most of this ordering is important	
+	P_LoadBlockMap (lumpnum+ML_BLOCKMAP);
+	P_LoadVertexes (lumpnum+ML_VERTEXES);
+	P_LoadSectors (lumpnum+ML_SECTORS);
+	P_LoadSideDefs (lumpnum+ML_SIDEDEFS);
+
+	P_LoadLineDefs (lumpnum+ML_LINEDEFS);
+	P_LoadSubsectors (lumpnum+ML_SSECTORS);
+	P_LoadNodes (lumpnum+ML_NODES);
+	P_LoadSegs (lumpnum+ML_SEGS);
+
+	P_GroupLines ();
+
+	if (levelcachedir != NULL)
+	    P_SaveLevelCache (key);
+    }
+
+    P_InitTagLists ();
+
     P_LoadReject (lumpnum+ML_REJECT);
 
     bodyqueslot = 0;
@@ -874,6 +1584,8 @@ void P_Init (void)
 {
     P_InitSwitchList ();
     P_InitPicAnims ();
+    P_InitSight ();
+    P_InitLevelCache ();
     R_InitSprites (sprnames);
 }
 
@@ -39,6 +39,43 @@ fixed_t		t2y;
 
 int		sightcounts[2];
 
+//
+// Sight check cache.
+// A traversal of the BSP depends only on the positions and heights of
+// the two mobjs and on the sector heights, so its result is kept until
+// the end of the tic or until a floor or ceiling moves, whichever is
+// first.  The globals the traversal leaves behind are kept with it so
+// that a cached check looks the same to the rest of the code.
+//
+#define SIGHTCACHESIZE	1024
+
+typedef struct
+{
+    unsigned int	stamp;
+    mobj_t*		t1;
+    mobj_t*		t2;
+    fixed_t		x1, y1, z1, height1;
+    fixed_t		x2, y2, z2, height2;
+    boolean		result;
+
+    // state after the traversal
+    fixed_t		sightzstart;
+    fixed_t		topslope;
+    fixed_t		bottomslope;
+    fixed_t		opentop;
+    fixed_t		openbottom;
+} sightcache_t;
+
+static sightcache_t	sightcache[SIGHTCACHESIZE];
+static unsigned int	sightstamp = 1;
+
+// counters for -devparm
+static int		sightcachehits;
+static int		sightcachemisses;
+static int		sightnodes;
+static int		sightmaxnodes;
+static int64_t		sighttotalnodes;
+
 
 // PTR_SightTraverse() for Doom 1.2 sight calculations
 // taken from prboom-plus/src/p_sight.c:69-102
@@ -298,6 +335,8 @@ boolean P_CrossBSPNode (int bspnum)
     node_t*	bsp;
     int		side;
 
+    sightnodes++;
+
     if (bspnum & NF_SUBSECTOR)
     {
 	if (bspnum == -1)
@@ -345,6 +384,8 @@ P_CheckSight
     int		pnum;
     int		bytenum;
     int		bitnum;
+    sightcache_t*	entry;
+    boolean	result;
     
     // First check for trivial rejection.
 
@@ -368,18 +409,53 @@ P_CheckSight
     // Now look from eyes of t1 to any part of t2.
     sightcounts[1]++;
 
-    validcount++;
-	
-    sightzstart = t1->z + t1->height - (t1->height>>2);
-    topslope = (t2->z+t2->height) - sightzstart;
-    bottomslope = (t2->z) - sightzstart;
-	
     if (gameversion <= exe_doom_1_2)
     {
+        validcount++;
+
+        sightzstart = t1->z + t1->height - (t1->height>>2);
+        topslope = (t2->z+t2->height) - sightzstart;
+        bottomslope = (t2->z) - sightzstart;
+
         return P_PathTraverse(t1->x, t1->y, t2->x, t2->y,
                               PT_EARLYOUT | PT_ADDLINES, PTR_SightTraverse);
     }
 
+    entry = &sightcache[(((uintptr_t) t1 >> 4) * 31 + ((uintptr_t) t2 >> 4))
+                        & (SIGHTCACHESIZE - 1)];
+
+    if (entry->stamp == sightstamp
+     && entry->t1 == t1 && entry->t2 == t2
+     && entry->x1 == t1->x && entry->y1 == t1->y
+     && entry->z1 == t1->z && entry->height1 == t1->height
+     && entry->x2 == t2->x && entry->y2 == t2->y
+     && entry->z2 == t2->z && entry->height2 == t2->height)
+    {
+        sightcachehits++;
+
+        strace.x = t1->x;
+        strace.y = t1->y;
+        t2x = t2->x;
+        t2y = t2->y;
+        strace.dx = t2->x - t1->x;
+        strace.dy = t2->y - t1->y;
+        sightzstart = entry->sightzstart;
+        topslope = entry->topslope;
+        bottomslope = entry->bottomslope;
+        opentop = entry->opentop;
+        openbottom = entry->openbottom;
+
+        return entry->result;
+    }
+
+    sightcachemisses++;
+
+    validcount++;
+	
+    sightzstart = t1->z + t1->height - (t1->height>>2);
+    topslope = (t2->z+t2->height) - sightzstart;
+    bottomslope = (t2->z) - sightzstart;
+
     strace.x = t1->x;
     strace.y = t1->y;
     t2x = t2->x;
@@ -388,7 +464,69 @@ P_CheckSight
     strace.dy = t2->y - t1->y;
 
     // the head node is the last node output
-    return P_CrossBSPNode (numnodes-1);	
+    sightnodes = 0;
+    result = P_CrossBSPNode (numnodes-1);
+
+    if (sightnodes > sightmaxnodes)
+        sightmaxnodes = sightnodes;
+    sighttotalnodes += sightnodes;
+
+    entry->stamp = sightstamp;
+    entry->t1 = t1;
+    entry->t2 = t2;
+    entry->x1 = t1->x;
+    entry->y1 = t1->y;
+    entry->z1 = t1->z;
+    entry->height1 = t1->height;
+    entry->x2 = t2->x;
+    entry->y2 = t2->y;
+    entry->z2 = t2->z;
+    entry->height2 = t2->height;
+    entry->result = result;
+    entry->sightzstart = sightzstart;
+    entry->topslope = topslope;
+    entry->bottomslope = bottomslope;
+    entry->opentop = opentop;
+    entry->openbottom = openbottom;
+
+    return result;
+}
+
+
+//
+// P_ClearSightCache
+// Called at the start of every tic, and whenever a sector's floor or
+// ceiling height changes.
+//
+void P_ClearSightCache (void)
+{
+    sightstamp++;
+}
+
+static void PrintSightStats(void)
+{
+    int checks = sightcachehits + sightcachemisses;
+
+    if (checks == 0)
+        return;
+
+    printf("P_CheckSight: %i checks, %i from cache (%i%%), "
+           "%i BSP nodes per traversal on average, %i at most.\n",
+           checks, sightcachehits, (sightcachehits * 100) / checks,
+           sightcachemisses ? (int) (sighttotalnodes / sightcachemisses) : 0,
+           sightmaxnodes);
+}
+
+//
+// P_InitSight
+// Called at program start.
+//
+void P_InitSight (void)
+{
+    if (devparm)
+    {
+        I_AtExit(PrintSightStats, false);
+    }
 }
 
 
@@ -429,6 +429,29 @@ fixed_t	P_FindHighestCeilingSurrounding(sector_t* sec)
 
 
 
+//
+// P_InitTagLists
+// Hash the sectors by tag, so that finding the sectors for a tag
+// does not mean searching them all.  Each chain is built backwards
+// so that it runs in sector order.
+//
+void P_InitTagLists (void)
+{
+    int		i;
+    int		j;
+
+    for (i=0 ; i<numsectors ; i++)
+	sectors[i].firsttag = -1;
+
+    for (i=numsectors-1 ; i>=0 ; i--)
+    {
+	j = (unsigned int) sectors[i].tag % (unsigned int) numsectors;
+	sectors[i].nexttag = sectors[j].firsttag;
+	sectors[j].firsttag = i;
+    }
+}
+
+
 //
 // RETURN NEXT SECTOR # THAT LINE TAG REFERS TO
 //
@@ -438,12 +461,27 @@ P_FindSectorFromLineTag
   int		start )
 {
     int	i;
-	
-    for (i=start+1;i<numsectors;i++)
-	if (sectors[i].tag == line->tag)
-	    return i;
-    
-    return -1;
+
+    // Carry on along the chain from the last sector found,
+    // or find the place to start on it.
+    if (start >= 0 && start < numsectors
+     && sectors[start].tag == line->tag)
+    {
+	i = sectors[start].nexttag;
+    }
+    else
+    {
+	i = sectors[(unsigned int) line->tag
+		    % (unsigned int) numsectors].firsttag;
+
+	while (i >= 0 && i <= start)
+	    i = sectors[i].nexttag;
+    }
+
+    while (i >= 0 && sectors[i].tag != line->tag)
+	i = sectors[i].nexttag;
+
+    return i;
 }
 
 
@@ -1326,7 +1364,7 @@ int EV_DoDonut(line_t*	line)
             }
 
 	    //	Spawn rising slime
-	    floor = Z_Malloc (sizeof(*floor), PU_LEVSPEC, 0);
+	    floor = P_AllocThinker (sizeof(*floor));
 	    P_AddThinker (&floor->thinker);
 	    s2->specialdata = floor;
 	    floor->thinker.function.acp1 = (actionf_p1) T_MoveFloor;
@@ -1340,7 +1378,7 @@ int EV_DoDonut(line_t*	line)
 	    floor->floordestheight = s3_floorheight;
 	    
 	    //	Spawn lowering donut-hole
-	    floor = Z_Malloc (sizeof(*floor), PU_LEVSPEC, 0);
+	    floor = P_AllocThinker (sizeof(*floor));
 	    P_AddThinker (&floor->thinker);
 	    s1->specialdata = floor;
 	    floor->thinker.function.acp1 = (actionf_p1) T_MoveFloor;
@@ -92,6 +92,8 @@ P_FindNextHighestFloor
 fixed_t P_FindLowestCeilingSurrounding(sector_t* sec);
 fixed_t P_FindHighestCeilingSurrounding(sector_t* sec);
 
+void P_InitTagLists (void);
+
 int
 P_FindSectorFromLineTag
 ( line_t*	line,
@@ -18,6 +18,7 @@
 //
 
 
+#include "i_system.h"
 #include "z_zone.h"
 #include "p_local.h"
 
@@ -28,7 +29,7 @@ int	leveltime;
 
 //
 // THINKERS
-// All thinkers should be allocated by Z_Malloc
+// All thinkers should be allocated by P_AllocThinker
 // so they can be operated on uniformly.
 // The actual structures will vary in size,
 // but the first element must be thinker_t.
@@ -40,12 +41,140 @@ int	leveltime;
 thinker_t	thinkercap;
 
 
+//
+// Thinker pools.
+// Thinkers of each size are carved out of slabs of THINKERSLAB,
+// so that mobjs and specials spawned together sit together in
+// memory, and freed thinkers are reused without going back to the
+// zone.  The slabs are PU_LEVEL and go away with the level.
+//
+// Freed thinkers are queued, oldest first, and not handed out again
+// until THINKERREUSETICS have passed.  Stale target and tracer
+// pointers to a removed mobj then keep reading its last state for a
+// while, as they did with the zone, rather than whatever thinker
+// was spawned next.
+//
+#define THINKERSLAB	64
+#define MAXTHINKERPOOLS	16
+#define THINKERREUSETICS	(5*TICRATE)
+
+typedef struct thinkerpool_s thinkerpool_t;
+
+typedef struct thinkerslot_s
+{
+    thinkerpool_t*		pool;
+    struct thinkerslot_s*	nextfree;
+    int				freetic;
+} thinkerslot_t;
+
+struct thinkerpool_s
+{
+    int			size;		// of the thinker, not the slot
+    int			stride;
+
+    // freed slots, oldest at the head
+    thinkerslot_t*	freehead;
+    thinkerslot_t*	freetail;
+
+    // unused part of the newest slab
+    byte*		slab;
+    int			slabfree;
+};
+
+static thinkerpool_t	thinkerpools[MAXTHINKERPOOLS];
+static int		numthinkerpools;
+
+
 //
 // P_InitThinkers
 //
 void P_InitThinkers (void)
 {
     thinkercap.prev = thinkercap.next  = &thinkercap;
+
+    // Anything still in the pools belongs to the last level.
+    numthinkerpools = 0;
+}
+
+
+//
+// P_AllocThinker
+// Allocates memory for a thinker of the given size.
+//
+void* P_AllocThinker (int size)
+{
+    thinkerpool_t*	pool;
+    thinkerslot_t*	slot;
+    int			i;
+
+    for (i=0 ; i<numthinkerpools ; i++)
+    {
+	if (thinkerpools[i].size == size)
+	    break;
+    }
+
+    if (i == numthinkerpools)
+    {
+	if (numthinkerpools == MAXTHINKERPOOLS)
+	    I_Error ("P_AllocThinker: too many thinker sizes");
+
+	pool = &thinkerpools[numthinkerpools++];
+	pool->size = size;
+	pool->stride = (sizeof(thinkerslot_t) + size + sizeof(void *) - 1)
+		     & ~(sizeof(void *) - 1);
+	pool->freehead = pool->freetail = NULL;
+	pool->slab = NULL;
+	pool->slabfree = 0;
+    }
+    else
+    {
+	pool = &thinkerpools[i];
+    }
+
+    if (pool->freehead != NULL
+     && leveltime - pool->freehead->freetic >= THINKERREUSETICS)
+    {
+	slot = pool->freehead;
+	pool->freehead = slot->nextfree;
+	if (pool->freehead == NULL)
+	    pool->freetail = NULL;
+    }
+    else
+    {
+	if (pool->slabfree == 0)
+	{
+	    pool->slab = Z_Malloc (pool->stride * THINKERSLAB, PU_LEVEL, NULL);
+	    pool->slabfree = THINKERSLAB;
+	}
+
+	slot = (thinkerslot_t *) pool->slab;
+	pool->slab += pool->stride;
+	pool->slabfree--;
+    }
+
+    slot->pool = pool;
+
+    return slot + 1;
+}
+
+
+//
+// P_FreeThinker
+// Queues a thinker's memory for reuse by its pool.
+//
+void P_FreeThinker (thinker_t* thinker)
+{
+    thinkerslot_t*	slot = (thinkerslot_t *) thinker - 1;
+    thinkerpool_t*	pool = slot->pool;
+
+    slot->freetic = leveltime;
+    slot->nextfree = NULL;
+
+    if (pool->freetail != NULL)
+	pool->freetail->nextfree = slot;
+    else
+	pool->freehead = slot;
+    pool->freetail = slot;
 }
 
 
@@ -104,7 +233,7 @@ void P_RunThinkers (void)
             nextthinker = currentthinker->next;
 	    currentthinker->next->prev = currentthinker->prev;
 	    currentthinker->prev->next = currentthinker->next;
-	    Z_Free(currentthinker);
+	    P_FreeThinker(currentthinker);
 	}
 	else
 	{
@@ -139,6 +268,7 @@ void P_Ticker (void)
 	return;
     }
     
+    P_ClearSightCache ();
 		
     for (i=0 ; i<MAXPLAYERS ; i++)
 	if (playeringame[i])
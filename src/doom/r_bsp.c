@@ -39,8 +39,9 @@ line_t*          linedef;
 sector_t*        frontsector;
 sector_t*        backsector;
 
-drawseg_t        drawsegs[MAXDRAWSEGS];
+drawseg_t*       drawsegs;
 drawseg_t*       ds_p;
+int              maxdrawsegs;
 
 
 void R_StoreWallRange(int start, int stop);
@@ -55,6 +56,21 @@ void R_ClearDrawSegs (void)
 }
 
 
+//
+// R_GrowDrawSegs
+// Called when ds_p reaches the end of drawsegs.
+//
+void R_GrowDrawSegs (void)
+{
+    int              numdrawsegs;
+
+    numdrawsegs = ds_p - drawsegs;
+    maxdrawsegs = maxdrawsegs ? maxdrawsegs * 2 : 256;
+    drawsegs = I_Realloc(drawsegs, maxdrawsegs * sizeof(*drawsegs));
+    ds_p = drawsegs + numdrawsegs;
+}
+
+
 
 //
 // ClipWallSegment
@@ -25,9 +25,12 @@
 #include "z_zone.h"
 
 
+#include "w_checksum.h"
+#include "w_file.h"
 #include "w_wad.h"
 
 #include "doomdef.h"
+#include "m_argv.h"
 #include "m_misc.h"
 #include "p_local.h"
 
@@ -397,6 +400,255 @@ R_GetColumn
 }
 
 
+//
+// TEXTURE CACHE
+// With -texturecache, the column lookups and the composites of all
+//  textures are saved to a file the first time the game is run with
+//  a particular set of WADs, and loaded from it afterwards instead of
+//  being generated.  The file is in native byte order and is only
+//  used if the WAD directory checksum matches.  With -mmap it is
+//  mapped rather than read.
+//
+
+#define TEXCACHE_ID	"TEXCACHE"
+#define TEXCACHE_VERSION 1
+#define TEXCACHE_BYTEORDER 0x01020304
+
+typedef struct
+{
+    char		id[8];
+    int			version;
+    int			byteorder;
+    sha1_digest_t	checksum;
+    int			numtextures;
+} texcacheheader_t;
+
+// Per texture entry; offsets are from the start of the file.
+typedef struct
+{
+    int			width;
+    int			compositesize;
+    int			lumpofs;	// short[width]
+    int			colofsofs;	// unsigned short[width]
+    int			compositeofs;	// byte[compositesize]
+} texcacheentry_t;
+
+#define TEXCACHE_ALIGN(x) (((x) + 3) & ~3)
+
+static const char *texcachefile = NULL;
+
+
+//
+// R_LoadTextureCache
+// Returns false if there is no usable cache.
+//
+static boolean R_LoadTextureCache (void)
+{
+    wad_file_t*		file;
+    byte*		data;
+    texcacheheader_t*	header;
+    texcacheentry_t*	entries;
+    texcacheentry_t*	entry;
+    sha1_digest_t	checksum;
+    short*		collump;
+    unsigned short*	colofs;
+    unsigned int	length;
+    int			i;
+    int			x;
+
+    file = W_OpenFile (texcachefile);
+
+    if (file == NULL)
+	return false;
+
+    length = file->length;
+
+    if (file->mapped != NULL)
+    {
+	data = file->mapped;
+    }
+    else
+    {
+	data = Z_Malloc (length, PU_STATIC, 0);
+	length = W_Read (file, 0, data, length);
+    }
+
+    header = (texcacheheader_t *) data;
+    entries = (texcacheentry_t *) (header + 1);
+
+    W_Checksum (checksum);
+
+    if (length < sizeof(texcacheheader_t)
+     || memcmp (header->id, TEXCACHE_ID, sizeof(header->id)) != 0
+     || header->version != TEXCACHE_VERSION
+     || header->byteorder != TEXCACHE_BYTEORDER
+     || memcmp (header->checksum, checksum, sizeof(sha1_digest_t)) != 0
+     || header->numtextures != numtextures
+     || length < sizeof(texcacheheader_t)
+                 + numtextures * sizeof(texcacheentry_t))
+    {
+	goto invalid;
+    }
+
+    for (i=0 ; i<numtextures ; i++)
+    {
+	entry = &entries[i];
+
+	if (entry->width != textures[i]->width
+	 || entry->compositesize < 0
+	 || entry->lumpofs < 0
+	 || entry->lumpofs + entry->width * 2 > length
+	 || entry->colofsofs < 0
+	 || entry->colofsofs + entry->width * 2 > length
+	 || entry->compositeofs < 0
+	 || entry->compositeofs + entry->compositesize > length
+	 || (entry->lumpofs & 1) != 0
+	 || (entry->colofsofs & 1) != 0)
+	{
+	    goto invalid;
+	}
+
+	// Every column must be in a patch lump or inside the composite.
+	collump = (short *) (data + entry->lumpofs);
+	colofs = (unsigned short *) (data + entry->colofsofs);
+
+	for (x=0 ; x<entry->width ; x++)
+	{
+	    if (collump[x] < -1 || collump[x] >= (int) numlumps)
+		goto invalid;
+
+	    if (collump[x] > 0)
+	    {
+		if (colofs[x] >= W_LumpLength (collump[x]))
+		    goto invalid;
+	    }
+	    else if (colofs[x] + textures[i]->height > entry->compositesize)
+	    {
+		goto invalid;
+	    }
+	}
+    }
+
+    for (i=0 ; i<numtextures ; i++)
+    {
+	entry = &entries[i];
+
+	texturecolumnlump[i] = (short *) (data + entry->lumpofs);
+	texturecolumnofs[i] = (unsigned short *) (data + entry->colofsofs);
+	texturecompositesize[i] = entry->compositesize;
+
+	if (entry->compositesize > 0)
+	    texturecomposite[i] = data + entry->compositeofs;
+	else
+	    texturecomposite[i] = 0;
+    }
+
+    // The cache data is used in place for the rest of the game.
+    if (file->mapped == NULL)
+	W_CloseFile (file);
+
+    return true;
+
+  invalid:
+    printf ("\nR_InitTextures: %s is out of date, rebuilding it.\n",
+	    texcachefile);
+
+    if (file->mapped == NULL)
+	Z_Free (data);
+
+    W_CloseFile (file);
+
+    return false;
+}
+
+
+//
+// R_SaveTextureCache
+// Composites are generated one at a time and written straight out,
+//  as they are purgable.
+//
+static void R_SaveTextureCache (void)
+{
+    FILE*		stream;
+    texcacheheader_t	header;
+    texcacheentry_t*	entries;
+    texcacheentry_t*	entry;
+    static const byte	pad[4];
+    int			offset;
+    int			i;
+
+    entries = Z_Malloc (numtextures * sizeof(*entries), PU_STATIC, 0);
+
+    offset = sizeof(header) + numtextures * sizeof(*entries);
+
+    for (i=0 ; i<numtextures ; i++)
+    {
+	entry = &entries[i];
+	entry->width = textures[i]->width;
+	entry->compositesize = texturecompositesize[i];
+	entry->lumpofs = offset;
+	entry->colofsofs = offset + TEXCACHE_ALIGN(entry->width * 2);
+	entry->compositeofs = entry->colofsofs + TEXCACHE_ALIGN(entry->width * 2);
+	offset = entry->compositeofs + TEXCACHE_ALIGN(entry->compositesize);
+    }
+
+    memset (&header, 0, sizeof(header));
+    memcpy (header.id, TEXCACHE_ID, sizeof(header.id));
+    header.version = TEXCACHE_VERSION;
+    header.byteorder = TEXCACHE_BYTEORDER;
+    W_Checksum (header.checksum);
+    header.numtextures = numtextures;
+
+    stream = M_fopen (texcachefile, "wb");
+
+    if (stream == NULL)
+    {
+	printf ("\nR_InitTextures: failed to open %s for writing.\n",
+		texcachefile);
+	Z_Free (entries);
+	return;
+    }
+
+    fwrite (&header, sizeof(header), 1, stream);
+    fwrite (entries, sizeof(*entries), numtextures, stream);
+
+    for (i=0 ; i<numtextures ; i++)
+    {
+	entry = &entries[i];
+
+	fwrite (texturecolumnlump[i], 2, entry->width, stream);
+	fwrite (pad, 1, TEXCACHE_ALIGN(entry->width * 2) - entry->width * 2,
+		stream);
+	fwrite (texturecolumnofs[i], 2, entry->width, stream);
+	fwrite (pad, 1, TEXCACHE_ALIGN(entry->width * 2) - entry->width * 2,
+		stream);
+
+	if (entry->compositesize > 0)
+	{
+	    if (!texturecomposite[i])
+		R_GenerateComposite (i);
+
+	    fwrite (texturecomposite[i], 1, entry->compositesize, stream);
+	    fwrite (pad, 1, TEXCACHE_ALIGN(entry->compositesize)
+		          - entry->compositesize, stream);
+	}
+    }
+
+    if (ferror (stream))
+    {
+	printf ("\nR_InitTextures: error writing %s.\n", texcachefile);
+	fclose (stream);
+	M_remove (texcachefile);
+    }
+    else
+    {
+	fclose (stream);
+    }
+
+    Z_Free (entries);
+}
+
+
 static void GenerateTextureHashTable(void)
 {
     texture_t **rover;
@@ -585,9 +837,6 @@ void R_InitTextures (void)
 			 texture->name);
 	    }
 	}		
-	texturecolumnlump[i] = Z_Malloc (texture->width*sizeof(**texturecolumnlump), PU_STATIC,0);
-	texturecolumnofs[i] = Z_Malloc (texture->width*sizeof(**texturecolumnofs), PU_STATIC,0);
-
 	j = 1;
 	while (j*2 <= texture->width)
 	    j<<=1;
@@ -602,10 +851,35 @@ void R_InitTextures (void)
     if (maptex2)
         W_ReleaseLumpName(DEH_String("TEXTURE2"));
     
-    // Precalculate whatever possible.	
+    //!
+    // @arg <file>
+    // @category obscure
+    //
+    // Keep the texture column lookups and composite textures in the
+    // given file, so that they do not have to be generated again next
+    // time the same WADs are loaded.
+    //
 
-    for (i=0 ; i<numtextures ; i++)
-	R_GenerateLookup (i);
+    i = M_CheckParmWithArgs ("-texturecache", 1);
+
+    if (i > 0)
+	texcachefile = myargv[i + 1];
+
+    if (texcachefile == NULL || !R_LoadTextureCache ())
+    {
+	// Precalculate whatever possible.	
+
+	for (i=0 ; i<numtextures ; i++)
+	{
+	    texture = textures[i];
+	    texturecolumnlump[i] = Z_Malloc (texture->width*sizeof(**texturecolumnlump), PU_STATIC,0);
+	    texturecolumnofs[i] = Z_Malloc (texture->width*sizeof(**texturecolumnofs), PU_STATIC,0);
+	    R_GenerateLookup (i);
+	}
+
+	if (texcachefile != NULL)
+	    R_SaveTextureCache ();
+    }
     
     // Create translation table for global animation.
     texturetranslation = Z_Malloc ((numtextures+1)*sizeof(*texturetranslation), PU_STATIC, 0);
@@ -48,8 +48,6 @@
 #define SIL_TOP			2
 #define SIL_BOTH		3
 
-#define MAXDRAWSEGS		256
-
 
 
 
@@ -127,6 +125,11 @@ typedef	struct
 
     int			linecount;
     struct line_s**	lines;	// [linecount] size
+
+    // hash chains of sectors by tag, in sector order
+    // (see P_InitTagLists)
+    int		firsttag;
+    int		nexttag;
     
 } sector_t;
 
@@ -420,8 +423,11 @@ typedef struct
 //
 // Now what is a visplane, anyway?
 // 
-typedef struct
+typedef struct visplane_s
 {
+  // next plane with the same hash, see R_FindPlane
+  struct visplane_s*	next;
+
   fixed_t		height;
   int			picnum;
   int			lightlevel;
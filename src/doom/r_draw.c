@@ -89,6 +89,24 @@ byte*           dc_source;
 // just for profiling 
 int             dccount;
 
+//
+// R_ReadColumnState
+// Captures the dc_* globals so that a column can be drawn later,
+//  or on another thread.
+//
+void R_ReadColumnState (drawcol_t *dc)
+{
+    dc->colormap = dc_colormap;
+    dc->source = dc_source;
+    dc->translation = dc_translation;
+    dc->x = dc_x;
+    dc->yl = dc_yl;
+    dc->yh = dc_yh;
+    dc->iscale = dc_iscale;
+    dc->texturemid = dc_texturemid;
+    dc->fuzzpos = fuzzpos;
+}
+
 //
 // A column is a vertical slice/span from a wall texture that,
 //  given the DOOM style restrictions on the view orientation,
@@ -96,35 +114,35 @@ int             dccount;
 // Thus a special case loop for very fast rendering can
 //  be used. It has also been used with Wolfenstein 3D.
 // 
-void R_DrawColumn (void) 
+void R_DrawColumnCmd (drawcol_t *dc)
 { 
     int                        count; 
     pixel_t*                dest;
     fixed_t                frac;
     fixed_t                fracstep;         
  
-    count = dc_yh - dc_yl; 
+    count = dc->yh - dc->yl; 
 
     // Zero length, column does not exceed a pixel.
     if (count < 0) 
         return; 
                                  
 #ifdef RANGECHECK 
-    if ((unsigned)dc_x >= SCREENWIDTH
-        || dc_yl < 0
-        || dc_yh >= SCREENHEIGHT) 
-        I_Error ("R_DrawColumn: %i to %i at %i", dc_yl, dc_yh, dc_x); 
+    if ((unsigned)dc->x >= SCREENWIDTH
+        || dc->yl < 0
+        || dc->yh >= SCREENHEIGHT) 
+        I_Error ("R_DrawColumn: %i to %i at %i", dc->yl, dc->yh, dc->x); 
 #endif 
 
     // Framebuffer destination address.
     // Use ylookup LUT to avoid multiply with ScreenWidth.
     // Use columnofs LUT for subwindows? 
-    dest = ylookup[dc_yl] + columnofs[dc_x];  
+    dest = ylookup[dc->yl] + columnofs[dc->x];  
 
     // Determine scaling,
     //  which is the only mapping to be done.
-    fracstep = dc_iscale; 
-    frac = dc_texturemid + (dc_yl-centery)*fracstep; 
+    fracstep = dc->iscale; 
+    frac = dc->texturemid + (dc->yl-centery)*fracstep; 
 
     // Inner loop that does the actual texture mapping,
     //  e.g. a DDA-lile scaling.
@@ -133,14 +151,22 @@ void R_DrawColumn (void)
     {
         // Re-map color indices from wall texture column
         //  using a lighting/special effects LUT.
-        *dest = dc_colormap[dc_source[(frac>>FRACBITS)&127]];
+        *dest = dc->colormap[dc->source[(frac>>FRACBITS)&127]];
         dest += SCREENWIDTH; 
         frac += fracstep; 
     } while (count--); 
+}
+
+void R_DrawColumn (void)
+{
+    drawcol_t dc;
+
+    R_ReadColumnState(&dc);
+    R_DrawColumnCmd(&dc);
 } 
 
 
-void R_DrawColumnLow (void) 
+void R_DrawColumnLowCmd (drawcol_t *dc)
 { 
     int                        count; 
     pixel_t*                dest;
@@ -149,35 +175,35 @@ void R_DrawColumnLow (void)
     fixed_t                fracstep;         
     int                 x;
  
-    count = dc_yh - dc_yl; 
+    count = dc->yh - dc->yl; 
 
     // Zero length.
     if (count < 0) 
         return; 
                                  
 #ifdef RANGECHECK 
-    if ((unsigned)dc_x >= SCREENWIDTH
-        || dc_yl < 0
-        || dc_yh >= SCREENHEIGHT)
+    if ((unsigned)dc->x >= SCREENWIDTH
+        || dc->yl < 0
+        || dc->yh >= SCREENHEIGHT)
     {
         
-        I_Error ("R_DrawColumn: %i to %i at %i", dc_yl, dc_yh, dc_x);
+        I_Error ("R_DrawColumn: %i to %i at %i", dc->yl, dc->yh, dc->x);
     }
     //        dccount++; 
 #endif 
     // Blocky mode, need to multiply by 2.
-    x = dc_x << 1;
+    x = dc->x << 1;
     
-    dest = ylookup[dc_yl] + columnofs[x];
-    dest2 = ylookup[dc_yl] + columnofs[x+1];
+    dest = ylookup[dc->yl] + columnofs[x];
+    dest2 = ylookup[dc->yl] + columnofs[x+1];
     
-    fracstep = dc_iscale; 
-    frac = dc_texturemid + (dc_yl-centery)*fracstep;
+    fracstep = dc->iscale; 
+    frac = dc->texturemid + (dc->yl-centery)*fracstep;
     
     do 
     {
         // Hack. Does not work corretly.
-        *dest2 = *dest = dc_colormap[dc_source[(frac>>FRACBITS)&127]];
+        *dest2 = *dest = dc->colormap[dc->source[(frac>>FRACBITS)&127]];
         dest += SCREENWIDTH;
         dest2 += SCREENWIDTH;
         frac += fracstep; 
@@ -185,6 +211,14 @@ void R_DrawColumnLow (void)
     } while (count--);
 }
 
+void R_DrawColumnLow (void)
+{
+    drawcol_t dc;
+
+    R_ReadColumnState(&dc);
+    R_DrawColumnLowCmd(&dc);
+}
+
 
 //
 // Spectre/Invisibility.
@@ -214,35 +248,35 @@ int fuzzoffset[FUZZTABLE] =
 //  could create the SHADOW effect,
 //  i.e. spectres and invisible players.
 //
-void R_DrawFuzzColumn (void) 
+void R_DrawFuzzColumnCmd (drawcol_t *dc)
 { 
     int         count; 
     pixel_t*    dest;
 
     // Adjust borders. Low... 
-    if (!dc_yl) 
-        dc_yl = 1;
+    if (!dc->yl) 
+        dc->yl = 1;
 
     // .. and high.
-    if (dc_yh == viewheight-1) 
-        dc_yh = viewheight - 2; 
+    if (dc->yh == viewheight-1) 
+        dc->yh = viewheight - 2; 
                  
-    count = dc_yh - dc_yl; 
+    count = dc->yh - dc->yl; 
 
     // Zero length.
     if (count < 0) 
         return; 
 
 #ifdef RANGECHECK 
-    if ((unsigned)dc_x >= SCREENWIDTH
-        || dc_yl < 0 || dc_yh >= SCREENHEIGHT)
+    if ((unsigned)dc->x >= SCREENWIDTH
+        || dc->yl < 0 || dc->yh >= SCREENHEIGHT)
     {
         I_Error ("R_DrawFuzzColumn: %i to %i at %i",
-                 dc_yl, dc_yh, dc_x);
+                 dc->yl, dc->yh, dc->x);
     }
 #endif
     
-    dest = ylookup[dc_yl] + columnofs[dc_x];
+    dest = ylookup[dc->yl] + columnofs[dc->x];
 
     // Looks like an attempt at dithering,
     //  using the colormap #6 (of 0-31, a bit
@@ -253,19 +287,49 @@ void R_DrawFuzzColumn (void)
         //  a pixel that is either one column
         //  left or right of the current one.
         // Add index from colormap to index.
-        *dest = colormaps[6*256+dest[fuzzoffset[fuzzpos]]]; 
+        *dest = colormaps[6*256+dest[fuzzoffset[dc->fuzzpos]]]; 
 
         // Clamp table lookup index.
-        if (++fuzzpos == FUZZTABLE) 
-            fuzzpos = 0;
+        if (++dc->fuzzpos == FUZZTABLE) 
+            dc->fuzzpos = 0;
         
         dest += SCREENWIDTH;
     } while (count--); 
+}
+
+void R_DrawFuzzColumn (void)
+{
+    drawcol_t dc;
+
+    R_ReadColumnState(&dc);
+    R_DrawFuzzColumnCmd(&dc);
+    fuzzpos = dc.fuzzpos;
 } 
 
+//
+// R_SkipFuzzColumn
+// Advances fuzzpos exactly as drawing the current dc_* column with
+//  R_DrawFuzzColumn (or the low detail version) would, without
+//  touching the framebuffer.
+//
+void R_SkipFuzzColumn (void)
+{
+    int         yl, yh;
+    int         count;
+
+    yl = dc_yl ? dc_yl : 1;
+    yh = dc_yh == viewheight-1 ? viewheight - 2 : dc_yh;
+    count = yh - yl;
+
+    if (count < 0)
+        return;
+
+    fuzzpos = (fuzzpos + count + 1) % FUZZTABLE;
+}
+
 // low detail mode version
  
-void R_DrawFuzzColumnLow (void) 
+void R_DrawFuzzColumnLowCmd (drawcol_t *dc)
 { 
     int                        count; 
     pixel_t*                dest;
@@ -273,14 +337,14 @@ void R_DrawFuzzColumnLow (void)
     int x;
 
     // Adjust borders. Low... 
-    if (!dc_yl) 
-        dc_yl = 1;
+    if (!dc->yl) 
+        dc->yl = 1;
 
     // .. and high.
-    if (dc_yh == viewheight-1) 
-        dc_yh = viewheight - 2; 
+    if (dc->yh == viewheight-1) 
+        dc->yh = viewheight - 2; 
                  
-    count = dc_yh - dc_yl; 
+    count = dc->yh - dc->yl; 
 
     // Zero length.
     if (count < 0) 
@@ -288,19 +352,19 @@ void R_DrawFuzzColumnLow (void)
 
     // low detail mode, need to multiply by 2
     
-    x = dc_x << 1;
+    x = dc->x << 1;
     
 #ifdef RANGECHECK 
     if ((unsigned)x >= SCREENWIDTH
-        || dc_yl < 0 || dc_yh >= SCREENHEIGHT)
+        || dc->yl < 0 || dc->yh >= SCREENHEIGHT)
     {
         I_Error ("R_DrawFuzzColumn: %i to %i at %i",
-                 dc_yl, dc_yh, dc_x);
+                 dc->yl, dc->yh, dc->x);
     }
 #endif
     
-    dest = ylookup[dc_yl] + columnofs[x];
-    dest2 = ylookup[dc_yl] + columnofs[x+1];
+    dest = ylookup[dc->yl] + columnofs[x];
+    dest2 = ylookup[dc->yl] + columnofs[x+1];
 
     // Looks like an attempt at dithering,
     //  using the colormap #6 (of 0-31, a bit
@@ -311,16 +375,25 @@ void R_DrawFuzzColumnLow (void)
         //  a pixel that is either one column
         //  left or right of the current one.
         // Add index from colormap to index.
-        *dest = colormaps[6*256+dest[fuzzoffset[fuzzpos]]]; 
-        *dest2 = colormaps[6*256+dest2[fuzzoffset[fuzzpos]]]; 
+        *dest = colormaps[6*256+dest[fuzzoffset[dc->fuzzpos]]]; 
+        *dest2 = colormaps[6*256+dest2[fuzzoffset[dc->fuzzpos]]]; 
 
         // Clamp table lookup index.
-        if (++fuzzpos == FUZZTABLE) 
-            fuzzpos = 0;
+        if (++dc->fuzzpos == FUZZTABLE) 
+            dc->fuzzpos = 0;
         
         dest += SCREENWIDTH;
         dest2 += SCREENWIDTH;
     } while (count--); 
+}
+
+void R_DrawFuzzColumnLow (void)
+{
+    drawcol_t dc;
+
+    R_ReadColumnState(&dc);
+    R_DrawFuzzColumnLowCmd(&dc);
+    fuzzpos = dc.fuzzpos;
 } 
  
   
@@ -339,34 +412,34 @@ void R_DrawFuzzColumnLow (void)
 byte*        dc_translation;
 byte*        translationtables;
 
-void R_DrawTranslatedColumn (void) 
+void R_DrawTranslatedColumnCmd (drawcol_t *dc)
 { 
     int                        count; 
     pixel_t*                dest;
     fixed_t                frac;
     fixed_t                fracstep;         
  
-    count = dc_yh - dc_yl; 
+    count = dc->yh - dc->yl; 
     if (count < 0) 
         return; 
                                  
 #ifdef RANGECHECK 
-    if ((unsigned)dc_x >= SCREENWIDTH
-        || dc_yl < 0
-        || dc_yh >= SCREENHEIGHT)
+    if ((unsigned)dc->x >= SCREENWIDTH
+        || dc->yl < 0
+        || dc->yh >= SCREENHEIGHT)
     {
         I_Error ( "R_DrawColumn: %i to %i at %i",
-                  dc_yl, dc_yh, dc_x);
+                  dc->yl, dc->yh, dc->x);
     }
     
 #endif 
 
 
-    dest = ylookup[dc_yl] + columnofs[dc_x]; 
+    dest = ylookup[dc->yl] + columnofs[dc->x]; 
 
     // Looks familiar.
-    fracstep = dc_iscale; 
-    frac = dc_texturemid + (dc_yl-centery)*fracstep; 
+    fracstep = dc->iscale; 
+    frac = dc->texturemid + (dc->yl-centery)*fracstep; 
 
     // Here we do an additional index re-mapping.
     do 
@@ -376,14 +449,22 @@ void R_DrawTranslatedColumn (void)
         //  used with PLAY sprites.
         // Thus the "green" ramp of the player 0 sprite
         //  is mapped to gray, red, black/indigo. 
-        *dest = dc_colormap[dc_translation[dc_source[frac>>FRACBITS]]];
+        *dest = dc->colormap[dc->translation[dc->source[frac>>FRACBITS]]];
         dest += SCREENWIDTH;
         
         frac += fracstep; 
     } while (count--); 
+}
+
+void R_DrawTranslatedColumn (void)
+{
+    drawcol_t dc;
+
+    R_ReadColumnState(&dc);
+    R_DrawTranslatedColumnCmd(&dc);
 } 
 
-void R_DrawTranslatedColumnLow (void) 
+void R_DrawTranslatedColumnLowCmd (drawcol_t *dc)
 { 
     int                        count; 
     pixel_t*                dest;
@@ -392,29 +473,29 @@ void R_DrawTranslatedColumnLow (void)
     fixed_t                fracstep;         
     int                 x;
  
-    count = dc_yh - dc_yl; 
+    count = dc->yh - dc->yl; 
     if (count < 0) 
         return; 
 
     // low detail, need to scale by 2
-    x = dc_x << 1;
+    x = dc->x << 1;
                                  
 #ifdef RANGECHECK 
     if ((unsigned)x >= SCREENWIDTH
-        || dc_yl < 0
-        || dc_yh >= SCREENHEIGHT)
+        || dc->yl < 0
+        || dc->yh >= SCREENHEIGHT)
     {
-        I_Error ( "R_DrawColumn: %i to %i at %i", dc_yl, dc_yh, x);
+        I_Error ( "R_DrawColumn: %i to %i at %i", dc->yl, dc->yh, x);
     }
 #endif 
 
 
-    dest = ylookup[dc_yl] + columnofs[x]; 
-    dest2 = ylookup[dc_yl] + columnofs[x+1]; 
+    dest = ylookup[dc->yl] + columnofs[x]; 
+    dest2 = ylookup[dc->yl] + columnofs[x+1]; 
 
     // Looks familiar.
-    fracstep = dc_iscale; 
-    frac = dc_texturemid + (dc_yl-centery)*fracstep; 
+    fracstep = dc->iscale; 
+    frac = dc->texturemid + (dc->yl-centery)*fracstep; 
 
     // Here we do an additional index re-mapping.
     do 
@@ -424,13 +505,21 @@ void R_DrawTranslatedColumnLow (void)
         //  used with PLAY sprites.
         // Thus the "green" ramp of the player 0 sprite
         //  is mapped to gray, red, black/indigo. 
-        *dest = dc_colormap[dc_translation[dc_source[frac>>FRACBITS]]];
-        *dest2 = dc_colormap[dc_translation[dc_source[frac>>FRACBITS]]];
+        *dest = dc->colormap[dc->translation[dc->source[frac>>FRACBITS]]];
+        *dest2 = dc->colormap[dc->translation[dc->source[frac>>FRACBITS]]];
         dest += SCREENWIDTH;
         dest2 += SCREENWIDTH;
         
         frac += fracstep; 
     } while (count--); 
+}
+
+void R_DrawTranslatedColumnLow (void)
+{
+    drawcol_t dc;
+
+    R_ReadColumnState(&dc);
+    R_DrawTranslatedColumnLowCmd(&dc);
 } 
 
 
@@ -501,9 +590,34 @@ byte*                        ds_source;
 int                        dscount;
 
 
+//
+// R_ReadSpanState
+// Captures the ds_* globals so that a span can be drawn later,
+//  or on another thread.
+//
+void R_ReadSpanState (drawspan_t *ds)
+{
+    ds->colormap = ds_colormap;
+    ds->source = ds_source;
+    ds->y = ds_y;
+    ds->x1 = ds_x1;
+    ds->x2 = ds_x2;
+
+    // Pack position and step variables into a single 32-bit integer,
+    // with x in the top 16 bits and y in the bottom 16 bits.  For
+    // each 16-bit part, the top 6 bits are the integer part and the
+    // bottom 10 bits are the fractional part of the pixel position.
+
+    ds->position = ((ds_xfrac << 10) & 0xffff0000)
+                 | ((ds_yfrac >> 6)  & 0x0000ffff);
+    ds->step = ((ds_xstep << 10) & 0xffff0000)
+             | ((ds_ystep >> 6)  & 0x0000ffff);
+}
+
+
 //
 // Draws the actual span.
-void R_DrawSpan (void) 
+void R_DrawSpanCmd (drawspan_t *ds)
 { 
     unsigned int position, step;
     pixel_t *dest;
@@ -512,31 +626,24 @@ void R_DrawSpan (void)
     unsigned int xtemp, ytemp;
 
 #ifdef RANGECHECK
-    if (ds_x2 < ds_x1
-        || ds_x1<0
-        || ds_x2>=SCREENWIDTH
-        || (unsigned)ds_y>SCREENHEIGHT)
+    if (ds->x2 < ds->x1
+        || ds->x1<0
+        || ds->x2>=SCREENWIDTH
+        || (unsigned)ds->y>SCREENHEIGHT)
     {
         I_Error( "R_DrawSpan: %i to %i at %i",
-                 ds_x1,ds_x2,ds_y);
+                 ds->x1,ds->x2,ds->y);
     }
 //        dscount++;
 #endif
 
-    // Pack position and step variables into a single 32-bit integer,
-    // with x in the top 16 bits and y in the bottom 16 bits.  For
-    // each 16-bit part, the top 6 bits are the integer part and the
-    // bottom 10 bits are the fractional part of the pixel position.
+    position = ds->position;
+    step = ds->step;
 
-    position = ((ds_xfrac << 10) & 0xffff0000)
-             | ((ds_yfrac >> 6)  & 0x0000ffff);
-    step = ((ds_xstep << 10) & 0xffff0000)
-         | ((ds_ystep >> 6)  & 0x0000ffff);
-
-    dest = ylookup[ds_y] + columnofs[ds_x1];
+    dest = ylookup[ds->y] + columnofs[ds->x1];
 
     // We do not check for zero spans here?
-    count = ds_x2 - ds_x1;
+    count = ds->x2 - ds->x1;
 
     do
     {
@@ -547,13 +654,21 @@ void R_DrawSpan (void)
 
         // Lookup pixel from flat texture tile,
         //  re-index using light/colormap.
-        *dest++ = ds_colormap[ds_source[spot]];
+        *dest++ = ds->colormap[ds->source[spot]];
 
         position += step;
 
     } while (count--);
 }
 
+void R_DrawSpan (void)
+{
+    drawspan_t ds;
+
+    R_ReadSpanState(&ds);
+    R_DrawSpanCmd(&ds);
+}
+
 
 
 // UNUSED.
@@ -632,7 +747,7 @@ void R_DrawSpan (void)
 //
 // Again..
 //
-void R_DrawSpanLow (void)
+void R_DrawSpanLowCmd (drawspan_t *ds)
 {
     unsigned int position, step;
     unsigned int xtemp, ytemp;
@@ -641,29 +756,24 @@ void R_DrawSpanLow (void)
     int spot;
 
 #ifdef RANGECHECK
-    if (ds_x2 < ds_x1
-        || ds_x1<0
-        || ds_x2>=SCREENWIDTH
-        || (unsigned)ds_y>SCREENHEIGHT)
+    if (ds->x2 < ds->x1
+        || ds->x1<0
+        || ds->x2>=SCREENWIDTH
+        || (unsigned)ds->y>SCREENHEIGHT)
     {
         I_Error( "R_DrawSpan: %i to %i at %i",
-                 ds_x1,ds_x2,ds_y);
+                 ds->x1,ds->x2,ds->y);
     }
 //        dscount++; 
 #endif
 
-    position = ((ds_xfrac << 10) & 0xffff0000)
-             | ((ds_yfrac >> 6)  & 0x0000ffff);
-    step = ((ds_xstep << 10) & 0xffff0000)
-         | ((ds_ystep >> 6)  & 0x0000ffff);
+    position = ds->position;
+    step = ds->step;
 
-    count = (ds_x2 - ds_x1);
+    count = (ds->x2 - ds->x1);
 
     // Blocky mode, need to multiply by 2.
-    ds_x1 <<= 1;
-    ds_x2 <<= 1;
-
-    dest = ylookup[ds_y] + columnofs[ds_x1];
+    dest = ylookup[ds->y] + columnofs[ds->x1 << 1];
 
     do
     {
@@ -674,14 +784,22 @@ void R_DrawSpanLow (void)
 
         // Lowres/blocky mode does it twice,
         //  while scale is adjusted appropriately.
-        *dest++ = ds_colormap[ds_source[spot]];
-        *dest++ = ds_colormap[ds_source[spot]];
+        *dest++ = ds->colormap[ds->source[spot]];
+        *dest++ = ds->colormap[ds->source[spot]];
 
         position += step;
 
     } while (count--);
 }
 
+void R_DrawSpanLow (void)
+{
+    drawspan_t ds;
+
+    R_ReadSpanState(&ds);
+    R_DrawSpanLowCmd(&ds);
+}
+
 //
 // R_InitBuffer 
 // Creats lookup tables that avoid
@@ -33,6 +33,41 @@ extern fixed_t		dc_texturemid;
 // first pixel in a column
 extern byte*		dc_source;		
 
+// position in the fuzz offset table, see R_DrawFuzzColumn
+extern int		fuzzpos;
+
+
+// A column or span captured from the dc_* / ds_* globals, so that
+//  it can be drawn later (see r_thread.c).
+typedef struct
+{
+    lighttable_t*	colormap;
+    byte*		source;
+    byte*		translation;
+    int			x;
+    int			yl;
+    int			yh;
+    fixed_t		iscale;
+    fixed_t		texturemid;
+    int			fuzzpos;
+} drawcol_t;
+
+typedef struct
+{
+    lighttable_t*	colormap;
+    byte*		source;
+    int			y;
+    int			x1;
+    int			x2;
+
+    // Packed texture position and step, as used by R_DrawSpan.
+    unsigned int	position;
+    unsigned int	step;
+} drawspan_t;
+
+void	R_ReadColumnState (drawcol_t *dc);
+void	R_ReadSpanState (drawspan_t *ds);
+
 
 // The span blitting interface.
 // Hook in assembler or system specific BLT
@@ -40,15 +75,26 @@ extern byte*		dc_source;
 void 	R_DrawColumn (void);
 void 	R_DrawColumnLow (void);
 
+void 	R_DrawColumnCmd (drawcol_t *dc);
+void 	R_DrawColumnLowCmd (drawcol_t *dc);
+
 // The Spectre/Invisibility effect.
 void 	R_DrawFuzzColumn (void);
 void 	R_DrawFuzzColumnLow (void);
+void 	R_DrawFuzzColumnCmd (drawcol_t *dc);
+void 	R_DrawFuzzColumnLowCmd (drawcol_t *dc);
+
+// Advance the fuzz position as R_DrawFuzzColumn would,
+//  without drawing anything.
+void 	R_SkipFuzzColumn (void);
 
 // Draw with color translation tables,
 //  for player sprite rendering,
 //  Green/Red/Blue/Indigo shirts.
 void	R_DrawTranslatedColumn (void);
 void	R_DrawTranslatedColumnLow (void);
+void	R_DrawTranslatedColumnCmd (drawcol_t *dc);
+void	R_DrawTranslatedColumnLowCmd (drawcol_t *dc);
 
 void
 R_VideoErase
@@ -80,6 +126,9 @@ void 	R_DrawSpan (void);
 // Low resolution mode, 160x200?
 void 	R_DrawSpanLow (void);
 
+void 	R_DrawSpanCmd (drawspan_t *ds);
+void 	R_DrawSpanLowCmd (drawspan_t *ds);
+
 
 void
 R_InitBuffer
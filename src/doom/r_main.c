@@ -26,9 +26,11 @@
 
 #include "m_bbox.h"
 #include "m_menu.h"
+#include "m_profile.h"
 
 #include "r_local.h"
 #include "r_sky.h"
+#include "r_thread.h"
 
 
 // Fineangles in the SCREENWIDTH wide window.
@@ -553,6 +555,8 @@ void R_ExecuteSetViewSize (void)
         spanfunc = R_DrawSpanLow;
     }
 
+    R_SetupRenderThreads();
+
     R_InitBuffer(scaledviewwidth, viewheight);
     R_InitTextureMapping();
     
@@ -618,6 +622,7 @@ void R_Init (void)
     printf (".");
     R_InitSkyMap ();
     R_InitTranslationTables ();
+    R_InitRenderThreads ();
     printf (".");
         
     framecount = 0;
@@ -704,13 +709,22 @@ void R_RenderPlayerView (player_t* player)
     R_ClearSprites();
     
     NetUpdate(); // check for new console commands.
+    M_ProfileStart(PROF_BSP);
     R_RenderBSPNode(numnodes-1); // The head node is the last node output.
+    R_FlushDraws();
+    M_ProfileStop(PROF_BSP);
     
     NetUpdate();
+    M_ProfileStart(PROF_PLANES);
     R_DrawPlanes();
+    R_FlushDraws();
+    M_ProfileStop(PROF_PLANES);
     
     NetUpdate();
+    M_ProfileStart(PROF_MASKED);
     R_DrawMasked();
+    R_FlushDraws();
+    M_ProfileStop(PROF_MASKED);
 
     NetUpdate();                                
 }
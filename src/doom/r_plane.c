@@ -43,12 +43,26 @@ planefunction_t		ceilingfunc;
 #define MAXOPENINGS	SCREENWIDTH*64
 
 // Here comes the obnoxious "visplane".
-#define MAXVISPLANES	128
-visplane_t		visplanes[MAXVISPLANES];
-visplane_t*		lastvisplane;
+// There is no fixed limit: planes are allocated in blocks as they
+//  are needed and kept for reuse in later frames.  visplanes[] lists
+//  the planes in use this frame, in the order they were created.
+#define VISPLANEBLOCK	128
+visplane_t**		visplanes;
+int			numvisplanes;
+static int		maxvisplanes;
 visplane_t*		floorplane;
 visplane_t*		ceilingplane;
 
+// Planes made by R_FindPlane, hashed on height, picnum and lightlevel.
+#define VISPLANEHASHSIZE	128
+static visplane_t*	visplanehash[VISPLANEHASHSIZE];
+
+// Heights are nearly always whole map units, so only those bits
+//  are hashed.
+#define VISPLANEHASH(height, picnum, lightlevel) \
+    (((unsigned) ((height) >> FRACBITS) * 7 + (unsigned) (picnum) * 3 \
+      + (unsigned) (lightlevel)) & (VISPLANEHASHSIZE - 1))
+
 short			openings[MAXOPENINGS];
 short*			          lastopening;
 
@@ -186,7 +200,8 @@ void R_ClearPlanes (void)
 	ceilingclip[i] = -1;
     }
 
-    lastvisplane = visplanes;
+    numvisplanes = 0;
+    memset (visplanehash, 0, sizeof(visplanehash));
     lastopening = openings;
     
     // texture calculation
@@ -203,6 +218,55 @@ void R_ClearPlanes (void)
 
 
 
+//
+// R_NewPlane
+// Takes the next free visplane, growing the pool if needed.
+//
+static visplane_t* R_NewPlane (void)
+{
+    visplane_t*	block;
+    int		i;
+
+    if (numvisplanes == maxvisplanes)
+    {
+	visplanes = I_Realloc (visplanes, (maxvisplanes + VISPLANEBLOCK)
+					  * sizeof(*visplanes));
+
+	// Zeroed once, so that bottom[] never holds garbage: columns
+	//  that are not part of a plane may still be read by
+	//  R_MakeSpans, and only need to be below 0xff.  Kept out of
+	//  the zone, like vissprites and drawsegs, so that growing in
+	//  the middle of the refresh never purges cached graphics.
+	block = I_Realloc (NULL, VISPLANEBLOCK * sizeof(*block));
+	memset (block, 0, VISPLANEBLOCK * sizeof(*block));
+
+	for (i=0 ; i<VISPLANEBLOCK ; i++)
+	    visplanes[maxvisplanes + i] = &block[i];
+
+	maxvisplanes += VISPLANEBLOCK;
+    }
+
+    return visplanes[numvisplanes++];
+}
+
+
+//
+// R_ClearPlaneColumns
+// top[] is only valid between minx and maxx; columns are marked
+//  empty as the plane grows to cover them, rather than clearing
+//  the whole plane up front.
+//
+static void
+R_ClearPlaneColumns
+( visplane_t*	pl,
+  int		start,
+  int		stop )
+{
+    if (start <= stop)
+	memset (pl->top + start, 0xff, stop - start + 1);
+}
+
+
 //
 // R_FindPlane
 //
@@ -213,6 +277,7 @@ R_FindPlane
   int		lightlevel )
 {
     visplane_t*	check;
+    unsigned	hash;
 	
     if (picnum == skyflatnum)
     {
@@ -220,32 +285,31 @@ R_FindPlane
 	lightlevel = 0;
     }
 	
-    for (check=visplanes; check<lastvisplane; check++)
+    // Only planes made here are hashed.  Planes split off by
+    //  R_CheckPlane share a key with one of these but are always
+    //  created after it, so the first match is still found.
+    hash = VISPLANEHASH(height, picnum, lightlevel);
+
+    for (check=visplanehash[hash] ; check ; check=check->next)
     {
 	if (height == check->height
 	    && picnum == check->picnum
 	    && lightlevel == check->lightlevel)
 	{
-	    break;
+	    return check;
 	}
     }
-    
-			
-    if (check < lastvisplane)
-	return check;
-		
-    if (lastvisplane - visplanes == MAXVISPLANES)
-	I_Error ("R_FindPlane: no more visplanes");
 		
-    lastvisplane++;
+    check = R_NewPlane ();
 
     check->height = height;
     check->picnum = picnum;
     check->lightlevel = lightlevel;
     check->minx = SCREENWIDTH;
     check->maxx = -1;
-    
-    memset (check->top,0xff,sizeof(check->top));
+
+    check->next = visplanehash[hash];
+    visplanehash[hash] = check;
 		
     return check;
 }
@@ -265,6 +329,7 @@ R_CheckPlane
     int		unionl;
     int		unionh;
     int		x;
+    visplane_t*	check;
 	
     if (start < pl->minx)
     {
@@ -294,6 +359,16 @@ R_CheckPlane
 
     if (x > intrh)
     {
+	if (pl->minx > pl->maxx)
+	{
+	    R_ClearPlaneColumns (pl, unionl, unionh);
+	}
+	else
+	{
+	    R_ClearPlaneColumns (pl, unionl, pl->minx - 1);
+	    R_ClearPlaneColumns (pl, pl->maxx + 1, unionh);
+	}
+
 	pl->minx = unionl;
 	pl->maxx = unionh;
 
@@ -302,20 +377,17 @@ R_CheckPlane
     }
 	
     // make a new visplane
-    lastvisplane->height = pl->height;
-    lastvisplane->picnum = pl->picnum;
-    lastvisplane->lightlevel = pl->lightlevel;
-    
-    if (lastvisplane - visplanes == MAXVISPLANES)
-	I_Error ("R_CheckPlane: no more visplanes");
-
-    pl = lastvisplane++;
-    pl->minx = start;
-    pl->maxx = stop;
-
-    memset (pl->top,0xff,sizeof(pl->top));
+    check = R_NewPlane ();
+    check->height = pl->height;
+    check->picnum = pl->picnum;
+    check->lightlevel = pl->lightlevel;
+    check->next = NULL;
+    check->minx = start;
+    check->maxx = stop;
+
+    R_ClearPlaneColumns (check, start, stop);
 		
-    return pl;
+    return check;
 }
 
 
@@ -367,23 +439,18 @@ void R_DrawPlanes (void)
     int			stop;
     int			angle;
     int                 lumpnum;
+    int			i;
 				
 #ifdef RANGECHECK
-    if (ds_p - drawsegs > MAXDRAWSEGS)
-	I_Error ("R_DrawPlanes: drawsegs overflow (%td)",
-		 ds_p - drawsegs);
-    
-    if (lastvisplane - visplanes > MAXVISPLANES)
-	I_Error ("R_DrawPlanes: visplane overflow (%td)",
-		 lastvisplane - visplanes);
-    
     if (lastopening - openings > MAXOPENINGS)
 	I_Error ("R_DrawPlanes: opening overflow (%td)",
 		 lastopening - openings);
 #endif
 
-    for (pl = visplanes ; pl < lastvisplane ; pl++)
+    for (i = 0 ; i < numvisplanes ; i++)
     {
+	pl = visplanes[i];
+
 	if (pl->minx > pl->maxx)
 	    continue;
 
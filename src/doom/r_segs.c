@@ -378,9 +378,9 @@ R_StoreWallRange
     fixed_t		vtop;
     int			lightnum;
 
-    // don't overflow and crash
-    if (ds_p == &drawsegs[MAXDRAWSEGS])
-	return;		
+    // drawsegs grows as needed
+    if (ds_p == drawsegs + maxdrawsegs)
+	R_GrowDrawSegs ();
 		
 #ifdef RANGECHECK
     if (start >=viewwidth || start > stop)
@@ -273,10 +273,23 @@ void R_InitSpriteDefs(const char **namelist)
 //
 // GAME FUNCTIONS
 //
-vissprite_t        vissprites[MAXVISSPRITES];
+// The vissprite pool grows as needed, rather than dropping
+//  sprites once a fixed number are visible.
+//
+vissprite_t*        vissprites;
 vissprite_t*        vissprite_p;
 int                newvissprite;
+static int          maxvissprites;
+
+// Most vissprites seen in a single frame.
+int                 peakvissprites;
+
 
+static void PrintVisSpriteStats(void)
+{
+    printf("R_DrawMasked: at most %i vissprites in one frame.\n",
+           peakvissprites);
+}
 
 
 //
@@ -293,6 +306,11 @@ void R_InitSprites(const char **namelist)
     }
         
     R_InitSpriteDefs (namelist);
+
+    if (devparm)
+    {
+        I_AtExit(PrintVisSpriteStats, false);
+    }
 }
 
 
@@ -310,12 +328,19 @@ void R_ClearSprites (void)
 //
 // R_NewVisSprite
 //
-vissprite_t        overflowsprite;
-
 vissprite_t* R_NewVisSprite (void)
 {
-    if (vissprite_p == &vissprites[MAXVISSPRITES])
-        return &overflowsprite;
+    int                count;
+
+    count = vissprite_p - vissprites;
+
+    if (count == maxvissprites)
+    {
+        maxvissprites = maxvissprites ? maxvissprites * 2 : 128;
+        vissprites = I_Realloc(vissprites,
+                               maxvissprites * sizeof(*vissprites));
+        vissprite_p = vissprites + count;
+    }
     
     vissprite_p++;
     return vissprite_p-1;
@@ -766,60 +791,144 @@ void R_DrawPlayerSprites (void)
 //
 vissprite_t        vsprsortedhead;
 
+static vissprite_t**        vsprsort;
+static vissprite_t**        vsprsorttemp;
+static int                  maxvsprsort;
+
+
+//
+// Stable merge sort on scale.  Equal scales keep the order the
+//  sprites were added in, which is the order the old selection
+//  sort (always taking the first smallest) produced.
+//
+static void MergeSortVisSprites(vissprite_t **list, vissprite_t **temp,
+                                int count)
+{
+    int                        half;
+    int                        i, j, k;
+
+    if (count < 2)
+        return;
+
+    half = count / 2;
+    MergeSortVisSprites(list, temp, half);
+    MergeSortVisSprites(list + half, temp, count - half);
+
+    i = 0;
+    j = half;
+    k = 0;
+
+    while (i < half && j < count)
+    {
+        if (list[j]->scale < list[i]->scale)
+            temp[k++] = list[j++];
+        else
+            temp[k++] = list[i++];
+    }
+
+    while (i < half)
+        temp[k++] = list[i++];
+
+    while (j < count)
+        temp[k++] = list[j++];
+
+    memcpy(list, temp, count * sizeof(*list));
+}
+
 
 void R_SortVisSprites (void)
 {
     int                        i;
     int                        count;
     vissprite_t*        ds;
-    vissprite_t*        best;
-    vissprite_t                unsorted;
-    fixed_t                bestscale;
 
     count = vissprite_p - vissprites;
+
+    if (count > peakvissprites)
+        peakvissprites = count;
         
-    unsorted.next = unsorted.prev = &unsorted;
+    vsprsortedhead.next = vsprsortedhead.prev = &vsprsortedhead;
 
     if (!count)
         return;
-                
-    for (ds=vissprites ; ds<vissprite_p ; ds++)
+
+    if (count > maxvsprsort)
     {
-        ds->next = ds+1;
-        ds->prev = ds-1;
+        maxvsprsort = maxvissprites;
+        vsprsort = I_Realloc(vsprsort, maxvsprsort * sizeof(*vsprsort));
+        vsprsorttemp = I_Realloc(vsprsorttemp,
+                                 maxvsprsort * sizeof(*vsprsorttemp));
     }
-    
-    vissprites[0].prev = &unsorted;
-    unsorted.next = &vissprites[0];
-    (vissprite_p-1)->next = &unsorted;
-    unsorted.prev = vissprite_p-1;
-    
-    // pull the vissprites out by scale
+                
+    for (i=0 ; i<count ; i++)
+        vsprsort[i] = &vissprites[i];
 
-    vsprsortedhead.next = vsprsortedhead.prev = &vsprsortedhead;
+    MergeSortVisSprites(vsprsort, vsprsorttemp, count);
+
+    // link them up, back to front
     for (i=0 ; i<count ; i++)
     {
-        bestscale = INT_MAX;
-        best = unsorted.next;
-        for (ds=unsorted.next ; ds!= &unsorted ; ds=ds->next)
+        ds = vsprsort[i];
+        ds->next = &vsprsortedhead;
+        ds->prev = vsprsortedhead.prev;
+        vsprsortedhead.prev->next = ds;
+        vsprsortedhead.prev = ds;
+    }
+}
+
+
+
+//
+// Drawseg clipping index.
+// Only drawsegs with a silhouette or a masked mid texture can
+//  affect a sprite.  Those are binned by the screen columns they
+//  cover, so that R_DrawSprite only looks at the drawsegs near
+//  each sprite.  Every bin lists drawseg numbers in ascending order.
+//
+#define DSBINSHIFT        5
+#define NUMDSBINS         ((SCREENWIDTH + (1 << DSBINSHIFT) - 1) >> DSBINSHIFT)
+
+typedef struct
+{
+    int*                segs;
+    int                 numsegs;
+    int                 maxsegs;
+} dsbin_t;
+
+static dsbin_t          dsbins[NUMDSBINS];
+
+
+static void R_BinDrawSegs (void)
+{
+    drawseg_t*          ds;
+    dsbin_t*            bin;
+    int                 b;
+
+    for (b=0 ; b<NUMDSBINS ; b++)
+        dsbins[b].numsegs = 0;
+
+    for (ds=drawsegs ; ds<ds_p ; ds++)
+    {
+        if (!ds->silhouette && !ds->maskedtexturecol)
+            continue;
+
+        for (b = ds->x1 >> DSBINSHIFT ; b <= ds->x2 >> DSBINSHIFT ; b++)
         {
-            if (ds->scale < bestscale)
+            bin = &dsbins[b];
+
+            if (bin->numsegs == bin->maxsegs)
             {
-                bestscale = ds->scale;
-                best = ds;
+                bin->maxsegs = bin->maxsegs ? bin->maxsegs * 2 : 64;
+                bin->segs = I_Realloc(bin->segs,
+                                      bin->maxsegs * sizeof(*bin->segs));
             }
+
+            bin->segs[bin->numsegs++] = ds - drawsegs;
         }
-        best->next->prev = best->prev;
-        best->prev->next = best->next;
-        best->next = &vsprsortedhead;
-        best->prev = vsprsortedhead.prev;
-        vsprsortedhead.prev->next = best;
-        vsprsortedhead.prev = best;
     }
 }
 
 
-
 //
 // R_DrawSprite
 //
@@ -834,15 +943,49 @@ void R_DrawSprite (vissprite_t* spr)
     fixed_t                scale;
     fixed_t                lowscale;
     int                        silhouette;
+    int                        cursor[NUMDSBINS];
+    int                        b, b1, b2;
+    int                        seg;
+    int                        best;
                 
     for (x = spr->x1 ; x<=spr->x2 ; x++)
         clipbot[x] = cliptop[x] = -2;
+
+    b1 = spr->x1 >> DSBINSHIFT;
+    b2 = spr->x2 >> DSBINSHIFT;
+
+    for (b=b1 ; b<=b2 ; b++)
+        cursor[b] = dsbins[b].numsegs - 1;
     
     // Scan drawsegs from end to start for obscuring segs.
     // The first drawseg that has a greater scale
     //  is the clip seg.
-    for (ds=ds_p-1 ; ds >= drawsegs ; ds--)
+    for (;;)
     {
+        // Take the highest numbered drawseg left in any of the
+        //  bins under the sprite; a drawseg spanning several bins
+        //  is taken from all of them at once.
+        best = -1;
+
+        for (b=b1 ; b<=b2 ; b++)
+        {
+            if (cursor[b] >= 0 && dsbins[b].segs[cursor[b]] > best)
+                best = dsbins[b].segs[cursor[b]];
+        }
+
+        if (best < 0)
+            break;
+
+        for (b=b1 ; b<=b2 ; b++)
+        {
+            seg = cursor[b] >= 0 ? dsbins[b].segs[cursor[b]] : -1;
+
+            if (seg == best)
+                cursor[b]--;
+        }
+
+        ds = &drawsegs[best];
+
         // determine if the drawseg obscures the sprite
         if (ds->x1 > spr->x2
             || ds->x2 < spr->x1
@@ -948,6 +1091,8 @@ void R_DrawMasked (void)
 
     if (vissprite_p > vissprites)
     {
+        R_BinDrawSegs ();
+
         // draw all vissprites back to front
         for (spr = vsprsortedhead.next; spr != &vsprsortedhead; spr=spr->next)
         {
@@ -22,12 +22,13 @@
 
 
 
-#define MAXVISSPRITES  	128
-
-extern vissprite_t	vissprites[MAXVISSPRITES];
+extern vissprite_t*	vissprites;
 extern vissprite_t*	vissprite_p;
 extern vissprite_t	vsprsortedhead;
 
+// Most vissprites seen in a single frame.
+extern int		peakvissprites;
+
 // Constant arrays used for psprite clipping
 //  and initializing clipping.
 extern short		negonearray[SCREENWIDTH];
@@ -0,0 +1,302 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Multi-threaded drawing of the player view.
+//
+//	The BSP walk, clipping, visplanes and sprite sorting all stay
+//	serial, exactly as in the ordinary renderer.  Only the column
+//	and span drawers are replaced: each call is captured into a
+//	queue belonging to the vertical band of the screen it touches
+//	(spans are cut at band edges), and the bands are drawn in
+//	parallel at each flush.  Every column of the screen is then
+//	written by one thread, in the same order as before, so the
+//	result is pixel-identical to drawing serially.
+//
+//	Queued draws point straight into zone memory: patches, flats
+//	and composites that are PU_CACHE and may be thrown out by any
+//	Z_Malloc.  So the queues are flushed from the zone's purge
+//	hook, before anything purgable is freed.  Nothing may Z_Free
+//	a block a queued draw could read without calling R_FlushDraws
+//	first.
+//
+
+
+#include <stdlib.h>
+
+#include "doomdef.h"
+
+#include "i_system.h"
+#include "i_thread.h"
+#include "m_argv.h"
+#include "z_zone.h"
+
+#include "r_local.h"
+#include "r_thread.h"
+
+
+#define MAXRENDERTHREADS	16
+
+// More bands than threads, so that a band full of detail does
+//  not leave the other threads idle.
+#define BANDSPERTHREAD		2
+#define MAXBANDS		(MAXRENDERTHREADS * BANDSPERTHREAD)
+
+typedef struct
+{
+    void	(*colfunc) (drawcol_t *dc);
+    void	(*spanfunc) (drawspan_t *ds);
+
+    union
+    {
+	drawcol_t	column;
+	drawspan_t	span;
+    } u;
+} drawcmd_t;
+
+typedef struct
+{
+    int		x1;
+    int		x2;
+
+    drawcmd_t*	cmds;
+    int		numcmds;
+    int		maxcmds;
+} drawband_t;
+
+int			renderthreads = 1;
+
+static iworkers_t*	workers;
+
+static drawband_t	bands[MAXBANDS];
+static int		numbands;
+static byte		bandforx[SCREENWIDTH];
+static boolean		drawsqueued;
+
+// The real drawers for the current detail level.
+static void		(*drawcolumn) (drawcol_t *dc);
+static void		(*drawfuzzcolumn) (drawcol_t *dc);
+static void		(*drawtranscolumn) (drawcol_t *dc);
+static void		(*drawspan) (drawspan_t *ds);
+
+
+static drawcmd_t* NewDrawCmd (int band)
+{
+    drawband_t*	b = &bands[band];
+
+    if (b->numcmds == b->maxcmds)
+    {
+	b->maxcmds = b->maxcmds ? b->maxcmds * 2 : 1024;
+	b->cmds = I_Realloc(b->cmds, b->maxcmds * sizeof(*b->cmds));
+    }
+
+    drawsqueued = true;
+
+    return &b->cmds[b->numcmds++];
+}
+
+
+static drawcmd_t* QueueColumn (void (*func) (drawcol_t *dc))
+{
+    drawcmd_t*	cmd;
+
+    cmd = NewDrawCmd(bandforx[dc_x]);
+    cmd->colfunc = func;
+    cmd->spanfunc = NULL;
+    R_ReadColumnState(&cmd->u.column);
+
+    return cmd;
+}
+
+static void QueueBaseColumn (void)
+{
+    QueueColumn(drawcolumn);
+}
+
+static void QueueTranslatedColumn (void)
+{
+    QueueColumn(drawtranscolumn);
+}
+
+static void QueueFuzzColumn (void)
+{
+    // The fuzz effect walks fuzzpos along every pixel it draws.
+    // The queued column keeps its starting position, and fuzzpos
+    // is stepped past it now, in the order the columns are issued.
+    QueueColumn(drawfuzzcolumn);
+    R_SkipFuzzColumn();
+}
+
+static void QueueSpan (void)
+{
+    drawspan_t	span;
+    drawcmd_t*	cmd;
+    int		b;
+
+    R_ReadSpanState(&span);
+
+    for (b = bandforx[span.x1]; b < numbands && bands[b].x1 <= span.x2; b++)
+    {
+	cmd = NewDrawCmd(b);
+	cmd->colfunc = NULL;
+	cmd->spanfunc = drawspan;
+	cmd->u.span = span;
+
+	// The texture position steps by a fixed amount per pixel,
+	//  so a span cut at the band edge starts exactly where the
+	//  whole span would have been at that pixel.
+	if (span.x1 < bands[b].x1)
+	{
+	    cmd->u.span.x1 = bands[b].x1;
+	    cmd->u.span.position += (bands[b].x1 - span.x1) * span.step;
+	}
+
+	if (span.x2 > bands[b].x2)
+	{
+	    cmd->u.span.x2 = bands[b].x2;
+	}
+    }
+}
+
+
+static void DrawBand (void *data, int band)
+{
+    drawband_t*	b = &bands[band];
+    drawcmd_t*	cmd;
+    int		i;
+
+    for (i = 0, cmd = b->cmds; i < b->numcmds; i++, cmd++)
+    {
+	if (cmd->colfunc != NULL)
+	{
+	    cmd->colfunc(&cmd->u.column);
+	}
+	else
+	{
+	    cmd->spanfunc(&cmd->u.span);
+	}
+    }
+}
+
+
+void R_FlushDraws (void)
+{
+    int		i;
+
+    if (!drawsqueued)
+    {
+	return;
+    }
+
+    I_RunJobs(workers, DrawBand, NULL, numbands);
+
+    for (i = 0; i < numbands; i++)
+    {
+	bands[i].numcmds = 0;
+    }
+
+    drawsqueued = false;
+}
+
+
+void R_SetupRenderThreads (void)
+{
+    int		b;
+    int		x;
+
+    if (workers == NULL)
+    {
+	return;
+    }
+
+    R_FlushDraws();
+
+    if (!detailshift)
+    {
+	drawcolumn = R_DrawColumnCmd;
+	drawfuzzcolumn = R_DrawFuzzColumnCmd;
+	drawtranscolumn = R_DrawTranslatedColumnCmd;
+	drawspan = R_DrawSpanCmd;
+    }
+    else
+    {
+	drawcolumn = R_DrawColumnLowCmd;
+	drawfuzzcolumn = R_DrawFuzzColumnLowCmd;
+	drawtranscolumn = R_DrawTranslatedColumnLowCmd;
+	drawspan = R_DrawSpanLowCmd;
+    }
+
+    colfunc = basecolfunc = QueueBaseColumn;
+    fuzzcolfunc = QueueFuzzColumn;
+    transcolfunc = QueueTranslatedColumn;
+    spanfunc = QueueSpan;
+
+    // Split the view into bands of (nearly) equal width.
+    numbands = renderthreads * BANDSPERTHREAD;
+
+    if (numbands > viewwidth)
+    {
+	numbands = viewwidth;
+    }
+
+    for (b = 0; b < numbands; b++)
+    {
+	bands[b].x1 = (b * viewwidth) / numbands;
+	bands[b].x2 = ((b + 1) * viewwidth) / numbands - 1;
+
+	for (x = bands[b].x1; x <= bands[b].x2; x++)
+	{
+	    bandforx[x] = b;
+	}
+    }
+}
+
+
+void R_InitRenderThreads (void)
+{
+    int		p;
+
+    //!
+    // @arg <n>
+    // @category video
+    //
+    // Draw the player view using n threads, each drawing its own
+    // vertical bands of the screen.  The output is identical to
+    // drawing with a single thread.
+    //
+
+    p = M_CheckParmWithArgs("-renderthreads", 1);
+
+    if (p > 0)
+    {
+	renderthreads = atoi(myargv[p + 1]);
+    }
+
+    if (renderthreads > MAXRENDERTHREADS)
+    {
+	renderthreads = MAXRENDERTHREADS;
+    }
+
+    if (renderthreads <= 1)
+    {
+	renderthreads = 1;
+	return;
+    }
+
+    // The thread calling R_FlushDraws does its share of the work.
+    workers = I_CreateWorkers(renderthreads - 1, "render");
+
+    // Draw everything queued before the zone purges data it reads.
+    Z_SetPurgeHook(R_FlushDraws);
+}
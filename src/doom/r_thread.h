@@ -0,0 +1,37 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Multi-threaded drawing of the player view.
+//
+
+
+#ifndef __R_THREAD__
+#define __R_THREAD__
+
+// Number of threads drawing the view, 1 if drawing is not threaded.
+extern int	renderthreads;
+
+// Reads -renderthreads and starts the worker threads.
+void R_InitRenderThreads (void);
+
+// Called when the view size or detail level changes.
+// Hooks the column and span functions if drawing is threaded.
+void R_SetupRenderThreads (void);
+
+// Draws everything queued so far, across all threads.
+// Also called by the zone before it purges anything.
+void R_FlushDraws (void);
+
+#endif
@@ -1063,6 +1063,7 @@ void D_DoomMain(void)
 
     tprintf(DEH_String("S_Init: Setting up sound.\n"), 1);
     S_Init();
+    I_CheckRenderMusic();
     //IO_StartupTimer();
     S_Start();
 
@@ -481,6 +481,7 @@ void D_DoomMain(void)
     D_ConnectNetGame();
 
     S_Init();
+    I_CheckRenderMusic();
     S_Start();
 
     ST_Message("ST_Init: Init startup screen.\n");
@@ -226,6 +226,7 @@ typedef struct mobj_s
     short tid;                  // thing identifier
     byte special;               // special
     byte args[5];               // special arguments
+    int tidslot;                // position in the TID list, if in it
 } mobj_t;
 
 // each sector has a degenmobj_t in it's center for sound origin purposes
@@ -18,6 +18,8 @@
 // HEADER FILES ------------------------------------------------------------
 
 #include "h2def.h"
+#include "i_timer.h"
+#include "m_argv.h"
 #include "m_misc.h"
 #include "m_random.h"
 #include "s_sound.h"
@@ -184,7 +186,6 @@ acsstore_t ACSStore[MAX_ACS_STORE + 1]; // +1 for termination marker
 
 // PRIVATE DATA DEFINITIONS ------------------------------------------------
 
-static char EvalContext[64];
 static acs_t *ACScript;
 static unsigned int PCodeOffset;
 static byte SpecArgs[8];
@@ -193,110 +194,151 @@ static char **ACStrings;
 static char PrintBuffer[PRINT_BUFFER_SIZE];
 static acs_t *NewScript;
 
-static int (*PCodeCmds[]) (void) =
-{
-        CmdNOP,
-        CmdTerminate,
-        CmdSuspend,
-        CmdPushNumber,
-        CmdLSpec1,
-        CmdLSpec2,
-        CmdLSpec3,
-        CmdLSpec4,
-        CmdLSpec5,
-        CmdLSpec1Direct,
-        CmdLSpec2Direct,
-        CmdLSpec3Direct,
-        CmdLSpec4Direct,
-        CmdLSpec5Direct,
-        CmdAdd,
-        CmdSubtract,
-        CmdMultiply,
-        CmdDivide,
-        CmdModulus,
-        CmdEQ,
-        CmdNE,
-        CmdLT,
-        CmdGT,
-        CmdLE,
-        CmdGE,
-        CmdAssignScriptVar,
-        CmdAssignMapVar,
-        CmdAssignWorldVar,
-        CmdPushScriptVar,
-        CmdPushMapVar,
-        CmdPushWorldVar,
-        CmdAddScriptVar,
-        CmdAddMapVar,
-        CmdAddWorldVar,
-        CmdSubScriptVar,
-        CmdSubMapVar,
-        CmdSubWorldVar,
-        CmdMulScriptVar,
-        CmdMulMapVar,
-        CmdMulWorldVar,
-        CmdDivScriptVar,
-        CmdDivMapVar,
-        CmdDivWorldVar,
-        CmdModScriptVar,
-        CmdModMapVar,
-        CmdModWorldVar,
-        CmdIncScriptVar,
-        CmdIncMapVar,
-        CmdIncWorldVar,
-        CmdDecScriptVar,
-        CmdDecMapVar,
-        CmdDecWorldVar,
-        CmdGoto,
-        CmdIfGoto,
-        CmdDrop,
-        CmdDelay,
-        CmdDelayDirect,
-        CmdRandom,
-        CmdRandomDirect,
-        CmdThingCount,
-        CmdThingCountDirect,
-        CmdTagWait,
-        CmdTagWaitDirect,
-        CmdPolyWait,
-        CmdPolyWaitDirect,
-        CmdChangeFloor,
-        CmdChangeFloorDirect,
-        CmdChangeCeiling,
-        CmdChangeCeilingDirect,
-        CmdRestart,
-        CmdAndLogical,
-        CmdOrLogical,
-        CmdAndBitwise,
-        CmdOrBitwise,
-        CmdEorBitwise,
-        CmdNegateLogical,
-        CmdLShift,
-        CmdRShift,
-        CmdUnaryMinus,
-        CmdIfNotGoto,
-        CmdLineSide,
-        CmdScriptWait,
-        CmdScriptWaitDirect,
-        CmdClearLineSpecial,
-        CmdCaseGoto,
-        CmdBeginPrint,
-        CmdEndPrint,
-        CmdPrintString,
-        CmdPrintNumber,
-        CmdPrintCharacter,
-        CmdPlayerCount,
-        CmdGameType,
-        CmdGameSkill,
-        CmdTimer,
-        CmdSectorSound,
-        CmdAmbientSound,
-        CmdSoundSequence,
-        CmdSetLineTexture,
-        CmdSetLineBlocking,
-        CmdSetLineSpecial,
-        CmdThingSound,
-        CmdEndPrintBold,
+// Context for ACSAssert() messages.  This is only turned into a string
+// if an assertion fails: the lump being parsed while loading (-1 once
+// loaded), otherwise the offset of the instruction being executed and
+// the instruction itself (-1 until it has been read).
+
+static int EvalLump = -1;
+static unsigned int EvalOffset;
+static int EvalCmd;
+
+// Instructions that have been decoded and checked by DecodeScript(),
+// indexed by lump offset.  Entries not (yet) known to be valid are
+// PCODE_UNCHECKED; these are read and checked as they run instead, so
+// that bad code only causes an error if it is actually executed.
+
+#define PCODE_UNCHECKED 0xff
+static byte *PCodeOps;
+
+// Per-script statistics shown with -acsstats.
+
+typedef struct
+{
+    int number;
+    int runs;
+    uint64_t instructions;
+    uint64_t time;
+} acsstats_t;
+
+static boolean acsstats = false;
+static acsstats_t *ACSStats = NULL;
+static int ACSStatsCount = 0;
+static int ACSStatsMap;
+
+// Instruction table.  Each has its immediate operands listed in 'args':
+//   i - integer           o - lump offset (jump target)
+//   s - script variable   m - map variable    w - world variable
+//   t - string index
+
+static const struct
+{
+    int (*func)(void);
+    const char *args;
+} PCodeCmds[] =
+{
+        { CmdNOP, "" },
+        { CmdTerminate, "" },
+        { CmdSuspend, "" },
+        { CmdPushNumber, "i" },
+        { CmdLSpec1, "i" },
+        { CmdLSpec2, "i" },
+        { CmdLSpec3, "i" },
+        { CmdLSpec4, "i" },
+        { CmdLSpec5, "i" },
+        { CmdLSpec1Direct, "ii" },
+        { CmdLSpec2Direct, "iii" },
+        { CmdLSpec3Direct, "iiii" },
+        { CmdLSpec4Direct, "iiiii" },
+        { CmdLSpec5Direct, "iiiiii" },
+        { CmdAdd, "" },
+        { CmdSubtract, "" },
+        { CmdMultiply, "" },
+        { CmdDivide, "" },
+        { CmdModulus, "" },
+        { CmdEQ, "" },
+        { CmdNE, "" },
+        { CmdLT, "" },
+        { CmdGT, "" },
+        { CmdLE, "" },
+        { CmdGE, "" },
+        { CmdAssignScriptVar, "s" },
+        { CmdAssignMapVar, "m" },
+        { CmdAssignWorldVar, "w" },
+        { CmdPushScriptVar, "s" },
+        { CmdPushMapVar, "m" },
+        { CmdPushWorldVar, "w" },
+        { CmdAddScriptVar, "s" },
+        { CmdAddMapVar, "m" },
+        { CmdAddWorldVar, "w" },
+        { CmdSubScriptVar, "s" },
+        { CmdSubMapVar, "m" },
+        { CmdSubWorldVar, "w" },
+        { CmdMulScriptVar, "s" },
+        { CmdMulMapVar, "m" },
+        { CmdMulWorldVar, "w" },
+        { CmdDivScriptVar, "s" },
+        { CmdDivMapVar, "m" },
+        { CmdDivWorldVar, "w" },
+        { CmdModScriptVar, "s" },
+        { CmdModMapVar, "m" },
+        { CmdModWorldVar, "w" },
+        { CmdIncScriptVar, "s" },
+        { CmdIncMapVar, "m" },
+        { CmdIncWorldVar, "w" },
+        { CmdDecScriptVar, "s" },
+        { CmdDecMapVar, "m" },
+        { CmdDecWorldVar, "w" },
+        { CmdGoto, "o" },
+        { CmdIfGoto, "o" },
+        { CmdDrop, "" },
+        { CmdDelay, "" },
+        { CmdDelayDirect, "i" },
+        { CmdRandom, "" },
+        { CmdRandomDirect, "ii" },
+        { CmdThingCount, "" },
+        { CmdThingCountDirect, "ii" },
+        { CmdTagWait, "" },
+        { CmdTagWaitDirect, "i" },
+        { CmdPolyWait, "" },
+        { CmdPolyWaitDirect, "i" },
+        { CmdChangeFloor, "" },
+        { CmdChangeFloorDirect, "it" },
+        { CmdChangeCeiling, "" },
+        { CmdChangeCeilingDirect, "it" },
+        { CmdRestart, "" },
+        { CmdAndLogical, "" },
+        { CmdOrLogical, "" },
+        { CmdAndBitwise, "" },
+        { CmdOrBitwise, "" },
+        { CmdEorBitwise, "" },
+        { CmdNegateLogical, "" },
+        { CmdLShift, "" },
+        { CmdRShift, "" },
+        { CmdUnaryMinus, "" },
+        { CmdIfNotGoto, "o" },
+        { CmdLineSide, "" },
+        { CmdScriptWait, "" },
+        { CmdScriptWaitDirect, "i" },
+        { CmdClearLineSpecial, "" },
+        { CmdCaseGoto, "io" },
+        { CmdBeginPrint, "" },
+        { CmdEndPrint, "" },
+        { CmdPrintString, "" },
+        { CmdPrintNumber, "" },
+        { CmdPrintCharacter, "" },
+        { CmdPlayerCount, "" },
+        { CmdGameType, "" },
+        { CmdGameSkill, "" },
+        { CmdTimer, "" },
+        { CmdSectorSound, "" },
+        { CmdAmbientSound, "" },
+        { CmdSoundSequence, "" },
+        { CmdSetLineTexture, "" },
+        { CmdSetLineBlocking, "" },
+        { CmdSetLineSpecial, "" },
+        { CmdThingSound, "" },
+        { CmdEndPrintBold, "" },
 };
 
 // CODE --------------------------------------------------------------------
@@ -323,7 +365,23 @@ static void ACSAssert(int condition, const char *fmt, ...)
     va_start(args, fmt);
     M_vsnprintf(buf, sizeof(buf), fmt, args);
     va_end(args);
-    I_Error("ACS assertion failure: in %s: %s", EvalContext, buf);
+
+    if (EvalLump >= 0)
+    {
+        I_Error("ACS assertion failure: in header parsing of lump #%d: %s",
+                EvalLump, buf);
+    }
+    else if (EvalCmd < 0)
+    {
+        I_Error("ACS assertion failure: in script %d @0x%x: %s",
+                ACSInfo[ACScript->infoIndex].number, EvalOffset, buf);
+    }
+    else
+    {
+        I_Error("ACS assertion failure: in script %d @0x%x, cmd=%d: %s",
+                ACSInfo[ACScript->infoIndex].number, EvalOffset, EvalCmd,
+                buf);
+    }
 }
 
 //==========================================================================
@@ -440,6 +498,211 @@ static int ReadOffset(void)
     return offset;
 }
 
+//==========================================================================
+//
+// CheckOperand
+//
+// Check an immediate operand of the given kind (see PCodeCmds) the same
+// way as the Read functions above, but without raising an error.
+//
+//==========================================================================
+
+static boolean CheckOperand(char kind, int value)
+{
+    switch (kind)
+    {
+        case 's':
+            return value >= 0 && value < MAX_ACS_SCRIPT_VARS;
+        case 'm':
+            return value >= 0 && value < MAX_ACS_MAP_VARS;
+        case 'w':
+            return value >= 0 && value < MAX_ACS_WORLD_VARS;
+        case 'o':
+            return value >= 0 && value < ActionCodeSize;
+        case 't':
+            return value >= 0 && value < ACStringCount;
+        default:
+            return true;
+    }
+}
+
+//==========================================================================
+//
+// CheckInstruction
+//
+// Check the instruction at the given offset and its operands, returning
+// the instruction, or -1 if it is not valid.  The offset of the next
+// instruction is stored in *next, and any jump target in *target.
+//
+//==========================================================================
+
+static int CheckInstruction(int offset, int *next, int *target)
+{
+    const char *args;
+    int *ptr;
+    int cmd;
+
+    ptr = (int *) (ActionCodeBase + offset);
+    *next = offset + 4;
+
+    if (*next > ActionCodeSize)
+    {
+        return -1;
+    }
+
+    cmd = LONG(*ptr);
+
+    if (cmd < 0 || cmd >= arrlen(PCodeCmds))
+    {
+        return -1;
+    }
+
+    for (args = PCodeCmds[cmd].args; *args != '\0'; ++args)
+    {
+        ++ptr;
+        *next += 4;
+
+        if (*next > ActionCodeSize || !CheckOperand(*args, LONG(*ptr)))
+        {
+            return -1;
+        }
+
+        if (*args == 'o')
+        {
+            *target = LONG(*ptr);
+        }
+    }
+
+    return cmd;
+}
+
+//==========================================================================
+//
+// DecodeScript
+//
+// Follow the code of a script from the given offset, checking each
+// instruction that can be reached and recording it in PCodeOps so that
+// T_InterpretACS() need not check it again.  Code that fails the checks
+// is left unchecked, to give the usual error if it is ever run.
+//
+//==========================================================================
+
+static void DecodeScript(int offset)
+{
+    static int *pending = NULL;
+    static int pending_size = 0;
+    int num_pending;
+    int cmd, next, target;
+
+    num_pending = 0;
+
+    for (;;)
+    {
+        while (offset >= 0 && offset < ActionCodeSize
+            && PCodeOps[offset] == PCODE_UNCHECKED)
+        {
+            target = -1;
+            cmd = CheckInstruction(offset, &next, &target);
+
+            if (cmd < 0)
+            {
+                break;
+            }
+
+            PCodeOps[offset] = cmd;
+
+            // Follow jumps once this run of code has been done.
+
+            if (target >= 0)
+            {
+                if (num_pending >= pending_size)
+                {
+                    pending_size = pending_size ? pending_size * 2 : 64;
+                    pending = I_Realloc(pending, pending_size * sizeof(int));
+                }
+
+                pending[num_pending++] = target;
+            }
+
+            // Carry on to the next instruction, unless this one never
+            // does.
+
+            if (PCodeCmds[cmd].func == CmdTerminate
+             || PCodeCmds[cmd].func == CmdGoto
+             || PCodeCmds[cmd].func == CmdRestart)
+            {
+                break;
+            }
+
+            offset = next;
+        }
+
+        if (num_pending == 0)
+        {
+            break;
+        }
+
+        offset = pending[--num_pending];
+    }
+}
+
+//==========================================================================
+//
+// PrintACSStats
+//
+//==========================================================================
+
+static void PrintACSStats(void)
+{
+    acsstats_t *stats;
+    int i;
+
+    if (ACSStatsCount == 0)
+    {
+        return;
+    }
+
+    printf("ACS statistics for map %d:\n", ACSStatsMap);
+    printf("  %6s %8s %12s %10s\n", "script", "runs", "instructions",
+           "time (us)");
+
+    for (i = 0, stats = ACSStats; i < ACSStatsCount; i++, stats++)
+    {
+        if (stats->runs > 0)
+        {
+            printf("  %6d %8d %12" PRIu64 " %10" PRIu64 "\n",
+                   stats->number, stats->runs, stats->instructions,
+                   stats->time);
+        }
+    }
+
+    ACSStatsCount = 0;
+}
+
+//==========================================================================
+//
+// P_InitACS
+//
+//==========================================================================
+
+void P_InitACS(void)
+{
+    //!
+    // @category obscure
+    //
+    // Count the number of times each ACS script runs, the instructions
+    // it executes and the time it takes, and print the totals when
+    // leaving each map.
+    //
+
+    acsstats = M_ParmExists("-acsstats");
+
+    if (acsstats)
+    {
+        I_AtExit(PrintACSStats, false);
+    }
+}
+
 //==========================================================================
 //
 // P_LoadACScripts
@@ -452,11 +715,18 @@ void P_LoadACScripts(int lump)
     acsHeader_t *header;
     acsInfo_t *info;
 
+    if (acsstats)
+    {
+        PrintACSStats();
+    }
+
     ActionCodeBase = W_CacheLumpNum(lump, PU_LEVEL);
     ActionCodeSize = W_LumpLength(lump);
 
-    M_snprintf(EvalContext, sizeof(EvalContext),
-               "header parsing of lump #%d", lump);
+    PCodeOps = Z_Malloc(ActionCodeSize, PU_LEVEL, NULL);
+    memset(PCodeOps, PCODE_UNCHECKED, ActionCodeSize);
+
+    EvalLump = lump;
 
     header = (acsHeader_t *) ActionCodeBase;
     PCodeOffset = LONG(header->infoOffset);
@@ -465,6 +735,7 @@ void P_LoadACScripts(int lump)
 
     if (ACScriptCount == 0)
     {                           // Empty behavior lump
+        EvalLump = -1;
         return;
     }
 
@@ -510,6 +781,26 @@ void P_LoadACScripts(int lump)
                   "string %d missing terminating NUL", i);
     }
 
+    EvalLump = -1;
+
+    for (i = 0; i < ACScriptCount; i++)
+    {
+        DecodeScript(ACSInfo[i].offset);
+    }
+
+    if (acsstats)
+    {
+        ACSStats = I_Realloc(ACSStats, ACScriptCount * sizeof(acsstats_t));
+        memset(ACSStats, 0, ACScriptCount * sizeof(acsstats_t));
+        ACSStatsCount = ACScriptCount;
+        ACSStatsMap = gamemap;
+
+        for (i = 0; i < ACScriptCount; i++)
+        {
+            ACSStats[i].number = ACSInfo[i].number;
+        }
+    }
+
     memset(MapVars, 0, sizeof(MapVars));
 }
 
@@ -773,6 +1064,8 @@ void T_InterpretACS(thinker_t *thinker)
     acs_t *script = (acs_t *) thinker;
     int cmd;
     int action;
+    int instructions;
+    uint64_t start_time = 0;
 
     if (ACSInfo[script->infoIndex].state == ASTE_TERMINATING)
     {
@@ -790,26 +1083,52 @@ void T_InterpretACS(thinker_t *thinker)
         script->delayCount--;
         return;
     }
+    if (acsstats)
+    {
+        start_time = I_GetTimeUS();
+    }
+
     ACScript = script;
     PCodeOffset = ACScript->ip;
+    instructions = 0;
 
     do
     {
-        M_snprintf(EvalContext, sizeof(EvalContext), "script %d @0x%x",
-                   ACSInfo[script->infoIndex].number, PCodeOffset);
-        cmd = ReadCodeInt();
-        M_snprintf(EvalContext, sizeof(EvalContext), "script %d @0x%x, cmd=%d",
-                   ACSInfo[script->infoIndex].number, PCodeOffset, cmd);
-        ACSAssert(cmd >= 0, "negative ACS instruction %d", cmd);
-        ACSAssert(cmd < arrlen(PCodeCmds),
-                  "invalid ACS instruction %d (maybe this WAD is designed "
-                  "for an advanced source port and is not vanilla "
-                  "compatible)", cmd);
-        action = PCodeCmds[cmd]();
+        EvalOffset = PCodeOffset;
+
+        if (PCodeOffset < ActionCodeSize
+         && PCodeOps[PCodeOffset] != PCODE_UNCHECKED)
+        {
+            // Already checked by DecodeScript().
+            cmd = PCodeOps[PCodeOffset];
+            EvalCmd = cmd;
+            PCodeOffset += 4;
+        }
+        else
+        {
+            EvalCmd = -1;
+            cmd = ReadCodeInt();
+            EvalCmd = cmd;
+            ACSAssert(cmd >= 0, "negative ACS instruction %d", cmd);
+            ACSAssert(cmd < arrlen(PCodeCmds),
+                      "invalid ACS instruction %d (maybe this WAD is "
+                      "designed for an advanced source port and is not "
+                      "vanilla compatible)", cmd);
+        }
+
+        action = PCodeCmds[cmd].func();
+        ++instructions;
     } while (action == SCRIPT_CONTINUE);
 
     ACScript->ip = PCodeOffset;
 
+    if (acsstats && script->infoIndex < ACSStatsCount)
+    {
+        ACSStats[script->infoIndex].runs++;
+        ACSStats[script->infoIndex].instructions += instructions;
+        ACSStats[script->infoIndex].time += I_GetTimeUS() - start_time;
+    }
+
     if (action == SCRIPT_TERMINATE)
     {
         ACSInfo[script->infoIndex].state = ASTE_INACTIVE;
@@ -26,10 +26,22 @@
 
 // MACROS ------------------------------------------------------------------
 
-#define MAX_TID_COUNT 200
+#define TID_HASH_SIZE 128
 
 // TYPES -------------------------------------------------------------------
 
+// A slot in the TID list.  Slots are numbered as in the original fixed
+// array, which is what the search positions passed to P_FindMobjFromTID
+// refer to.  Each slot in use is also on the chain for its hash bucket,
+// in slot order.
+
+typedef struct
+{
+    int tid;
+    mobj_t *mobj;               // NULL if the slot is empty
+    int prev, next;             // Hash chain, -1 at either end
+} tidslot_t;
+
 // EXTERNAL FUNCTION PROTOTYPES --------------------------------------------
 
 void G_PlayerReborn(int player);
@@ -72,8 +84,19 @@ fixed_t FloatBobOffsets[64] = {
 
 // PRIVATE DATA DEFINITIONS ------------------------------------------------
 
-static int TIDList[MAX_TID_COUNT + 1];  // +1 for termination marker
-static mobj_t *TIDMobj[MAX_TID_COUNT];
+static tidslot_t *TIDSlots = NULL;
+static int TIDSlotsSize = 0;
+static int TIDCount;                    // Slots before the end marker
+
+static int TIDHashHead[TID_HASH_SIZE];
+static int TIDHashTail[TID_HASH_SIZE];
+
+// Empty slots before the end marker, as a heap with the lowest first,
+// since that is the one that gets reused.
+
+static int *TIDFree = NULL;
+static int TIDFreeSize = 0;
+static int TIDFreeCount;
 
 // CODE --------------------------------------------------------------------
 
@@ -1178,6 +1201,7 @@ mobj_t *P_SpawnMobj(fixed_t x, fixed_t y, fixed_t z, mobjtype_t type)
     memset(mobj, 0, sizeof(*mobj));
     info = &mobjinfo[type];
     mobj->type = type;
+    mobj->tidslot = -1;
     mobj->info = info;
     mobj->x = x;
     mobj->y = y;
@@ -1621,6 +1645,171 @@ void P_SpawnMapThing(mapthing_t * mthing)
     }
 }
 
+//==========================================================================
+//
+// TIDHash
+//
+//==========================================================================
+
+static int TIDHash(int tid)
+{
+    return tid & (TID_HASH_SIZE - 1);
+}
+
+//==========================================================================
+//
+// LinkTIDSlot
+//
+// Put a slot on its hash chain, keeping the chain in slot order.  New
+// slots at the end of the list go straight on the end of the chain.
+//
+//==========================================================================
+
+static void LinkTIDSlot(int slot)
+{
+    int hash = TIDHash(TIDSlots[slot].tid);
+    int next;
+
+    next = -1;
+    if (TIDHashTail[hash] > slot)
+    {                           // Reusing an empty slot
+        for (next = TIDHashHead[hash]; next < slot;
+             next = TIDSlots[next].next);
+    }
+
+    TIDSlots[slot].next = next;
+    if (next == -1)
+    {
+        TIDSlots[slot].prev = TIDHashTail[hash];
+        TIDHashTail[hash] = slot;
+    }
+    else
+    {
+        TIDSlots[slot].prev = TIDSlots[next].prev;
+        TIDSlots[next].prev = slot;
+    }
+
+    if (TIDSlots[slot].prev == -1)
+    {
+        TIDHashHead[hash] = slot;
+    }
+    else
+    {
+        TIDSlots[TIDSlots[slot].prev].next = slot;
+    }
+}
+
+//==========================================================================
+//
+// UnlinkTIDSlot
+//
+//==========================================================================
+
+static void UnlinkTIDSlot(int slot)
+{
+    int hash = TIDHash(TIDSlots[slot].tid);
+    tidslot_t *s = &TIDSlots[slot];
+
+    if (s->prev == -1)
+    {
+        TIDHashHead[hash] = s->next;
+    }
+    else
+    {
+        TIDSlots[s->prev].next = s->next;
+    }
+
+    if (s->next == -1)
+    {
+        TIDHashTail[hash] = s->prev;
+    }
+    else
+    {
+        TIDSlots[s->next].prev = s->prev;
+    }
+
+    s->mobj = NULL;
+}
+
+//==========================================================================
+//
+// PushFreeTIDSlot
+//
+//==========================================================================
+
+static void PushFreeTIDSlot(int slot)
+{
+    int i, parent;
+
+    if (TIDFreeCount == TIDFreeSize)
+    {
+        TIDFreeSize = TIDFreeSize ? TIDFreeSize * 2 : 64;
+        TIDFree = I_Realloc(TIDFree, TIDFreeSize * sizeof(int));
+    }
+
+    for (i = TIDFreeCount++; i > 0; i = parent)
+    {
+        parent = (i - 1) / 2;
+        if (TIDFree[parent] < slot)
+        {
+            break;
+        }
+        TIDFree[i] = TIDFree[parent];
+    }
+    TIDFree[i] = slot;
+}
+
+//==========================================================================
+//
+// PopFreeTIDSlot
+//
+// Take the lowest empty slot.
+//
+//==========================================================================
+
+static int PopFreeTIDSlot(void)
+{
+    int result, last;
+    int i, child;
+
+    result = TIDFree[0];
+    last = TIDFree[--TIDFreeCount];
+
+    for (i = 0; (child = 2 * i + 1) < TIDFreeCount; i = child)
+    {
+        if (child + 1 < TIDFreeCount && TIDFree[child + 1] < TIDFree[child])
+        {
+            child++;
+        }
+        if (last < TIDFree[child])
+        {
+            break;
+        }
+        TIDFree[i] = TIDFree[child];
+    }
+    TIDFree[i] = last;
+
+    return result;
+}
+
+//==========================================================================
+//
+// AllocTIDSlot
+//
+//==========================================================================
+
+static int AllocTIDSlot(void)
+{
+    if (TIDCount == TIDSlotsSize)
+    {
+        TIDSlotsSize = TIDSlotsSize ? TIDSlotsSize * 2 : 256;
+        TIDSlots = I_Realloc(TIDSlots, TIDSlotsSize * sizeof(tidslot_t));
+    }
+
+    TIDSlots[TIDCount].mobj = NULL;
+    return TIDCount++;
+}
+
 //==========================================================================
 //
 // P_CreateTIDList
@@ -1633,7 +1822,14 @@ void P_CreateTIDList(void)
     mobj_t *mobj;
     thinker_t *t;
 
-    i = 0;
+    TIDCount = 0;
+    TIDFreeCount = 0;
+    for (i = 0; i < TID_HASH_SIZE; i++)
+    {
+        TIDHashHead[i] = -1;
+        TIDHashTail[i] = -1;
+    }
+
     for (t = thinkercap.next; t != &thinkercap; t = t->next)
     {                           // Search all current thinkers
         if (t->function != P_MobjThinker)
@@ -1643,17 +1839,17 @@ void P_CreateTIDList(void)
         mobj = (mobj_t *) t;
         if (mobj->tid != 0)
         {                       // Add to list
-            if (i == MAX_TID_COUNT)
-            {
-                I_Error("P_CreateTIDList: MAX_TID_COUNT (%d) exceeded.",
-                        MAX_TID_COUNT);
-            }
-            TIDList[i] = mobj->tid;
-            TIDMobj[i++] = mobj;
+            i = AllocTIDSlot();
+            TIDSlots[i].tid = mobj->tid;
+            TIDSlots[i].mobj = mobj;
+            mobj->tidslot = i;
+            LinkTIDSlot(i);
+        }
+        else
+        {
+            mobj->tidslot = -1;
         }
     }
-    // Add termination marker
-    TIDList[i] = 0;
 }
 
 //==========================================================================
@@ -1667,28 +1863,44 @@ void P_InsertMobjIntoTIDList(mobj_t * mobj, int tid)
     int i;
     int index;
 
-    index = -1;
-    for (i = 0; TIDList[i] != 0; i++)
+    mobj->tid = tid;
+
+    if (tid == 0)
     {
-        if (TIDList[i] == -1)
-        {                       // Found empty slot
-            index = i;
-            break;
+        mobj->tidslot = -1;
+
+        // The original list ended at the first zero TID, so giving a
+        // thing TID 0 like this cut off everything from the first
+        // empty slot onwards.  Keep doing the same.
+
+        if (TIDFreeCount > 0)
+        {
+            index = PopFreeTIDSlot();
+            for (i = index + 1; i < TIDCount; i++)
+            {
+                if (TIDSlots[i].mobj != NULL)
+                {
+                    UnlinkTIDSlot(i);
+                }
+            }
+            TIDCount = index;
+            TIDFreeCount = 0;
         }
+        return;
     }
-    if (index == -1)
+
+    if (TIDFreeCount > 0)
+    {                           // Reuse empty slot
+        index = PopFreeTIDSlot();
+    }
+    else
     {                           // Append required
-        if (i == MAX_TID_COUNT)
-        {
-            I_Error("P_InsertMobjIntoTIDList: MAX_TID_COUNT (%d)"
-                    "exceeded.", MAX_TID_COUNT);
-        }
-        index = i;
-        TIDList[index + 1] = 0;
+        index = AllocTIDSlot();
     }
-    mobj->tid = tid;
-    TIDList[index] = tid;
-    TIDMobj[index] = mobj;
+    TIDSlots[index].tid = tid;
+    TIDSlots[index].mobj = mobj;
+    mobj->tidslot = index;
+    LinkTIDSlot(index);
 }
 
 //==========================================================================
@@ -1699,19 +1911,15 @@ void P_InsertMobjIntoTIDList(mobj_t * mobj, int tid)
 
 void P_RemoveMobjFromTIDList(mobj_t * mobj)
 {
-    int i;
+    int i = mobj->tidslot;
 
-    for (i = 0; TIDList[i] != 0; i++)
+    if (i >= 0 && i < TIDCount && TIDSlots[i].mobj == mobj)
     {
-        if (TIDMobj[i] == mobj)
-        {
-            TIDList[i] = -1;
-            TIDMobj[i] = NULL;
-            mobj->tid = 0;
-            return;
-        }
+        UnlinkTIDSlot(i);
+        PushFreeTIDSlot(i);
     }
     mobj->tid = 0;
+    mobj->tidslot = -1;
 }
 
 //==========================================================================
@@ -1722,14 +1930,29 @@ void P_RemoveMobjFromTIDList(mobj_t * mobj)
 
 mobj_t *P_FindMobjFromTID(int tid, int *searchPosition)
 {
-    int i;
+    int hash = TIDHash(tid);
+    int i = *searchPosition;
+
+    // Carry on along the hash chain from the last thing found if it is
+    // still there, otherwise find the place in the chain.
+
+    if (i >= 0 && i < TIDCount && TIDSlots[i].mobj != NULL
+     && TIDHash(TIDSlots[i].tid) == hash)
+    {
+        i = TIDSlots[i].next;
+    }
+    else
+    {
+        for (i = TIDHashHead[hash]; i != -1 && i <= *searchPosition;
+             i = TIDSlots[i].next);
+    }
 
-    for (i = *searchPosition + 1; TIDList[i] != 0; i++)
+    for (; i != -1; i = TIDSlots[i].next)
     {
-        if (TIDList[i] == tid)
+        if (TIDSlots[i].tid == tid)
         {
             *searchPosition = i;
-            return TIDMobj[i];
+            return TIDSlots[i].mobj;
         }
     }
     *searchPosition = -1;
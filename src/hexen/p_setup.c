@@ -708,6 +708,7 @@ void P_SetupLevel(int episode, int map, int playermask, skill_t skill)
     P_LoadSegs(lumpnum + ML_SEGS);
     rejectmatrix = W_CacheLumpNum(lumpnum + ML_REJECT, PU_LEVEL);
     P_GroupLines();
+    P_InitTagLists();
     bodyqueslot = 0;
     po_NumPolyobjs = 0;
     deathmatch_p = deathmatchstarts;
@@ -1199,6 +1200,7 @@ void P_Init(void)
     P_InitFTAnims();            // Init flat and texture animations
     P_InitTerrainTypes();
     P_InitLava();
+    P_InitACS();
     R_InitSprites(sprnames);
 }
 
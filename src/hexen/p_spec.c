@@ -327,6 +327,32 @@ int     P_FindSectorFromLineTag(line_t  *line,int start)
 }
 */
 
+//=========================================================================
+//
+// P_InitTagLists
+//
+// Hash the sectors by tag, so that finding the sectors for a tag does
+// not mean searching them all.  Each chain is built backwards so that
+// it runs in sector order.
+//
+//=========================================================================
+
+void P_InitTagLists(void)
+{
+    int i, j;
+
+    for (i = 0; i < numsectors; i++)
+    {
+        sectors[i].firsttag = -1;
+    }
+    for (i = numsectors - 1; i >= 0; i--)
+    {
+        j = (unsigned int) sectors[i].tag % (unsigned int) numsectors;
+        sectors[i].nexttag = sectors[j].firsttag;
+        sectors[j].firsttag = i;
+    }
+}
+
 //=========================================================================
 //
 // P_FindSectorFromTag
@@ -337,14 +363,26 @@ int P_FindSectorFromTag(int tag, int start)
 {
     int i;
 
-    for (i = start + 1; i < numsectors; i++)
+    // Carry on along the chain from the last sector found, or find the
+    // place to start on it.
+    if (start >= 0 && start < numsectors && sectors[start].tag == tag)
     {
-        if (sectors[i].tag == tag)
+        i = sectors[start].nexttag;
+    }
+    else
+    {
+        i = sectors[(unsigned int) tag % (unsigned int) numsectors].firsttag;
+        while (i >= 0 && i <= start)
         {
-            return i;
+            i = sectors[i].nexttag;
         }
     }
-    return -1;
+
+    while (i >= 0 && sectors[i].tag != tag)
+    {
+        i = sectors[i].nexttag;
+    }
+    return i;
 }
 
 //==================================================================
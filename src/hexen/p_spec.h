@@ -66,6 +66,7 @@ fixed_t P_FindNextHighestFloor(sector_t * sec, int currentheight);
 fixed_t P_FindLowestCeilingSurrounding(sector_t * sec);
 fixed_t P_FindHighestCeilingSurrounding(sector_t * sec);
 //int P_FindSectorFromLineTag(line_t  *line,int start);
+void P_InitTagLists(void);
 int P_FindSectorFromTag(int tag, int start);
 //int P_FindMinSurroundingLight(sector_t *sector,int max);
 sector_t *getNextSector(line_t * line, sector_t * sec);
@@ -547,6 +548,7 @@ typedef struct
     byte args[4];               // Padded to 4 for alignment
 } acsstore_t;
 
+void P_InitACS(void);
 void P_LoadACScripts(int lump);
 boolean P_StartACS(int number, int map, byte * args, mobj_t * activator,
                    line_t * line, int side);
@@ -82,6 +82,7 @@ typedef struct
     void *specialdata;          // thinker_t for reversable actions
     int linecount;
     struct line_s **lines;      // [linecount] size
+    int firsttag, nexttag;      // hash chains by tag (P_InitTagLists)
 } sector_t;
 
 typedef struct
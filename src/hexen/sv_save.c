@@ -33,6 +33,7 @@
 #define REBORN_SLOT 7
 #define REBORN_DESCRIPTION "TEMP GAME"
 #define MAX_THINKER_SIZE 256
+#define HUB_STORE_SIZE (16 * 1024 * 1024)
 
 // TYPES -------------------------------------------------------------------
 
@@ -84,6 +85,18 @@ typedef struct
     sector_t *sector;
 } ssthinker_t;
 
+// A save file of the base or reborn slot.
+
+typedef struct savefile_s
+{
+    int slot;
+    int map;                    // -1 for the game file, hexN.hxs
+    boolean present;
+    byte *data;                 // NULL if written out to disk
+    int size;
+    struct savefile_s *prev, *next;     // In memory, most recent first
+} savefile_t;
+
 // EXTERNAL FUNCTION PROTOTYPES --------------------------------------------
 
 void P_SpawnPlayer(mapthing_t * mthing);
@@ -118,10 +131,9 @@ static void RestoreMoveCeiling(thinker_t *thinker);
 static void AssertSegment(gameArchiveSegment_t segType);
 static void ClearSaveSlot(int slot);
 static void CopySaveSlot(int sourceSlot, int destSlot);
-static void CopyFile(char *sourceName, char *destName);
-static boolean ExistingFile(char *name);
-static void SV_OpenRead(char *fileName);
-static void SV_OpenWrite(char *fileName);
+static boolean ExistingFile(int slot, int map);
+static void SV_OpenRead(int slot, int map);
+static void SV_OpenWrite(int slot, int map);
 static void SV_Close(void);
 static void SV_Read(void *buffer, int size);
 static byte SV_ReadByte(void);
@@ -151,7 +163,23 @@ static mobj_t **MobjList;
 static mobj_t ***TargetPlayerAddrs;
 static int TargetPlayerCount;
 static boolean SavingPlayers;
-static FILE *SavingFP;
+
+// The file being read or written.
+
+static byte *SaveBuffer;
+static int SaveBufferSize;
+static int SaveLength;
+static int SavePos;
+static int SaveSlot, SaveMap;
+static boolean SaveWriting;
+static savefile_t *SaveFile;    // Stored file being read in place
+
+// Files of the base and reborn slots, by map (the game file last), and
+// those held in memory, in order of use.
+
+static savefile_t SaveFiles[2][MAX_MAPS + 1];
+static savefile_t *SaveFilesHead, *SaveFilesTail;
+static int SaveFilesSize;
 
 // CODE --------------------------------------------------------------------
 
@@ -1968,13 +1996,11 @@ static void StreamOut_floorWaggle_t(thinker_t *thinker)
 
 void SV_SaveGame(int slot, const char *description)
 {
-    char fileName[100];
     char versionText[HXS_VERSION_TEXT_LENGTH];
     unsigned int i;
 
     // Open the output file
-    M_snprintf(fileName, sizeof(fileName), "%shex6.hxs", SavePath);
-    SV_OpenWrite(fileName);
+    SV_OpenWrite(BASE_SLOT, -1);
 
     // Write game save description
     SV_Write(description, HXS_DESCRIPTION_LENGTH);
@@ -2028,13 +2054,10 @@ void SV_SaveGame(int slot, const char *description)
 
 void SV_SaveMap(boolean savePlayers)
 {
-    char fileName[100];
-
     SavingPlayers = savePlayers;
 
     // Open the output file
-    M_snprintf(fileName, sizeof(fileName), "%shex6%02d.hxs", SavePath, gamemap);
-    SV_OpenWrite(fileName);
+    SV_OpenWrite(BASE_SLOT, gamemap);
 
     // Place a header marker
     SV_WriteLong(ASEG_MAP_HEADER);
@@ -2069,7 +2092,6 @@ void SV_SaveMap(boolean savePlayers)
 void SV_LoadGame(int slot)
 {
     int i;
-    char fileName[100];
     char version_text[HXS_VERSION_TEXT_LENGTH];
     player_t playerBackup[MAXPLAYERS];
     mobj_t *mobj;
@@ -2081,14 +2103,11 @@ void SV_LoadGame(int slot)
         CopySaveSlot(slot, BASE_SLOT);
     }
 
-    // Create the name
-    M_snprintf(fileName, sizeof(fileName), "%shex6.hxs", SavePath);
-
     // Load the file
-    SV_OpenRead(fileName);
+    SV_OpenRead(BASE_SLOT, -1);
 
     // Set the save pointer and skip the description field
-    fseek(SavingFP, HXS_DESCRIPTION_LENGTH, SEEK_CUR);
+    SavePos += HXS_DESCRIPTION_LENGTH;
 
     // Check the version text
 
@@ -2098,6 +2117,7 @@ void SV_LoadGame(int slot)
     }
     if (strncmp(version_text, HXS_VERSION_TEXT, HXS_VERSION_TEXT_LENGTH) != 0)
     {                           // Bad version
+        SV_Close();
         return;
     }
 
@@ -2188,7 +2208,6 @@ void SV_MapTeleport(int map, int position)
 {
     int i;
     int j;
-    char fileName[100];
     player_t playerBackup[MAXPLAYERS];
     mobj_t *targetPlayerMobj;
     mobj_t *mobj;
@@ -2230,8 +2249,7 @@ void SV_MapTeleport(int map, int position)
     TargetPlayerAddrs = NULL;
 
     gamemap = map;
-    M_snprintf(fileName, sizeof(fileName), "%shex6%02d.hxs", SavePath, gamemap);
-    if (!deathmatch && ExistingFile(fileName))
+    if (!deathmatch && ExistingFile(BASE_SLOT, gamemap))
     {                           // Unarchive map
         SV_LoadMap();
     }
@@ -2378,10 +2396,7 @@ int SV_GetRebornSlot(void)
 
 boolean SV_RebornSlotAvailable(void)
 {
-    char fileName[100];
-
-    M_snprintf(fileName, sizeof(fileName), "%shex%d.hxs", SavePath, REBORN_SLOT);
-    return ExistingFile(fileName);
+    return ExistingFile(REBORN_SLOT, -1);
 }
 
 //==========================================================================
@@ -2392,19 +2407,14 @@ boolean SV_RebornSlotAvailable(void)
 
 void SV_LoadMap(void)
 {
-    char fileName[100];
-
     // Load a base level
     G_InitNew(gameskill, gameepisode, gamemap);
 
     // Remove all thinkers
     RemoveAllThinkers();
 
-    // Create the name
-    M_snprintf(fileName, sizeof(fileName), "%shex6%02d.hxs", SavePath, gamemap);
-
     // Load the file
-    SV_OpenRead(fileName);
+    SV_OpenRead(BASE_SLOT, gamemap);
 
     AssertSegment(ASEG_MAP_HEADER);
 
@@ -3231,137 +3241,375 @@ static void AssertSegment(gameArchiveSegment_t segType)
 
 //==========================================================================
 //
-// ClearSaveSlot
+// Save files
 //
-// Deletes all save game files associated with a slot number.
+// The files of the base and reborn slots are rewritten on every hub
+// transition, so they are kept in memory rather than on disk.  If they
+// grow past HUB_STORE_SIZE, the least recently used are written out to
+// disk and read back in when next needed.  The other slots hold the
+// player's saved games; they are only ever copied to and from the base
+// slot, and stay on disk.  The files are the same either way.
 //
 //==========================================================================
 
-static void ClearSaveSlot(int slot)
+static boolean IsStoredSlot(int slot)
+{
+    return slot == BASE_SLOT || slot == REBORN_SLOT;
+}
+
+static savefile_t *GetSaveFile(int slot, int map)
+{
+    savefile_t *file;
+
+    file = &SaveFiles[slot == BASE_SLOT ? 0 : 1][map < 0 ? MAX_MAPS : map];
+    file->slot = slot;
+    file->map = map;
+
+    return file;
+}
+
+static void SaveFileName(char *buf, size_t buf_len, int slot, int map)
+{
+    if (map < 0)
+    {
+        M_snprintf(buf, buf_len, "%shex%d.hxs", SavePath, slot);
+    }
+    else
+    {
+        M_snprintf(buf, buf_len, "%shex%d%02d.hxs", SavePath, slot, map);
+    }
+}
+
+//==========================================================================
+//
+// ReadDiskFile
+//
+// Returns the contents of a file, or NULL if it does not exist.
+//
+//==========================================================================
+
+static byte *ReadDiskFile(const char *fileName, int *size)
+{
+    FILE *fp;
+    byte *data;
+
+    fp = M_fopen(fileName, "rb");
+    if (fp == NULL)
+    {
+        return NULL;
+    }
+
+    *size = M_FileLength(fp);
+    data = malloc(*size > 0 ? *size : 1);
+    if (data == NULL || fread(data, 1, *size, fp) < *size)
+    {
+        I_Error("Couldn't read file %s", fileName);
+    }
+    fclose(fp);
+
+    return data;
+}
+
+static void WriteDiskFile(const char *fileName, byte *data, int size)
+{
+    FILE *fp;
+
+    fp = M_fopen(fileName, "wb");
+    if (fp == NULL || fwrite(data, 1, size, fp) < size)
+    {
+        I_Error("Couldn't write to file %s", fileName);
+    }
+    fclose(fp);
+}
+
+//==========================================================================
+//
+// LinkSaveFile / UnlinkSaveFile
+//
+// Keep the list of files held in memory in order of use.
+//
+//==========================================================================
+
+static void LinkSaveFile(savefile_t *file)
+{
+    file->prev = NULL;
+    file->next = SaveFilesHead;
+    if (SaveFilesHead != NULL)
+    {
+        SaveFilesHead->prev = file;
+    }
+    else
+    {
+        SaveFilesTail = file;
+    }
+    SaveFilesHead = file;
+    SaveFilesSize += file->size;
+}
+
+static void UnlinkSaveFile(savefile_t *file)
+{
+    if (file->prev != NULL)
+    {
+        file->prev->next = file->next;
+    }
+    else
+    {
+        SaveFilesHead = file->next;
+    }
+    if (file->next != NULL)
+    {
+        file->next->prev = file->prev;
+    }
+    else
+    {
+        SaveFilesTail = file->prev;
+    }
+    SaveFilesSize -= file->size;
+}
+
+//==========================================================================
+//
+// TrimSaveFiles
+//
+// Write the least recently used files out to disk until those left in
+// memory are within HUB_STORE_SIZE.  The most recent is always kept.
+//
+//==========================================================================
+
+static void TrimSaveFiles(void)
 {
-    int i;
     char fileName[100];
+    savefile_t *file;
 
-    for (i = 0; i < MAX_MAPS; i++)
+    while (SaveFilesSize > HUB_STORE_SIZE && SaveFilesTail != SaveFilesHead)
     {
-        M_snprintf(fileName, sizeof(fileName),
-                   "%shex%d%02d.hxs", SavePath, slot, i);
-        M_remove(fileName);
+        file = SaveFilesTail;
+        SaveFileName(fileName, sizeof(fileName), file->slot, file->map);
+        WriteDiskFile(fileName, file->data, file->size);
+        UnlinkSaveFile(file);
+        free(file->data);
+        file->data = NULL;
     }
-    M_snprintf(fileName, sizeof(fileName), "%shex%d.hxs", SavePath, slot);
-    M_remove(fileName);
 }
 
 //==========================================================================
 //
-// CopySaveSlot
+// LoadSaveFile
 //
-// Copies all the save game files from one slot to another.
+// Make sure a stored file is in memory, reading it back from disk if it
+// was written out, and mark it as the most recently used.
 //
 //==========================================================================
 
-static void CopySaveSlot(int sourceSlot, int destSlot)
+static byte *LoadSaveFile(savefile_t *file)
 {
-    int i;
-    char sourceName[100];
-    char destName[100];
+    char fileName[100];
 
-    for (i = 0; i < MAX_MAPS; i++)
+    if (file->data == NULL)
     {
-        M_snprintf(sourceName, sizeof(sourceName),
-                   "%shex%d%02d.hxs", SavePath, sourceSlot, i);
-        if (ExistingFile(sourceName))
+        SaveFileName(fileName, sizeof(fileName), file->slot, file->map);
+        file->data = ReadDiskFile(fileName, &file->size);
+        if (file->data == NULL)
         {
-            M_snprintf(destName, sizeof(destName),
-                       "%shex%d%02d.hxs", SavePath, destSlot, i);
-            CopyFile(sourceName, destName);
+            I_Error("Could not load savegame %s", fileName);
         }
+        M_remove(fileName);
     }
-    M_snprintf(sourceName, sizeof(sourceName),
-               "%shex%d.hxs", SavePath, sourceSlot);
-    if (ExistingFile(sourceName))
+    else
     {
-        M_snprintf(destName, sizeof(destName),
-                   "%shex%d.hxs", SavePath, destSlot);
-        CopyFile(sourceName, destName);
+        UnlinkSaveFile(file);
+    }
+    LinkSaveFile(file);
+    TrimSaveFiles();
+
+    return file->data;
+}
+
+//==========================================================================
+//
+// FreeSaveFile
+//
+//==========================================================================
+
+static void FreeSaveFile(savefile_t *file)
+{
+    char fileName[100];
+
+    if (!file->present)
+    {
+        return;
+    }
+    if (file->data != NULL)
+    {
+        UnlinkSaveFile(file);
+        free(file->data);
+        file->data = NULL;
     }
     else
     {
-        I_Error("Could not load savegame %s", sourceName);
+        SaveFileName(fileName, sizeof(fileName), file->slot, file->map);
+        M_remove(fileName);
     }
+    file->present = false;
 }
 
 //==========================================================================
 //
-// CopyFile
+// ReadSaveFile
+//
+// Returns a copy of a save file, or NULL if it does not exist.
 //
-// This function was rewritten to copy files with minimal strain on zone
-// allocation and allow for big maps that technically work in vanilla to
-// save without error.
 //==========================================================================
 
-static void CopyFile(char *source_name, char *dest_name)
+static byte *ReadSaveFile(int slot, int map, int *size)
 {
-    const int BUFFER_CHUNK_SIZE = 0x10000;
-
-    byte *buffer;
-    int file_length, file_remaining;
-    FILE *read_handle, *write_handle;
-    int buf_count, read_count, write_count;
+    char fileName[100];
+    savefile_t *file;
+    byte *data;
 
-    read_handle = M_fopen(source_name, "rb");
-    if (read_handle == NULL)
+    if (!IsStoredSlot(slot))
     {
-        I_Error ("Couldn't read file %s", source_name);
+        SaveFileName(fileName, sizeof(fileName), slot, map);
+        return ReadDiskFile(fileName, size);
     }
-    file_length = file_remaining = M_FileLength(read_handle);
-
-    // Vanilla savegame emulation.
-    //
-    // CopyFile() typically calls M_ReadFile() which stores the entire file
-    // in memory: Chocolate Hexen should force an allocation error here
-    // whenever it's appropriate.
 
-    if (vanilla_savegame_limit)
+    file = GetSaveFile(slot, map);
+    if (!file->present)
     {
-        buffer = Z_Malloc(file_length, PU_STATIC, NULL);
-        Z_Free(buffer);
+        return NULL;
+    }
+    LoadSaveFile(file);
+    *size = file->size;
+    data = malloc(*size > 0 ? *size : 1);
+    if (data == NULL)
+    {
+        I_Error("ReadSaveFile: Failed to allocate %d bytes", *size);
     }
+    memcpy(data, file->data, *size);
+
+    return data;
+}
+
+//==========================================================================
+//
+// WriteSaveFile
+//
+// Replace a save file with the given data, which is taken over.
+//
+//==========================================================================
+
+static void WriteSaveFile(int slot, int map, byte *data, int size)
+{
+    char fileName[100];
+    savefile_t *file;
 
-    write_handle = M_fopen(dest_name, "wb");
-    if (write_handle == NULL)
+    if (!IsStoredSlot(slot))
     {
-        I_Error ("Couldn't read file %s", dest_name);
+        SaveFileName(fileName, sizeof(fileName), slot, map);
+        WriteDiskFile(fileName, data, size);
+        free(data);
+        return;
     }
 
-    buffer = Z_Malloc (BUFFER_CHUNK_SIZE, PU_STATIC, NULL);
+    file = GetSaveFile(slot, map);
+    FreeSaveFile(file);
+    file->present = true;
+    file->data = data;
+    file->size = size;
+    LinkSaveFile(file);
+    TrimSaveFiles();
+}
 
-    do
+//==========================================================================
+//
+// ClearSaveSlot
+//
+// Deletes all save game files associated with a slot number.
+//
+//==========================================================================
+
+static void ClearSaveSlot(int slot)
+{
+    int i;
+    char fileName[100];
+
+    if (IsStoredSlot(slot))
     {
-        buf_count = BUFFER_CHUNK_SIZE;
-        if( file_remaining < BUFFER_CHUNK_SIZE)
+        for (i = 0; i < MAX_MAPS; i++)
         {
-            buf_count = file_remaining;
+            FreeSaveFile(GetSaveFile(slot, i));
         }
+        FreeSaveFile(GetSaveFile(slot, -1));
+        return;
+    }
 
-        read_count = fread(buffer, 1, buf_count, read_handle);
-        if (read_count < buf_count)
-        {
-            I_Error ("Couldn't read file %s", source_name);
-        }
+    for (i = 0; i < MAX_MAPS; i++)
+    {
+        SaveFileName(fileName, sizeof(fileName), slot, i);
+        M_remove(fileName);
+    }
+    SaveFileName(fileName, sizeof(fileName), slot, -1);
+    M_remove(fileName);
+}
 
-        write_count = fwrite(buffer, 1, buf_count, write_handle);
-        if (write_count < buf_count)
-        {
-            I_Error ("Couldn't write to file %s", dest_name);
-        }
+//==========================================================================
+//
+// CopySaveFile
+//
+// Returns false if the source file does not exist.
+//
+//==========================================================================
+
+static boolean CopySaveFile(int sourceSlot, int destSlot, int map)
+{
+    byte *data;
+    byte *buffer;
+    int size;
+
+    data = ReadSaveFile(sourceSlot, map, &size);
+    if (data == NULL)
+    {
+        return false;
+    }
+
+    // Vanilla savegame emulation.
+    //
+    // Copying a file in Vanilla typically calls M_ReadFile() which
+    // stores the entire file in memory: Chocolate Hexen should force an
+    // allocation error here whenever it's appropriate.
+
+    if (vanilla_savegame_limit)
+    {
+        buffer = Z_Malloc(size, PU_STATIC, NULL);
+        Z_Free(buffer);
+    }
+
+    WriteSaveFile(destSlot, map, data, size);
+    return true;
+}
+
+//==========================================================================
+//
+// CopySaveSlot
+//
+// Copies all the save game files from one slot to another.
+//
+//==========================================================================
 
-        file_remaining -= buf_count;
-    } while (file_remaining > 0);
+static void CopySaveSlot(int sourceSlot, int destSlot)
+{
+    int i;
+    char sourceName[100];
 
-    Z_Free(buffer);
-    fclose(read_handle);
-    fclose(write_handle);
+    for (i = 0; i < MAX_MAPS; i++)
+    {
+        CopySaveFile(sourceSlot, destSlot, i);
+    }
+    if (!CopySaveFile(sourceSlot, destSlot, -1))
+    {
+        SaveFileName(sourceName, sizeof(sourceName), sourceSlot, -1);
+        I_Error("Could not load savegame %s", sourceName);
+    }
 }
 
 //==========================================================================
@@ -3370,11 +3618,18 @@ static void CopyFile(char *source_name, char *dest_name)
 //
 //==========================================================================
 
-static boolean ExistingFile(char *name)
+static boolean ExistingFile(int slot, int map)
 {
+    char fileName[100];
     FILE *fp;
 
-    if ((fp = M_fopen(name, "rb")) != NULL)
+    if (IsStoredSlot(slot))
+    {
+        return GetSaveFile(slot, map)->present;
+    }
+
+    SaveFileName(fileName, sizeof(fileName), slot, map);
+    if ((fp = M_fopen(fileName, "rb")) != NULL)
     {
         fclose(fp);
         return true;
@@ -3389,22 +3644,45 @@ static boolean ExistingFile(char *name)
 //
 // SV_Open
 //
+// Files are read from and written to memory: stored files are read in
+// place, others are read into SaveBuffer.
+//
 //==========================================================================
 
-static void SV_OpenRead(char *fileName)
+static void SV_OpenRead(int slot, int map)
 {
-    SavingFP = M_fopen(fileName, "rb");
+    char fileName[100];
+
+    SaveWriting = false;
+    SaveFile = NULL;
+    SavePos = 0;
+
+    if (IsStoredSlot(slot) && ExistingFile(slot, map))
+    {
+        SaveFile = GetSaveFile(slot, map);
+        SaveBuffer = LoadSaveFile(SaveFile);
+        SaveLength = SaveFile->size;
+        return;
+    }
+
+    SaveBuffer = ReadSaveFile(slot, map, &SaveLength);
 
     // Should never happen, only if hex6.hxs cannot ever be created.
-    if (SavingFP == NULL)
+    if (SaveBuffer == NULL)
     {
+        SaveFileName(fileName, sizeof(fileName), slot, map);
         I_Error("Could not load savegame %s", fileName);
     }
 }
 
-static void SV_OpenWrite(char *fileName)
+static void SV_OpenWrite(int slot, int map)
 {
-    SavingFP = M_fopen(fileName, "wb");
+    SaveWriting = true;
+    SaveSlot = slot;
+    SaveMap = map;
+    SaveBuffer = NULL;
+    SaveBufferSize = 0;
+    SaveLength = 0;
 }
 
 //==========================================================================
@@ -3415,10 +3693,21 @@ static void SV_OpenWrite(char *fileName)
 
 static void SV_Close(void)
 {
-    if (SavingFP)
+    if (SaveWriting)
     {
-        fclose(SavingFP);
+        WriteSaveFile(SaveSlot, SaveMap,
+                      I_Realloc(SaveBuffer, SaveLength > 0 ? SaveLength : 1),
+                      SaveLength);
     }
+    else if (SaveFile == NULL)
+    {
+        free(SaveBuffer);
+    }
+
+    SaveWriting = false;
+    SaveFile = NULL;
+    SaveBuffer = NULL;
+    SaveBufferSize = 0;
 }
 
 //==========================================================================
@@ -3429,12 +3718,13 @@ static void SV_Close(void)
 
 static void SV_Read(void *buffer, int size)
 {
-    int retval = fread(buffer, 1, size, SavingFP);
-    if (retval != size)
+    if (SavePos + size > SaveLength)
     {
         I_Error("Incomplete read in SV_Read: Expected %d, got %d bytes",
-            size, retval);
+            size, SaveLength - SavePos);
     }
+    memcpy(buffer, SaveBuffer + SavePos, size);
+    SavePos += size;
 }
 
 static byte SV_ReadByte(void)
@@ -3471,24 +3761,33 @@ static void *SV_ReadPtr(void)
 
 static void SV_Write(const void *buffer, int size)
 {
-    fwrite(buffer, size, 1, SavingFP);
+    if (SaveLength + size > SaveBufferSize)
+    {
+        while (SaveLength + size > SaveBufferSize)
+        {
+            SaveBufferSize = SaveBufferSize ? SaveBufferSize * 2 : 0x10000;
+        }
+        SaveBuffer = I_Realloc(SaveBuffer, SaveBufferSize);
+    }
+    memcpy(SaveBuffer + SaveLength, buffer, size);
+    SaveLength += size;
 }
 
 static void SV_WriteByte(byte val)
 {
-    fwrite(&val, sizeof(byte), 1, SavingFP);
+    SV_Write(&val, sizeof(byte));
 }
 
 static void SV_WriteWord(unsigned short val)
 {
     val = SHORT(val);
-    fwrite(&val, sizeof(unsigned short), 1, SavingFP);
+    SV_Write(&val, sizeof(unsigned short));
 }
 
 static void SV_WriteLong(unsigned int val)
 {
     val = LONG(val);
-    fwrite(&val, sizeof(int), 1, SavingFP);
+    SV_Write(&val, sizeof(int));
 }
 
 static void SV_WritePtr(void *val)
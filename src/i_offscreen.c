@@ -0,0 +1,734 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//      Offscreen video output, for rendering demos without a display.
+//
+//      Every frame passed to I_FinishUpdate is written out in one of
+//      these formats, picked from the name of the output:
+//
+//       *.y4m    YUV4MPEG2 (4:4:4), ready to pipe into an encoder.
+//       *.png    A numbered PNG sequence; the name must contain a
+//       *.pcx    printf-style %i, eg. "frame%06i.png".
+//       other    Raw paletted stream: a 'P' byte followed by 768 bytes
+//                of RGB whenever the palette changes, and an 'F' byte
+//                followed by SCREENWIDTH*SCREENHEIGHT bytes per frame.
+//
+//      "-" writes the stream to standard output.
+//
+//      With -offscreenaudio, sound effects and OPL music are mixed
+//      into a WAV file, 1/TICRATE of a second for every frame, so
+//      that it lines up with the video.  Sound effects are played
+//      by a software mixer standing in for SDL_mixer; music runs
+//      on the OPL emulator's virtual clock (OPL_Render).
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
+
+#include "config.h"
+#include "doomtype.h"
+#include "deh_str.h"
+#include "i_offscreen.h"
+#include "i_sound.h"
+#include "i_swap.h"
+#include "i_system.h"
+#include "i_timer.h"
+#include "i_video.h"
+#include "m_argv.h"
+#include "m_misc.h"
+#include "opl.h"
+#include "v_video.h"
+#include "w_wad.h"
+#include "z_zone.h"
+
+#define NUM_CHANNELS 16
+
+#define BETWEEN(l,u,x) (((l)>(x))?(l):((x)>(u))?(u):(x))
+
+typedef enum
+{
+    OFFSCREEN_RAW,
+    OFFSCREEN_Y4M,
+    OFFSCREEN_PNG,
+    OFFSCREEN_PCX,
+} offscreen_format_t;
+
+static offscreen_format_t format;
+static const char *filename;
+static FILE *stream;
+static int framenum;
+
+static byte palette[256 * 3];
+static boolean palette_changed;
+
+// Y, Cb and Cr for every palette entry, for Y4M output.
+static byte ycbcr[3][256];
+
+// One frame's worth of planes for Y4M output.
+static byte *planes;
+
+// Audio output (-offscreenaudio), and its length so far in bytes.
+static const char *audio_filename;
+static FILE *audio_stream;
+static uint32_t audio_length;
+static int16_t *audio_buffer;
+static int audio_buffer_samples;
+
+// A sound effect playing on a channel.  The lump stays locked while
+// it plays.
+typedef struct
+{
+    int lumpnum;            // -1 if the channel is free
+    const byte *data;       // 8-bit unsigned mono
+    uint32_t length;        // In samples
+    uint32_t pos;           // 16.16 fixed point
+    uint32_t step;          // 16.16 fixed point
+    int left, right;        // 0-255
+} channel_t;
+
+static channel_t channels[NUM_CHANNELS];
+static boolean use_sfx_prefix;
+
+// Check that the name of an image sequence contains exactly one
+// printf conversion, an integer one for the frame number, so that it
+// is safe to use as a format string.
+
+static boolean ValidFrameName(const char *name)
+{
+    const char *p;
+    int conversions;
+
+    conversions = 0;
+
+    for (p = name; *p != '\0'; ++p)
+    {
+        if (*p != '%')
+        {
+            continue;
+        }
+
+        ++p;
+
+        if (*p == '%')
+        {
+            continue;
+        }
+
+        while (*p != '\0' && strchr("-+ #0", *p) != NULL)
+        {
+            ++p;
+        }
+
+        while (*p >= '0' && *p <= '9')
+        {
+            ++p;
+        }
+
+        if (*p != 'd' && *p != 'i')
+        {
+            return false;
+        }
+
+        ++conversions;
+    }
+
+    return conversions == 1;
+}
+
+boolean I_OffscreenRequested(void)
+{
+    return M_ParmExists("-offscreen");
+}
+
+boolean I_OffscreenAudioRequested(void)
+{
+    return I_OffscreenRequested() && M_ParmExists("-offscreenaudio");
+}
+
+static void WriteWAVHeader(FILE *wav, uint32_t length)
+{
+    uint32_t i;
+    uint16_t s;
+
+    fwrite("RIFF", 1, 4, wav);
+    i = LONG(36 + length);
+    fwrite(&i, 4, 1, wav);
+    fwrite("WAVE", 1, 4, wav);
+
+    fwrite("fmt ", 1, 4, wav);
+    i = LONG(16);
+    fwrite(&i, 4, 1, wav);           // Length
+    s = SHORT(1);
+    fwrite(&s, 2, 1, wav);           // Format (PCM)
+    s = SHORT(2);
+    fwrite(&s, 2, 1, wav);           // Channels (2=stereo)
+    i = LONG(snd_samplerate);
+    fwrite(&i, 4, 1, wav);           // Sample rate
+    i = LONG(snd_samplerate * 2 * 2);
+    fwrite(&i, 4, 1, wav);           // Byte rate (samplerate * stereo * 16 bit)
+    s = SHORT(2 * 2);
+    fwrite(&s, 2, 1, wav);           // Block align (stereo * 16 bit)
+    s = SHORT(16);
+    fwrite(&s, 2, 1, wav);           // Bits per sample (16 bit)
+
+    fwrite("data", 1, 4, wav);
+    i = LONG(length);
+    fwrite(&i, 4, 1, wav);           // Data length
+}
+
+static void InitAudio(void)
+{
+    int p;
+
+    //!
+    // @arg <file>
+    // @category video
+    //
+    // With -offscreen, mix sound effects and OPL music into the
+    // given WAV file, in step with the video frames.  Music always
+    // plays through the OPL emulator in this mode.
+    //
+
+    p = M_CheckParmWithArgs("-offscreenaudio", 1);
+
+    if (p == 0)
+    {
+        return;
+    }
+
+    audio_filename = myargv[p + 1];
+    audio_stream = M_fopen(audio_filename, "wb");
+
+    if (audio_stream == NULL)
+    {
+        I_Error("I_InitOffscreen: Failed to open '%s'", audio_filename);
+    }
+
+    // Filled in with the real length on shutdown.
+    WriteWAVHeader(audio_stream, 0);
+    audio_length = 0;
+
+    audio_buffer_samples = snd_samplerate / TICRATE + 1;
+    audio_buffer = malloc(audio_buffer_samples * 4);
+}
+
+static void ShutdownAudio(void)
+{
+    if (audio_stream == NULL)
+    {
+        return;
+    }
+
+    rewind(audio_stream);
+    WriteWAVHeader(audio_stream, audio_length);
+    fclose(audio_stream);
+    audio_stream = NULL;
+
+    free(audio_buffer);
+    audio_buffer = NULL;
+}
+
+// Add the sound effects playing on all channels into the buffer.
+
+static void MixChannels(int16_t *buffer, int nsamples)
+{
+    channel_t *c;
+    int sample, value;
+    int i, ch;
+
+    for (ch = 0; ch < NUM_CHANNELS; ++ch)
+    {
+        c = &channels[ch];
+
+        if (c->lumpnum < 0)
+        {
+            continue;
+        }
+
+        for (i = 0; i < nsamples && (c->pos >> 16) < c->length; ++i)
+        {
+            sample = (c->data[c->pos >> 16] - 128) << 8;
+            c->pos += c->step;
+
+            value = buffer[i * 2] + (sample * c->left) / 255;
+            buffer[i * 2] = BETWEEN(-32768, 32767, value);
+            value = buffer[i * 2 + 1] + (sample * c->right) / 255;
+            buffer[i * 2 + 1] = BETWEEN(-32768, 32767, value);
+        }
+    }
+}
+
+// Mix and write out the audio for one frame.
+
+static void WriteAudio(void)
+{
+    int nsamples;
+    int i;
+
+    // Count from the start, so that rounding never drifts.
+    nsamples = (int) (((uint64_t) (framenum + 1) * snd_samplerate) / TICRATE
+                    - ((uint64_t) framenum * snd_samplerate) / TICRATE);
+
+    // Music first: OPL_Render fills the buffer (with silence if no
+    // music is playing) and the sound effects are added on top.
+    OPL_Render(audio_buffer, nsamples);
+    MixChannels(audio_buffer, nsamples);
+
+    for (i = 0; i < nsamples * 2; ++i)
+    {
+        audio_buffer[i] = SHORT(audio_buffer[i]);
+    }
+
+    fwrite(audio_buffer, 4, nsamples, audio_stream);
+    audio_length += nsamples * 4;
+
+    if (ferror(audio_stream))
+    {
+        I_Error("I_OffscreenFrame: Error writing to '%s'", audio_filename);
+    }
+}
+
+void I_InitOffscreen(void)
+{
+    int p;
+
+    //!
+    // @arg <file>
+    // @category video
+    //
+    // Render without a display, writing every frame to the given file
+    // instead. The format is picked from the extension: .y4m for
+    // YUV4MPEG2 video, .png or .pcx for an image sequence (the name
+    // must contain a printf-style %i for the frame number) and a raw
+    // paletted stream otherwise.  "-" writes to standard output.
+    // Each game tic is drawn exactly once, as fast as possible, so
+    // this is best combined with -playdemo or -timedemo.  Sound is
+    // off unless -offscreenaudio is also given.
+    //
+
+    p = M_CheckParmWithArgs("-offscreen", 1);
+
+    if (p == 0)
+    {
+        I_Error("I_InitOffscreen: -offscreen needs an output file");
+    }
+
+    filename = myargv[p + 1];
+
+    if (M_StringEndsWith(filename, ".y4m"))
+    {
+        format = OFFSCREEN_Y4M;
+    }
+    else if (M_StringEndsWith(filename, ".png"))
+    {
+#ifndef HAVE_LIBPNG
+        I_Error("I_InitOffscreen: Built without PNG support");
+#endif
+        format = OFFSCREEN_PNG;
+    }
+    else if (M_StringEndsWith(filename, ".pcx"))
+    {
+        format = OFFSCREEN_PCX;
+    }
+    else
+    {
+        format = OFFSCREEN_RAW;
+    }
+
+    if (format == OFFSCREEN_PNG || format == OFFSCREEN_PCX)
+    {
+        if (!ValidFrameName(filename))
+        {
+            I_Error("I_InitOffscreen: '%s' needs a single %%i (or %%d) for "
+                    "the frame number, and no other %% conversions",
+                    filename);
+        }
+
+        stream = NULL;
+    }
+    else if (!strcmp(filename, "-"))
+    {
+#ifdef _WIN32
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        stream = stdout;
+    }
+    else
+    {
+        stream = M_fopen(filename, "wb");
+
+        if (stream == NULL)
+        {
+            I_Error("I_InitOffscreen: Failed to open '%s'", filename);
+        }
+    }
+
+    if (format == OFFSCREEN_Y4M)
+    {
+        planes = malloc(SCREENWIDTH * SCREENHEIGHT * 3);
+
+        // Pixels are not square unless aspect ratio correction is off.
+        fprintf(stream, "YUV4MPEG2 W%i H%i F%i:1 Ip A%i:%i C444\n",
+                SCREENWIDTH, SCREENHEIGHT, TICRATE,
+                aspect_ratio_correct ? SCREENHEIGHT : 1,
+                aspect_ratio_correct ? SCREENHEIGHT_4_3 : 1);
+    }
+
+    InitAudio();
+
+    framenum = 0;
+    palette_changed = true;
+}
+
+void I_ShutdownOffscreen(void)
+{
+    if (stream != NULL)
+    {
+        fflush(stream);
+
+        if (stream != stdout)
+        {
+            fclose(stream);
+        }
+
+        stream = NULL;
+    }
+
+    free(planes);
+    planes = NULL;
+
+    ShutdownAudio();
+}
+
+void I_OffscreenSetPalette(const byte *pal)
+{
+    int r, g, b;
+    int i;
+
+    if (!memcmp(palette, pal, sizeof(palette)))
+    {
+        return;
+    }
+
+    memcpy(palette, pal, sizeof(palette));
+    palette_changed = true;
+
+    // BT.601 studio range, as most encoders expect.
+    for (i = 0; i < 256; ++i)
+    {
+        r = palette[i * 3];
+        g = palette[i * 3 + 1];
+        b = palette[i * 3 + 2];
+
+        ycbcr[0][i] = ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16;
+        ycbcr[1][i] = ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128;
+        ycbcr[2][i] = ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128;
+    }
+}
+
+static void WriteY4MFrame(pixel_t *buffer)
+{
+    int size = SCREENWIDTH * SCREENHEIGHT;
+    int plane;
+    int i;
+
+    for (plane = 0; plane < 3; ++plane)
+    {
+        for (i = 0; i < size; ++i)
+        {
+            planes[plane * size + i] = ycbcr[plane][buffer[i]];
+        }
+    }
+
+    fputs("FRAME\n", stream);
+    fwrite(planes, 1, size * 3, stream);
+}
+
+static void WriteRawFrame(pixel_t *buffer)
+{
+    if (palette_changed)
+    {
+        fputc('P', stream);
+        fwrite(palette, 1, sizeof(palette), stream);
+    }
+
+    fputc('F', stream);
+    fwrite(buffer, sizeof(*buffer), SCREENWIDTH * SCREENHEIGHT, stream);
+}
+
+static void WriteImageFrame(pixel_t *buffer)
+{
+    char name[256];
+
+    M_snprintf(name, sizeof(name), filename, framenum);
+
+#ifdef HAVE_LIBPNG
+    if (format == OFFSCREEN_PNG)
+    {
+        WritePNGfile(name, buffer, SCREENWIDTH, SCREENHEIGHT, palette);
+        return;
+    }
+#endif
+
+    WritePCXfile(name, buffer, SCREENWIDTH, SCREENHEIGHT, palette);
+}
+
+void I_OffscreenFrame(pixel_t *buffer)
+{
+    switch (format)
+    {
+        case OFFSCREEN_Y4M:
+            WriteY4MFrame(buffer);
+            break;
+
+        case OFFSCREEN_RAW:
+            WriteRawFrame(buffer);
+            break;
+
+        default:
+            WriteImageFrame(buffer);
+            break;
+    }
+
+    if (stream != NULL && ferror(stream))
+    {
+        I_Error("I_OffscreenFrame: Error writing to '%s'", filename);
+    }
+
+    if (audio_stream != NULL)
+    {
+        WriteAudio();
+    }
+
+    palette_changed = false;
+    ++framenum;
+}
+
+//
+// Sound module for -offscreenaudio, mixing into the audio output in
+// place of SDL_mixer.
+//
+
+static boolean I_Offscreen_InitSound(boolean _use_sfx_prefix)
+{
+    int i;
+
+    use_sfx_prefix = _use_sfx_prefix;
+
+    for (i = 0; i < NUM_CHANNELS; ++i)
+    {
+        channels[i].lumpnum = -1;
+    }
+
+    return true;
+}
+
+// Lumps are not reference counted, so keep the lump locked while the
+// same sound is still playing on another channel.
+
+static void ReleaseSfxLump(int lumpnum)
+{
+    int i;
+
+    for (i = 0; i < NUM_CHANNELS; ++i)
+    {
+        if (channels[i].lumpnum == lumpnum)
+        {
+            return;
+        }
+    }
+
+    W_ReleaseLumpNum(lumpnum);
+}
+
+static void I_Offscreen_StopSound(int handle)
+{
+    int lumpnum;
+
+    if (handle < 0 || handle >= NUM_CHANNELS
+     || channels[handle].lumpnum < 0)
+    {
+        return;
+    }
+
+    lumpnum = channels[handle].lumpnum;
+    channels[handle].lumpnum = -1;
+    ReleaseSfxLump(lumpnum);
+}
+
+static void I_Offscreen_ShutdownSound(void)
+{
+    int i;
+
+    for (i = 0; i < NUM_CHANNELS; ++i)
+    {
+        I_Offscreen_StopSound(i);
+    }
+}
+
+static int I_Offscreen_GetSfxLumpNum(sfxinfo_t *sfx)
+{
+    char namebuf[9];
+
+    // Linked sfx lumps? Get the lump number for the sound linked to.
+
+    if (sfx->link != NULL)
+    {
+        sfx = sfx->link;
+    }
+
+    // Doom adds a DS* prefix to sound lumps; Heretic and Hexen don't
+    // do this.
+
+    if (use_sfx_prefix)
+    {
+        M_snprintf(namebuf, sizeof(namebuf), "ds%s", DEH_String(sfx->name));
+    }
+    else
+    {
+        M_StringCopy(namebuf, DEH_String(sfx->name), sizeof(namebuf));
+    }
+
+    return W_GetNumForName(namebuf);
+}
+
+static boolean I_Offscreen_SoundIsPlaying(int handle)
+{
+    if (handle < 0 || handle >= NUM_CHANNELS)
+    {
+        return false;
+    }
+
+    return channels[handle].lumpnum >= 0
+        && (channels[handle].pos >> 16) < channels[handle].length;
+}
+
+static void I_Offscreen_UpdateSound(void)
+{
+    int i;
+
+    // Release the lumps of sounds that have finished.
+
+    for (i = 0; i < NUM_CHANNELS; ++i)
+    {
+        if (channels[i].lumpnum >= 0 && !I_Offscreen_SoundIsPlaying(i))
+        {
+            I_Offscreen_StopSound(i);
+        }
+    }
+}
+
+static void I_Offscreen_UpdateSoundParams(int handle, int vol, int sep)
+{
+    if (handle < 0 || handle >= NUM_CHANNELS)
+    {
+        return;
+    }
+
+    // As for Mix_SetPanning in the SDL module.
+    channels[handle].left = BETWEEN(0, 255, ((254 - sep) * vol) / 127);
+    channels[handle].right = BETWEEN(0, 255, (sep * vol) / 127);
+}
+
+static int I_Offscreen_StartSound(sfxinfo_t *sfxinfo, int channel,
+                                  int vol, int sep, int pitch)
+{
+    channel_t *c;
+    byte *data;
+    unsigned int lumplen;
+    uint32_t length;
+    int samplerate;
+    int stretch;
+
+    if (channel < 0 || channel >= NUM_CHANNELS)
+    {
+        return -1;
+    }
+
+    I_Offscreen_StopSound(channel);
+
+    data = W_CacheLumpNum(sfxinfo->lumpnum, PU_STATIC);
+    lumplen = W_LumpLength(sfxinfo->lumpnum);
+
+    // Check the header as the SDL module does: DMX skips sounds of
+    // 48 samples or less, and the first and last 16 samples.
+
+    if (lumplen < 8 || data[0] != 0x03 || data[1] != 0x00)
+    {
+        ReleaseSfxLump(sfxinfo->lumpnum);
+        return -1;
+    }
+
+    samplerate = (data[3] << 8) | data[2];
+    length = (data[7] << 24) | (data[6] << 16) | (data[5] << 8) | data[4];
+
+    if (length > lumplen - 8 || length <= 48 || samplerate == 0)
+    {
+        ReleaseSfxLump(sfxinfo->lumpnum);
+        return -1;
+    }
+
+    c = &channels[channel];
+    c->lumpnum = sfxinfo->lumpnum;
+    c->data = data + 8 + 16;
+    c->length = length - 32;
+    c->pos = 0;
+    c->step = ((uint64_t) samplerate << 16) / snd_samplerate;
+
+    // The SDL module stretches pitch-shifted sounds to
+    // (2 - pitch / NORM_PITCH) times their length.
+
+    if (snd_pitchshift && pitch != NORM_PITCH)
+    {
+        stretch = 2 * NORM_PITCH - pitch;
+
+        if (stretch < 1)
+        {
+            stretch = 1;
+        }
+
+        c->step = ((uint64_t) c->step * NORM_PITCH) / stretch;
+    }
+
+    I_Offscreen_UpdateSoundParams(channel, vol, sep);
+
+    return channel;
+}
+
+static void I_Offscreen_CacheSounds(sfxinfo_t *sounds, int num_sounds)
+{
+    // Lumps are loaded as they are played.
+}
+
+sound_module_t sound_offscreen_module =
+{
+    NULL,
+    0,
+    I_Offscreen_InitSound,
+    I_Offscreen_ShutdownSound,
+    I_Offscreen_GetSfxLumpNum,
+    I_Offscreen_UpdateSound,
+    I_Offscreen_UpdateSoundParams,
+    I_Offscreen_StartSound,
+    I_Offscreen_StopSound,
+    I_Offscreen_SoundIsPlaying,
+    I_Offscreen_CacheSounds,
+};
+
@@ -0,0 +1,42 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//      Offscreen video output, for rendering demos without a display.
+//
+
+#ifndef __I_OFFSCREEN__
+#define __I_OFFSCREEN__
+
+#include "doomtype.h"
+
+// True if -offscreen was given on the command line.
+boolean I_OffscreenRequested(void);
+
+// True if audio is to be mixed into a file as well (-offscreenaudio).
+boolean I_OffscreenAudioRequested(void);
+
+// Open the output named by -offscreen.
+void I_InitOffscreen(void);
+
+// Close the output, flushing anything still buffered.
+void I_ShutdownOffscreen(void);
+
+// Set the palette (768 bytes of RGB) used for the following frames.
+void I_OffscreenSetPalette(const byte *palette);
+
+// Write out a frame.
+void I_OffscreenFrame(pixel_t *buffer);
+
+#endif
+
@@ -21,12 +21,12 @@
 #include <stdlib.h>
 #include <string.h>
 
-#include "memio.h"
-#include "mus2mid.h"
-
 #include "deh_main.h"
+#include "i_offscreen.h"
 #include "i_sound.h"
 #include "i_swap.h"
+#include "i_system.h"
+#include "m_argv.h"
 #include "m_misc.h"
 #include "w_wad.h"
 #include "z_zone.h"
@@ -36,7 +36,6 @@
 
 // #define OPL_MIDI_DEBUG
 
-#define MAXMIDLENGTH (96 * 1024)
 #define GENMIDI_NUM_INSTRS  128
 #define GENMIDI_NUM_PERCUSSION 47
 
@@ -1605,77 +1604,33 @@ static void I_OPL_UnRegisterSong(void *handle)
     }
 }
 
-// Determine whether memory block is a .mid file
-
-static boolean IsMid(byte *mem, int len)
-{
-    return len > 4 && !memcmp(mem, "MThd", 4);
-}
-
-static boolean ConvertMus(byte *musdata, int len, char *filename)
-{
-    MEMFILE *instream;
-    MEMFILE *outstream;
-    void *outbuf;
-    size_t outbuf_len;
-    int result;
-
-    instream = mem_fopen_read(musdata, len);
-    outstream = mem_fopen_write();
-
-    result = mus2mid(instream, outstream);
-
-    if (result == 0)
-    {
-        mem_get_buf(outstream, &outbuf, &outbuf_len);
-
-        M_WriteFile(filename, outbuf, outbuf_len);
-    }
-
-    mem_fclose(instream);
-    mem_fclose(outstream);
-
-    return result;
-}
-
 static void *I_OPL_RegisterSong(void *data, int len)
 {
     midi_file_t *result;
-    char *filename;
+    void *mid;
+    size_t midlen;
 
     if (!music_initialized)
     {
         return NULL;
     }
 
-    // MUS files begin with "MUS"
-    // Reject anything which doesnt have this signature
+    // The MIDI is parsed straight from memory; MUS lumps are converted
+    // first.
 
-    filename = M_TempFile("doom.mid");
-
-    if (IsMid(data, len) && len < MAXMIDLENGTH)
+    if (!I_GetMIDIData(data, len, &mid, &midlen))
     {
-        M_WriteFile(filename, data, len);
-    }
-    else
-    {
-        // Assume a MUS file and try to convert
-
-        ConvertMus(data, len, filename);
+        fprintf(stderr, "I_OPL_RegisterSong: Failed to convert MUS.\n");
+        return NULL;
     }
 
-    result = MIDI_LoadFile(filename);
+    result = MIDI_LoadFileFromMemory(mid, midlen);
 
     if (result == NULL)
     {
         fprintf(stderr, "I_OPL_RegisterSong: Failed to load MID.\n");
     }
 
-    // remove file now
-
-    M_remove(filename);
-    free(filename);
-
     return result;
 }
 
@@ -1711,21 +1666,11 @@ static void I_OPL_ShutdownMusic(void)
     }
 }
 
-// Initialize music subsystem
+// Choose between OPL2 and OPL3 mode for the detected chip.
 
-static boolean I_OPL_InitMusic(void)
+static void SetChipType(opl_init_result_t chip_type)
 {
     const char *dmxoption;
-    opl_init_result_t chip_type;
-
-    OPL_SetSampleRate(snd_samplerate);
-
-    chip_type = OPL_Init(opl_io_port);
-    if (chip_type == OPL_INIT_NONE)
-    {
-        printf("Dude.  The Adlib isn't responding.\n");
-        return false;
-    }
 
     // The DMXOPTION variable must be set to enable OPL3 support.
     // As an extension, we also allow it to be set from the config file.
@@ -1749,6 +1694,35 @@ static boolean I_OPL_InitMusic(void)
     // Secret, undocumented DMXOPTION that reverses the stereo channels
     // into their correct orientation.
     opl_stereo_correct = strstr(dmxoption, "-reverse") != NULL;
+}
+
+// Initialize music subsystem
+
+static boolean I_OPL_InitMusic(void)
+{
+    opl_init_result_t chip_type;
+
+    OPL_SetSampleRate(snd_samplerate);
+
+    // When rendering offscreen, the music is generated along with
+    // each frame by OPL_Render() rather than played in real time.
+
+    if (I_OffscreenRequested())
+    {
+        chip_type = OPL_InitOffline();
+    }
+    else
+    {
+        chip_type = OPL_Init(opl_io_port);
+    }
+
+    if (chip_type == OPL_INIT_NONE)
+    {
+        printf("Dude.  The Adlib isn't responding.\n");
+        return false;
+    }
+
+    SetChipType(chip_type);
 
     // Initialize all registers.
 
@@ -1794,6 +1768,213 @@ music_module_t music_opl_module =
     NULL,  // Poll
 };
 
+//----------------------------------------------------------------------
+//
+// Offline rendering: play every song in the WAD directory through the
+// emulator on a virtual clock and write it out as a WAV file.
+//
+//----------------------------------------------------------------------
+
+// Samples generated per OPL_Render() call.
+
+#define RENDER_CHUNK_SAMPLES 4096
+
+// Time allowed for voices to fade out after the song has ended.
+
+#define RENDER_TAIL_MS 1000
+
+// Songs longer than this are cut short, in case a broken file never
+// reaches its end.
+
+#define RENDER_MAX_SECONDS (60 * 60)
+
+static boolean IsMusicLump(int lumpnum)
+{
+    byte *data;
+    boolean result;
+
+    if (W_LumpLength(lumpnum) < 4)
+    {
+        return false;
+    }
+
+    data = W_CacheLumpNum(lumpnum, PU_STATIC);
+
+    result = memcmp(data, "MUS\x1a", 4) == 0
+          || memcmp(data, "MThd", 4) == 0;
+
+    W_ReleaseLumpNum(lumpnum);
+
+    return result;
+}
+
+static void WriteWAVHeader(FILE *wav, uint32_t length)
+{
+    uint32_t i;
+    uint16_t s;
+
+    fwrite("RIFF", 1, 4, wav);
+    i = LONG(36 + length);
+    fwrite(&i, 4, 1, wav);
+    fwrite("WAVE", 1, 4, wav);
+
+    fwrite("fmt ", 1, 4, wav);
+    i = LONG(16);
+    fwrite(&i, 4, 1, wav);           // Length
+    s = SHORT(1);
+    fwrite(&s, 2, 1, wav);           // Format (PCM)
+    s = SHORT(2);
+    fwrite(&s, 2, 1, wav);           // Channels (2=stereo)
+    i = LONG(snd_samplerate);
+    fwrite(&i, 4, 1, wav);           // Sample rate
+    i = LONG(snd_samplerate * 2 * 2);
+    fwrite(&i, 4, 1, wav);           // Byte rate (samplerate * stereo * 16 bit)
+    s = SHORT(2 * 2);
+    fwrite(&s, 2, 1, wav);           // Block align (stereo * 16 bit)
+    s = SHORT(16);
+    fwrite(&s, 2, 1, wav);           // Bits per sample (16 bit)
+
+    fwrite("data", 1, 4, wav);
+    i = LONG(length);
+    fwrite(&i, 4, 1, wav);           // Data length
+}
+
+// Render the given number of samples and append them to the file,
+// returning the number of bytes written.
+
+static uint32_t RenderSamples(FILE *wav, unsigned int nsamples)
+{
+    static int16_t buffer[RENDER_CHUNK_SAMPLES * 2];
+    unsigned int i;
+
+    OPL_Render(buffer, nsamples);
+
+    for (i = 0; i < nsamples * 2; ++i)
+    {
+        buffer[i] = SHORT(buffer[i]);
+    }
+
+    fwrite(buffer, 4, nsamples, wav);
+
+    return nsamples * 4;
+}
+
+static boolean RenderSong(int lumpnum, const char *filename)
+{
+    void *handle;
+    FILE *wav;
+    uint32_t length;
+    unsigned int tail;
+
+    handle = I_OPL_RegisterSong(W_CacheLumpNum(lumpnum, PU_STATIC),
+                                W_LumpLength(lumpnum));
+    W_ReleaseLumpNum(lumpnum);
+
+    if (handle == NULL)
+    {
+        return false;
+    }
+
+    wav = M_fopen(filename, "wb");
+
+    if (wav == NULL)
+    {
+        I_OPL_UnRegisterSong(handle);
+        I_Error("RenderSong: Failed to open %s for writing", filename);
+    }
+
+    // Start from a freshly reset chip, so that each song renders the
+    // same way however many have gone before it.
+
+    OPL_InitOffline();
+    OPL_InitRegisters(opl_opl3mode);
+    InitVoices();
+
+    WriteWAVHeader(wav, 0);
+    length = 0;
+
+    I_OPL_PlaySong(handle, false);
+
+    while (running_tracks > 0
+        && length < (uint64_t) RENDER_MAX_SECONDS * snd_samplerate * 4)
+    {
+        length += RenderSamples(wav, RENDER_CHUNK_SAMPLES);
+    }
+
+    I_OPL_StopSong();
+
+    for (tail = (snd_samplerate * RENDER_TAIL_MS) / 1000; tail > 0;
+         tail -= RENDER_CHUNK_SAMPLES)
+    {
+        if (tail < RENDER_CHUNK_SAMPLES)
+        {
+            length += RenderSamples(wav, tail);
+            break;
+        }
+
+        length += RenderSamples(wav, RENDER_CHUNK_SAMPLES);
+    }
+
+    rewind(wav);
+    WriteWAVHeader(wav, length);
+    fclose(wav);
+
+    I_OPL_UnRegisterSong(handle);
+
+    return true;
+}
+
+void I_OPL_RenderMusic(const char *dir)
+{
+    char name[9];
+    char *filename;
+    unsigned int lumpnum;
+    int songs;
+
+    // Replace any real-time playback with the offline renderer.
+
+    I_OPL_ShutdownMusic();
+
+    OPL_SetSampleRate(snd_samplerate);
+    SetChipType(OPL_INIT_OPL3);
+
+    if (!LoadInstrumentTable())
+    {
+        I_Error("I_OPL_RenderMusic: Failed to load the instrument table");
+    }
+
+    tracks = NULL;
+    num_tracks = 0;
+    music_initialized = true;
+    current_music_volume = 127;
+
+    M_MakeDirectory(dir);
+
+    songs = 0;
+
+    for (lumpnum = 0; lumpnum < numlumps; ++lumpnum)
+    {
+        if (!IsMusicLump(lumpnum))
+        {
+            continue;
+        }
+
+        M_StringCopy(name, lumpinfo[lumpnum]->name, sizeof(name));
+        filename = M_StringJoin(dir, DIR_SEPARATOR_S, name, ".wav", NULL);
+
+        if (RenderSong(lumpnum, filename))
+        {
+            printf("I_OPL_RenderMusic: %s\n", filename);
+            ++songs;
+        }
+
+        free(filename);
+    }
+
+    printf("I_OPL_RenderMusic: %i songs written to %s.\n", songs, dir);
+    I_Quit();
+}
+
 void I_SetOPLDriverVer(opl_driver_ver_t ver)
 {
     opl_drv_ver = ver;
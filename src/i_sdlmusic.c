@@ -29,8 +29,6 @@
 
 #include "config.h"
 #include "doomtype.h"
-#include "memio.h"
-#include "mus2mid.h"
 
 #include "deh_str.h"
 #include "gusconf.h"
@@ -129,8 +127,6 @@ void I_InitTimidityConfig(void)
 #ifndef DISABLE_SDL2MIXER
 
 
-#define MAXMIDLENGTH (96 * 1024)
-
 static boolean music_initialized = false;
 
 // If this is true, this module initialized SDL sound and has the
@@ -452,68 +448,51 @@ static void I_SDL_UnRegisterSong(void *handle)
     }
 }
 
-// Determine whether memory block is a .mid file 
-
-static boolean IsMid(byte *mem, int len)
-{
-    return len > 4 && !memcmp(mem, "MThd", 4);
-}
-
-static boolean ConvertMus(byte *musdata, int len, const char *filename)
-{
-    MEMFILE *instream;
-    MEMFILE *outstream;
-    void *outbuf;
-    size_t outbuf_len;
-    int result;
-
-    instream = mem_fopen_read(musdata, len);
-    outstream = mem_fopen_write();
-
-    result = mus2mid(instream, outstream);
-
-    if (result == 0)
-    {
-        mem_get_buf(outstream, &outbuf, &outbuf_len);
-
-        M_WriteFile(filename, outbuf, outbuf_len);
-    }
-
-    mem_fclose(instream);
-    mem_fclose(outstream);
-
-    return result;
-}
-
 static void *I_SDL_RegisterSong(void *data, int len)
 {
     char *filename;
     Mix_Music *music;
+    boolean use_file;
+    void *mid;
+    size_t midlen;
 
     if (!music_initialized)
     {
         return NULL;
     }
 
-    // MUS files begin with "MUS"
-    // Reject anything which doesnt have this signature
-
-    filename = M_TempFile("doom.mid");
+    // MUS lumps are converted to MIDI first.
 
-    if (IsMid(data, len) && len < MAXMIDLENGTH)
+    if (!I_GetMIDIData(data, len, &mid, &midlen))
     {
-        M_WriteFile(filename, data, len);
+        fprintf(stderr, "Error loading midi: Failed to convert MUS.\n");
+        return NULL;
     }
-    else
+
+    // Mix_SetMusicCMD() only works with Mix_LoadMUS(), and Windows
+    // native MIDI also plays from a file, so those still need a
+    // temporary file.  Otherwise the MIDI is loaded from memory.
+
+    use_file = strlen(snd_musiccmd) > 0;
+
+#if defined(_WIN32)
+    use_file = use_file || win_midi_stream_opened;
+#endif
+
+    if (!use_file)
     {
-	// Assume a MUS file and try to convert
+        music = Mix_LoadMUS_RW(SDL_RWFromConstMem(mid, midlen), 1);
 
-        ConvertMus(data, len, filename);
+        if (music == NULL)
+        {
+            fprintf(stderr, "Error loading midi: %s\n", Mix_GetError());
+        }
+
+        return music;
     }
 
-    // Load the MIDI. In an ideal world we'd be using Mix_LoadMUS_RW()
-    // by now, but Mix_SetMusicCMD() only works with Mix_LoadMUS(), so
-    // we have to generate a temporary file.
+    filename = M_TempFile("doom.mid");
+    M_WriteFile(filename, mid, midlen);
 
 #if defined(_WIN32)
     // If we do not have an external music command defined, play
@@ -540,15 +519,9 @@ static void *I_SDL_RegisterSong(void *data, int len)
             fprintf(stderr, "Error loading midi: %s\n", Mix_GetError());
         }
 
-        // Remove the temporary MIDI file; however, when using an external
-        // MIDI program we can't delete the file. Otherwise, the program
-        // won't find the file to play. This means we leave a mess on
-        // disk :(
-
-        if (strlen(snd_musiccmd) == 0)
-        {
-            M_remove(filename);
-        }
+        // We can't delete the temporary MIDI file when using an
+        // external MIDI program. Otherwise, the program won't find the
+        // file to play. This means we leave a mess on disk :(
     }
 
     free(filename);
@@ -34,6 +34,7 @@
 #include "i_sound.h"
 #include "i_system.h"
 #include "i_swap.h"
+#include "i_thread.h"
 #include "m_argv.h"
 #include "m_misc.h"
 #include "w_wad.h"
@@ -69,6 +70,10 @@ struct allocated_sound_s
     int use_count;
     int pitch;
     allocated_sound_t *prev, *next;
+
+    // Next sound for the same sfxinfo (at another pitch); the first is
+    // in sfxinfo->driver_data.
+    allocated_sound_t *sfx_next;
 };
 
 static boolean sound_initialized = false;
@@ -84,14 +89,31 @@ static boolean (*ExpandSoundData)(sfxinfo_t *sfxinfo,
                                   int samplerate,
                                   int length) = NULL;
 
-// Doubly-linked list of allocated sounds.
-// When a sound is played, it is moved to the head, so that the oldest
-// sounds not used recently are at the tail.
+// Doubly-linked list of allocated sounds that are not in use.
+// When a sound stops being used, it is moved to the head, so that the
+// sounds not used for longest are at the tail, ready to be freed.
+// Sounds being played are kept off the list, so the tail can always
+// be freed at once.
 
 static allocated_sound_t *allocated_sounds_head = NULL;
 static allocated_sound_t *allocated_sounds_tail = NULL;
 static int allocated_sounds_size = 0;
 
+// Statistics to help with tuning snd_cachesize, shown with -devparm.
+
+static int allocated_sounds_count = 0;
+static int allocated_sounds_peak = 0;
+static int sound_cache_hits = 0;
+static int sound_cache_misses = 0;
+
+// Held by AllocateSound() while sounds are being precached by several
+// threads at once.
+
+static SDL_mutex *cache_lock = NULL;
+
+// Worker threads used to precache sounds.
+
+static iworkers_t *precache_workers = NULL;
 
 // Hook a sound into the linked list at the head.
 
@@ -137,41 +159,45 @@ static void AllocatedSoundUnlink(allocated_sound_t *snd)
 
 static void FreeAllocatedSound(allocated_sound_t *snd)
 {
+    allocated_sound_t **prev;
+
     // Unlink from linked list.
 
-    AllocatedSoundUnlink(snd);
+    if (snd->use_count == 0)
+    {
+        AllocatedSoundUnlink(snd);
+    }
+
+    // Unlink from the sounds for this sfxinfo.
+
+    for (prev = (allocated_sound_t **) &snd->sfxinfo->driver_data;
+         *prev != snd; prev = &(*prev)->sfx_next);
+
+    *prev = snd->sfx_next;
 
     // Keep track of the amount of allocated sound data:
 
     allocated_sounds_size -= snd->chunk.alen;
+    --allocated_sounds_count;
 
     free(snd);
 }
 
-// Search from the tail backwards along the allocated sounds list, find
-// and free a sound that is not in use, to free up memory.  Return true
-// for success.
+// Free the sound that has gone unused for longest, to free up memory.
+// Return true for success.
 
 static boolean FindAndFreeSound(void)
 {
-    allocated_sound_t *snd;
-
-    snd = allocated_sounds_tail;
-
-    while (snd != NULL)
+    if (allocated_sounds_tail == NULL)
     {
-        if (snd->use_count == 0)
-        {
-            FreeAllocatedSound(snd);
-            return true;
-        }
+        // No available sounds to free...
 
-        snd = snd->prev;
+        return false;
     }
 
-    // No available sounds to free...
+    FreeAllocatedSound(allocated_sounds_tail);
 
-    return false;
+    return true;
 }
 
 // Enforce SFX cache size limit.  We are just about to allocate "len"
@@ -205,9 +231,15 @@ static allocated_sound_t *AllocateSound(sfxinfo_t *sfxinfo, size_t len)
 {
     allocated_sound_t *snd;
 
-    // Keep allocated sounds within the cache size.
+    // Keep allocated sounds within the cache size.  While sounds are
+    // being precached by several threads nothing is freed, as another
+    // thread may still be filling in the sound that would go; the
+    // cache is trimmed once precaching has finished.
 
-    ReserveCacheSpace(len);
+    if (cache_lock == NULL)
+    {
+        ReserveCacheSpace(len);
+    }
 
     // Allocate the sound structure and data.  The data will immediately
     // follow the structure, which acts as a header.
@@ -219,7 +251,7 @@ static allocated_sound_t *AllocateSound(sfxinfo_t *sfxinfo, size_t len)
         // Out of memory?  Try to free an old sound, then loop round
         // and try again.
 
-        if (snd == NULL && !FindAndFreeSound())
+        if (snd == NULL && (cache_lock != NULL || !FindAndFreeSound()))
         {
             return NULL;
         }
@@ -237,12 +269,31 @@ static allocated_sound_t *AllocateSound(sfxinfo_t *sfxinfo, size_t len)
     snd->sfxinfo = sfxinfo;
     snd->use_count = 0;
 
+    if (cache_lock != NULL)
+    {
+        SDL_LockMutex(cache_lock);
+    }
+
     // Keep track of how much memory all these cached sounds are using...
 
     allocated_sounds_size += len;
+    ++allocated_sounds_count;
+
+    if (allocated_sounds_size > allocated_sounds_peak)
+    {
+        allocated_sounds_peak = allocated_sounds_size;
+    }
 
     AllocatedSoundLink(snd);
 
+    snd->sfx_next = sfxinfo->driver_data;
+    sfxinfo->driver_data = snd;
+
+    if (cache_lock != NULL)
+    {
+        SDL_UnlockMutex(cache_lock);
+    }
+
     return snd;
 }
 
@@ -250,17 +301,18 @@ static allocated_sound_t *AllocateSound(sfxinfo_t *sfxinfo, size_t len)
 
 static void LockAllocatedSound(allocated_sound_t *snd)
 {
+    // A sound in use may not be freed, so take it off the list.
+
+    if (snd->use_count == 0)
+    {
+        AllocatedSoundUnlink(snd);
+    }
+
     // Increase use count, to stop the sound being freed.
 
     ++snd->use_count;
 
     //printf("++ %s: Use count=%i\n", snd->sfxinfo->name, snd->use_count);
-
-    // When we use a sound, re-link it into the list at the head, so
-    // that the oldest sounds fall to the end of the list for freeing.
-
-    AllocatedSoundUnlink(snd);
-    AllocatedSoundLink(snd);
 }
 
 // Unlock a sound to indicate that it may now be freed.
@@ -275,22 +327,30 @@ static void UnlockAllocatedSound(allocated_sound_t *snd)
     --snd->use_count;
 
     //printf("-- %s: Use count=%i\n", snd->sfxinfo->name, snd->use_count);
+
+    // When a sound is no longer used, link it into the list at the
+    // head, so that the oldest sounds fall to the end for freeing.
+
+    if (snd->use_count == 0)
+    {
+        AllocatedSoundLink(snd);
+    }
 }
 
-// Search through the list of allocated sounds and return the one that matches
-// the supplied sfxinfo entry and pitch level.
+// Search through the allocated sounds for the supplied sfxinfo entry and
+// return the one with the given pitch level.
 
 static allocated_sound_t * GetAllocatedSoundBySfxInfoAndPitch(sfxinfo_t *sfxinfo, int pitch)
 {
-    allocated_sound_t * p = allocated_sounds_head;
+    allocated_sound_t * p = sfxinfo->driver_data;
 
     while (p != NULL)
     {
-        if (p->sfxinfo == sfxinfo && p->pitch == pitch)
+        if (p->pitch == pitch)
         {
             return p;
         }
-        p = p->next;
+        p = p->sfx_next;
     }
 
     return NULL;
@@ -356,14 +416,10 @@ static void ReleaseSoundOnChannel(int channel)
 
     channels_playing[channel] = NULL;
 
-    UnlockAllocatedSound(snd);
+    // Pitch-shifted sounds stay in the cache like any other, to be
+    // reused the next time the same pitch comes up.
 
-    // if the sound is a pitch-shift and it's not in use, immediately
-    // free it
-    if (snd->pitch != NORM_PITCH && snd->use_count <= 0)
-    {
-        FreeAllocatedSound(snd);
-    }
+    UnlockAllocatedSound(snd);
 }
 
 #ifdef HAVE_LIBSAMPLERATE
@@ -714,22 +770,14 @@ static boolean ExpandSoundData_SDL(sfxinfo_t *sfxinfo,
     return true;
 }
 
-// Load and convert a sound effect
+// Convert a sound effect from its lump data.  This may run on a worker
+// thread while precaching.
 // Returns true if successful
 
-static boolean CacheSFX(sfxinfo_t *sfxinfo)
+static boolean ExpandSFX(sfxinfo_t *sfxinfo, byte *data, unsigned int lumplen)
 {
-    int lumpnum;
-    unsigned int lumplen;
     int samplerate;
     unsigned int length;
-    byte *data;
-
-    // need to load the sound
-
-    lumpnum = sfxinfo->lumpnum;
-    data = W_CacheLumpNum(lumpnum, PU_STATIC);
-    lumplen = W_LumpLength(lumpnum);
 
     // Check the header, and ensure this is a valid sound
 
@@ -768,8 +816,25 @@ static boolean CacheSFX(sfxinfo_t *sfxinfo)
 
     // Sample rate conversion
 
-    if (!ExpandSoundData(sfxinfo, data + 8, samplerate, length))
+    return ExpandSoundData(sfxinfo, data + 8, samplerate, length);
+}
+
+// Load and convert a sound effect
+// Returns true if successful
+
+static boolean CacheSFX(sfxinfo_t *sfxinfo)
+{
+    int lumpnum;
+    byte *data;
+
+    // need to load the sound
+
+    lumpnum = sfxinfo->lumpnum;
+    data = W_CacheLumpNum(lumpnum, PU_STATIC);
+
+    if (!ExpandSFX(sfxinfo, data, W_LumpLength(lumpnum)))
     {
+        W_ReleaseLumpNum(lumpnum);
         return false;
     }
 
@@ -814,15 +879,38 @@ static void GetSfxLumpName(sfxinfo_t *sfx, char *buf, size_t buf_len)
     }
 }
 
+typedef struct
+{
+    sfxinfo_t *sounds;
+    byte **lumps;
+} precache_t;
+
+static void PrecacheJob(void *data, int job)
+{
+    precache_t *precache = data;
+    sfxinfo_t *sfx = &precache->sounds[job];
+
+    if (precache->lumps[job] != NULL)
+    {
+        ExpandSFX(sfx, precache->lumps[job], W_LumpLength(sfx->lumpnum));
+    }
+}
+
 // Preload all the sound effects - stops nasty ingame freezes
+// The lumps are loaded here and the sample rate conversion, which is
+// most of the work, is shared out between worker threads.
 
 static void I_SDL_PrecacheSounds(sfxinfo_t *sounds, int num_sounds)
 {
+    precache_t precache;
     char namebuf[9];
     int i;
 
     printf("I_SDL_PrecacheSounds: Precaching all sound effects..");
 
+    precache.sounds = sounds;
+    precache.lumps = malloc(num_sounds * sizeof(byte *));
+
     for (i=0; i<num_sounds; ++i)
     {
         if ((i % 6) == 0)
@@ -834,13 +922,52 @@ static void I_SDL_PrecacheSounds(sfxinfo_t *sounds, int num_sounds)
         GetSfxLumpName(&sounds[i], namebuf, sizeof(namebuf));
 
         sounds[i].lumpnum = W_CheckNumForName(namebuf);
+        precache.lumps[i] = NULL;
+
+        // Sounds that are already cached are left alone.
+
+        if (sounds[i].lumpnum != -1
+         && GetAllocatedSoundBySfxInfoAndPitch(&sounds[i], NORM_PITCH) == NULL)
+        {
+            precache.lumps[i] = W_CacheLumpNum(sounds[i].lumpnum, PU_STATIC);
+        }
+    }
+
+    if (precache_workers == NULL && I_GetCPUCount() > 1)
+    {
+        precache_workers = I_CreateWorkers(I_GetCPUCount() - 1, "sfxcache");
+    }
+
+    if (precache_workers != NULL)
+    {
+        cache_lock = SDL_CreateMutex();
+        I_RunJobs(precache_workers, PrecacheJob, &precache, num_sounds);
+        SDL_DestroyMutex(cache_lock);
+        cache_lock = NULL;
+    }
+    else
+    {
+        for (i=0; i<num_sounds; ++i)
+        {
+            PrecacheJob(&precache, i);
+        }
+    }
 
-        if (sounds[i].lumpnum != -1)
+    for (i=0; i<num_sounds; ++i)
+    {
+        if (precache.lumps[i] != NULL)
         {
-            CacheSFX(&sounds[i]);
+            W_ReleaseLumpNum(sounds[i].lumpnum);
         }
     }
 
+    free(precache.lumps);
+
+    // Nothing is freed while precaching, so bring the cache back
+    // within its size limit now.
+
+    ReserveCacheSpace(0);
+
     printf("\n");
 }
 
@@ -851,11 +978,17 @@ static boolean LockSound(sfxinfo_t *sfxinfo)
     // If the sound isn't loaded, load it now
     if (GetAllocatedSoundBySfxInfoAndPitch(sfxinfo, NORM_PITCH) == NULL)
     {
+        ++sound_cache_misses;
+
         if (!CacheSFX(sfxinfo))
         {
             return false;
         }
     }
+    else
+    {
+        ++sound_cache_hits;
+    }
 
     LockAllocatedSound(GetAllocatedSoundBySfxInfoAndPitch(sfxinfo, NORM_PITCH));
 
@@ -923,41 +1056,44 @@ static int I_SDL_StartSound(sfxinfo_t *sfxinfo, int channel, int vol, int sep, i
 
     ReleaseSoundOnChannel(channel);
 
-    // Get the sound data
+    // Get the sound data; the base sound effect, un-pitch-shifted,
+    // is locked by LockSound.
 
     if (!LockSound(sfxinfo))
     {
         return -1;
     }
 
-    snd = GetAllocatedSoundBySfxInfoAndPitch(sfxinfo, pitch);
+    snd = GetAllocatedSoundBySfxInfoAndPitch(sfxinfo, NORM_PITCH);
 
-    if (snd == NULL)
+    if (pitch != NORM_PITCH)
     {
         allocated_sound_t *newsnd;
-        // fetch the base sound effect, un-pitch-shifted
-        snd = GetAllocatedSoundBySfxInfoAndPitch(sfxinfo, NORM_PITCH);
 
-        if (snd == NULL)
+        newsnd = GetAllocatedSoundBySfxInfoAndPitch(sfxinfo, pitch);
+
+        if (newsnd != NULL)
         {
-            return -1;
+            ++sound_cache_hits;
         }
-
-        if (snd_pitchshift)
+        else if (snd_pitchshift)
         {
             newsnd = PitchShift(snd, pitch);
 
-            if (newsnd)
+            if (newsnd != NULL)
             {
-                LockAllocatedSound(newsnd);
-                UnlockAllocatedSound(snd);
-                snd = newsnd;
+                ++sound_cache_misses;
             }
         }
-    }
-    else
-    {
-        LockAllocatedSound(snd);
+
+        // Swap the lock over to the pitch-shifted version.
+
+        if (newsnd != NULL)
+        {
+            LockAllocatedSound(newsnd);
+            UnlockAllocatedSound(snd);
+            snd = newsnd;
+        }
     }
 
     // play sound
@@ -1059,6 +1195,20 @@ static int GetSliceSize(void)
     return 1024;
 }
 
+static void PrintSoundCacheStats(void)
+{
+    int lookups;
+
+    lookups = sound_cache_hits + sound_cache_misses;
+
+    printf("Sound cache: %i lookups, %i hits, %i misses (%.1f%% hit)\n",
+           lookups, sound_cache_hits, sound_cache_misses,
+           lookups > 0 ? (sound_cache_hits * 100.0) / lookups : 0.0);
+    printf("  %i sounds, %i KB (peak %i KB, snd_cachesize %i KB)\n",
+           allocated_sounds_count, allocated_sounds_size / 1024,
+           allocated_sounds_peak / 1024, snd_cachesize / 1024);
+}
+
 static boolean I_SDL_InitSound(boolean _use_sfx_prefix)
 {
     int i;
@@ -1113,6 +1263,11 @@ static boolean I_SDL_InitSound(boolean _use_sfx_prefix)
 
     sound_initialized = true;
 
+    if (M_ParmExists("-devparm"))
+    {
+        I_AtExit(PrintSoundCacheStats, false);
+    }
+
     return true;
 }
 
@@ -17,6 +17,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "SDL_mixer.h"
 
@@ -24,10 +25,14 @@
 #include "doomtype.h"
 
 #include "gusconf.h"
+#include "i_offscreen.h"
 #include "i_sound.h"
 #include "i_video.h"
 #include "m_argv.h"
 #include "m_config.h"
+#include "memio.h"
+#include "mus2mid.h"
+#include "sha1.h"
 
 // Sound sample rate to use for digital output (Hz)
 
@@ -125,6 +130,18 @@ static void InitSfxModule(boolean use_sfx_prefix)
 
     sound_module = NULL;
 
+    // Offscreen rendering mixes sound effects into its own output.
+
+    if (I_OffscreenRequested())
+    {
+        if (snd_sfxdevice != SNDDEVICE_NONE
+         && sound_offscreen_module.Init(use_sfx_prefix))
+        {
+            sound_module = &sound_offscreen_module;
+        }
+        return;
+    }
+
     for (i=0; sound_modules[i] != NULL; ++i)
     {
         // Is the sfx device in the list of devices supported by
@@ -153,6 +170,18 @@ static void InitMusicModule(void)
 
     music_module = NULL;
 
+    // Offscreen rendering can only play music through the OPL
+    // emulator, which it drives itself.
+
+    if (I_OffscreenRequested())
+    {
+        if (snd_musicdevice != SNDDEVICE_NONE && music_opl_module.Init())
+        {
+            music_module = &music_opl_module;
+        }
+        return;
+    }
+
     for (i=0; music_modules[i] != NULL; ++i)
     {
         // Is the music device in the list of devices supported
@@ -191,6 +220,11 @@ void I_InitSound(boolean use_sfx_prefix)
 
     nosound = M_CheckParm("-nosound") > 0;
 
+    // There is no audio device to play to when rendering offscreen;
+    // sound is only mixed if there is a file to write it to.
+    nosound = nosound
+           || (I_OffscreenRequested() && !I_OffscreenAudioRequested());
+
     //!
     // @vanilla
     //
@@ -244,7 +278,8 @@ void I_InitSound(boolean use_sfx_prefix)
         }
 
         // We may also have substitute MIDIs we can load.
-        if (!nomusicpacks && music_module != NULL)
+        if (!nomusicpacks && music_module != NULL
+         && !I_OffscreenRequested())
         {
             music_packs_active = music_pack_module.Init();
         }
@@ -369,6 +404,28 @@ void I_InitMusic(void)
 {
 }
 
+void I_CheckRenderMusic(void)
+{
+    int p;
+
+    //!
+    // @category obscure
+    // @arg <directory>
+    //
+    // Play all music found in loaded WAD files through the OPL
+    // emulator as fast as possible, write each song to a WAV file
+    // in the given directory, and quit.  The DMXOPTION setting is
+    // honored (-opl3, -reverse).
+    //
+
+    p = M_CheckParmWithArgs("-rendermusic", 1);
+
+    if (p > 0)
+    {
+        I_OPL_RenderMusic(myargv[p + 1]);
+    }
+}
+
 void I_ShutdownMusic(void)
 {
 
@@ -433,6 +490,103 @@ void *I_RegisterSong(void *data, int len)
     }
 }
 
+// Number of converted songs kept by I_GetMIDIData.
+
+#define MIDI_CACHE_SIZE 16
+
+// Largest MIDI lump that is used without conversion; anything bigger is
+// assumed to be a MUS lump that happens to begin with "MThd".
+
+#define MAXMIDLENGTH (96 * 1024)
+
+typedef struct
+{
+    sha1_digest_t hash;
+    void *data;
+    size_t len;
+} midicache_t;
+
+static midicache_t midi_cache[MIDI_CACHE_SIZE];
+static int midi_cache_next = 0;
+
+boolean I_GetMIDIData(void *data, int len, void **mid, size_t *midlen)
+{
+    sha1_context_t context;
+    sha1_digest_t hash;
+    midicache_t *entry;
+    MEMFILE *instream;
+    MEMFILE *outstream;
+    void *outbuf;
+    size_t outbuf_len;
+    int i;
+
+    if (len > 4 && len < MAXMIDLENGTH && !memcmp(data, "MThd", 4))
+    {
+        *mid = data;
+        *midlen = len;
+        return true;
+    }
+
+    // Level changes often come back to the same song, so look for an
+    // earlier conversion first.
+
+    SHA1_Init(&context);
+    SHA1_Update(&context, data, len);
+    SHA1_Final(hash, &context);
+
+    for (i = 0; i < MIDI_CACHE_SIZE; ++i)
+    {
+        if (midi_cache[i].data != NULL
+         && !memcmp(midi_cache[i].hash, hash, sizeof(sha1_digest_t)))
+        {
+            *mid = midi_cache[i].data;
+            *midlen = midi_cache[i].len;
+            return true;
+        }
+    }
+
+    // Assume a MUS file and try to convert
+
+    instream = mem_fopen_read(data, len);
+    outstream = mem_fopen_write();
+
+    if (mus2mid(instream, outstream))
+    {
+        mem_fclose(instream);
+        mem_fclose(outstream);
+        return false;
+    }
+
+    mem_get_buf(outstream, &outbuf, &outbuf_len);
+
+    // Replace the oldest entry.
+
+    entry = &midi_cache[midi_cache_next];
+    midi_cache_next = (midi_cache_next + 1) % MIDI_CACHE_SIZE;
+
+    free(entry->data);
+    entry->data = malloc(outbuf_len);
+
+    if (entry->data == NULL)
+    {
+        mem_fclose(instream);
+        mem_fclose(outstream);
+        return false;
+    }
+
+    memcpy(entry->hash, hash, sizeof(sha1_digest_t));
+    memcpy(entry->data, outbuf, outbuf_len);
+    entry->len = outbuf_len;
+
+    mem_fclose(instream);
+    mem_fclose(outstream);
+
+    *mid = entry->data;
+    *midlen = entry->len;
+
+    return true;
+}
+
 void I_UnRegisterSong(void *handle)
 {
     if (active_music_module != NULL)
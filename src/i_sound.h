@@ -217,6 +217,12 @@ typedef struct
 } music_module_t;
 
 void I_InitMusic(void);
+
+// With -rendermusic, write all music to WAV files and quit.  Must be
+// called after S_Init, as the music is rendered with the DMX version
+// that S_Init picks for the OPL driver.
+
+void I_CheckRenderMusic(void);
 void I_ShutdownMusic(void);
 void I_SetMusicVolume(int volume);
 void I_PauseSong(void);
@@ -227,6 +233,12 @@ void I_PlaySong(void *handle, boolean looping);
 void I_StopSong(void);
 boolean I_MusicIsPlaying(void);
 
+// Get song data as a MIDI file, converting it from MUS if necessary.
+// Conversions are cached, and the result must not be freed; it stays
+// valid until sixteen other songs have been converted.
+// Returns false if the data cannot be converted.
+boolean I_GetMIDIData(void *data, int len, void **mid, size_t *midlen);
+
 extern int snd_sfxdevice;
 extern int snd_musicdevice;
 extern int snd_samplerate;
@@ -248,6 +260,7 @@ typedef enum {
 } opl_driver_ver_t;
 
 void I_SetOPLDriverVer(opl_driver_ver_t ver);
+void I_OPL_RenderMusic(const char *dir);
 void I_OPL_DevMessages(char *, size_t);
 
 // Sound modules
@@ -255,6 +268,7 @@ void I_OPL_DevMessages(char *, size_t);
 void I_InitTimidityConfig(void);
 extern sound_module_t sound_sdl_module;
 extern sound_module_t sound_pcsound_module;
+extern sound_module_t sound_offscreen_module;
 extern music_module_t music_sdl_module;
 extern music_module_t music_opl_module;
 extern music_module_t music_pack_module;
@@ -0,0 +1,196 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//      Thread functions.
+//
+
+#include <stdlib.h>
+
+#include "SDL.h"
+#include "SDL_thread.h"
+
+#include "i_system.h"
+#include "i_thread.h"
+#include "m_misc.h"
+
+struct ithread_s
+{
+    SDL_Thread *thread;
+    ithreadfunc_t func;
+    void *data;
+};
+
+struct iworkers_s
+{
+    SDL_mutex *lock;
+    SDL_cond *work_cond;
+    SDL_cond *done_cond;
+
+    // Current batch of jobs.  generation is bumped for every new batch
+    // so that idle workers know there is something to do.
+    ijobfunc_t func;
+    void *data;
+    int numjobs;
+    int nextjob;
+    int jobsdone;
+    unsigned int generation;
+};
+
+static int ThreadEntry(void *arg)
+{
+    ithread_t *thread = arg;
+
+    thread->func(thread->data);
+
+    return 0;
+}
+
+ithread_t *I_StartThread(ithreadfunc_t func, void *data, const char *name)
+{
+    ithread_t *thread;
+
+    thread = malloc(sizeof(ithread_t));
+    thread->func = func;
+    thread->data = data;
+    thread->thread = SDL_CreateThread(ThreadEntry, name, thread);
+
+    if (thread->thread == NULL)
+    {
+        I_Error("I_StartThread: Failed to start thread '%s': %s",
+                name, SDL_GetError());
+    }
+
+    return thread;
+}
+
+void I_WaitThread(ithread_t *thread)
+{
+    SDL_WaitThread(thread->thread, NULL);
+    free(thread);
+}
+
+int I_GetCPUCount(void)
+{
+    return SDL_GetCPUCount();
+}
+
+// Take jobs from the current batch until none are left.  Called with
+// the pool lock held; the lock is dropped while each job runs.
+
+static void RunPendingJobs(iworkers_t *workers)
+{
+    int job;
+
+    while (workers->nextjob < workers->numjobs)
+    {
+        job = workers->nextjob;
+        ++workers->nextjob;
+
+        SDL_UnlockMutex(workers->lock);
+        workers->func(workers->data, job);
+        SDL_LockMutex(workers->lock);
+
+        ++workers->jobsdone;
+
+        if (workers->jobsdone == workers->numjobs)
+        {
+            SDL_CondBroadcast(workers->done_cond);
+        }
+    }
+}
+
+static int WorkerThread(void *arg)
+{
+    iworkers_t *workers = arg;
+    unsigned int seen;
+
+    SDL_LockMutex(workers->lock);
+
+    seen = workers->generation;
+
+    for (;;)
+    {
+        while (workers->generation == seen)
+        {
+            SDL_CondWait(workers->work_cond, workers->lock);
+        }
+
+        seen = workers->generation;
+        RunPendingJobs(workers);
+    }
+
+    return 0;
+}
+
+iworkers_t *I_CreateWorkers(int numthreads, const char *name)
+{
+    iworkers_t *workers;
+    char buf[32];
+    int i;
+
+    workers = malloc(sizeof(iworkers_t));
+    workers->lock = SDL_CreateMutex();
+    workers->work_cond = SDL_CreateCond();
+    workers->done_cond = SDL_CreateCond();
+    workers->func = NULL;
+    workers->data = NULL;
+    workers->numjobs = 0;
+    workers->nextjob = 0;
+    workers->jobsdone = 0;
+    workers->generation = 0;
+
+    for (i = 0; i < numthreads; ++i)
+    {
+        M_snprintf(buf, sizeof(buf), "%s%i", name, i);
+
+        if (SDL_CreateThread(WorkerThread, buf, workers) == NULL)
+        {
+            I_Error("I_CreateWorkers: Failed to start thread '%s': %s",
+                    buf, SDL_GetError());
+        }
+    }
+
+    return workers;
+}
+
+void I_RunJobs(iworkers_t *workers, ijobfunc_t func, void *data, int numjobs)
+{
+    if (numjobs <= 0)
+    {
+        return;
+    }
+
+    SDL_LockMutex(workers->lock);
+
+    workers->func = func;
+    workers->data = data;
+    workers->numjobs = numjobs;
+    workers->nextjob = 0;
+    workers->jobsdone = 0;
+    ++workers->generation;
+
+    SDL_CondBroadcast(workers->work_cond);
+
+    // The calling thread helps out rather than sitting idle.
+
+    RunPendingJobs(workers);
+
+    while (workers->jobsdone < workers->numjobs)
+    {
+        SDL_CondWait(workers->done_cond, workers->lock);
+    }
+
+    SDL_UnlockMutex(workers->lock);
+}
+
@@ -0,0 +1,46 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//      System-specific thread interface
+//
+
+
+#ifndef __I_THREAD__
+#define __I_THREAD__
+
+typedef struct ithread_s ithread_t;
+typedef struct iworkers_s iworkers_t;
+
+typedef void (*ithreadfunc_t)(void *data);
+typedef void (*ijobfunc_t)(void *data, int job);
+
+// Start a new thread running func(data).
+ithread_t *I_StartThread(ithreadfunc_t func, void *data, const char *name);
+
+// Wait for a thread started by I_StartThread to finish, then free it.
+void I_WaitThread(ithread_t *thread);
+
+// Number of logical CPUs on this machine.
+int I_GetCPUCount(void);
+
+// Create a pool of worker threads.  The threads live until the
+// program exits.
+iworkers_t *I_CreateWorkers(int numthreads, const char *name);
+
+// Run func(data, job) for every job in [0, numjobs), spread across the
+// pool and the calling thread.  Returns once every job has completed.
+void I_RunJobs(iworkers_t *workers, ijobfunc_t func, void *data, int numjobs);
+
+#endif
+
@@ -57,6 +57,31 @@ int I_GetTimeMS(void)
     return ticks - basetime;
 }
 
+//
+// Microsecond clock for profiling.  Unlike the functions above this
+// uses the performance counter rather than SDL_GetTicks.
+//
+
+uint64_t I_GetTimeUS(void)
+{
+    static Uint64 basecount = 0, frequency;
+    Uint64 count;
+
+    count = SDL_GetPerformanceCounter();
+
+    if (basecount == 0)
+    {
+        basecount = count;
+        frequency = SDL_GetPerformanceFrequency();
+    }
+
+    count -= basecount;
+
+    // Split the division so that large counts cannot overflow.
+    return (count / frequency) * 1000000
+         + ((count % frequency) * 1000000) / frequency;
+}
+
 // Sleep for a specified number of ms
 
 void I_Sleep(int ms)
@@ -36,6 +36,7 @@
 #include "doomtype.h"
 #include "i_input.h"
 #include "i_joystick.h"
+#include "i_offscreen.h"
 #include "i_system.h"
 #include "i_timer.h"
 #include "i_video.h"
@@ -89,6 +90,9 @@ int usegamma = 0;
 // display has been set up?
 static boolean initialized = false;
 
+// rendering to a file rather than a window (-offscreen)?
+static boolean offscreen = false;
+
 // disable mouse?
 static boolean nomouse = false;
 int usemouse = 1;
@@ -217,7 +221,12 @@ static void SetShowCursor(boolean show)
 
 void I_ShutdownGraphics(void)
 {
-    if (initialized)
+    if (initialized && offscreen)
+    {
+        I_ShutdownOffscreen();
+        initialized = false;
+    }
+    else if (initialized)
     {
         SetShowCursor(true);
         SDL_QuitSubSystem(SDL_INIT_VIDEO);
@@ -386,7 +395,7 @@ void I_GetEvent(void)
 //
 void I_StartTic (void)
 {
-    if (!initialized)
+    if (!initialized || offscreen)
         return;
 
     I_GetEvent();
@@ -551,6 +560,29 @@ static void CreateUpscaledTexture(boolean force)
         SDL_DestroyTexture(old_texture);
 }
 
+//
+// Hand the frame to the offscreen output instead of the window.
+//
+static void FinishOffscreenUpdate(void)
+{
+    byte rgb[256 * 3];
+
+    if (palette_to_set)
+    {
+        for (int i = 0; i < 256; ++i)
+        {
+            rgb[i * 3] = palette[i].r;
+            rgb[i * 3 + 1] = palette[i].g;
+            rgb[i * 3 + 2] = palette[i].b;
+        }
+
+        I_OffscreenSetPalette(rgb);
+        palette_to_set = false;
+    }
+
+    I_OffscreenFrame(I_VideoBuffer);
+}
+
 //
 // I_FinishUpdate
 //
@@ -566,6 +598,12 @@ void I_FinishUpdate (void)
     if (noblit)
         return;
 
+    if (offscreen)
+    {
+        FinishOffscreenUpdate();
+        return;
+    }
+
     if (need_resize)
     {
         if (SDL_GetTicks() > last_resize_time + RESIZE_DELAY)
@@ -722,6 +760,9 @@ void I_InitWindowTitle(void)
 {
     char *buf;
 
+    if (offscreen)
+        return;
+
     buf = M_StringJoin(window_title, " - ", PACKAGE_STRING, NULL);
     SDL_SetWindowTitle(screen, buf);
     free(buf);
@@ -738,6 +779,9 @@ void I_RegisterWindowIcon(const unsigned int *icon, int width, int height)
 void I_InitWindowIcon(void)
 {
     SDL_Surface *surface;
+
+    if (offscreen)
+        return;
     surface = SDL_CreateRGBSurfaceFrom((void *) icon_data, icon_w, icon_h,
                                        32, icon_w * 4,
                                        0xffu << 24, 0xffu << 16,
@@ -1161,12 +1205,41 @@ static void SetVideoMode(void)
     CreateUpscaledTexture(true);
 }
 
+//
+// Set up rendering into a plain memory buffer, with no window.
+// Every tic is drawn once, as fast as possible.
+//
+static void InitOffscreenGraphics(void)
+{
+    I_InitOffscreen();
+
+    offscreen = true;
+    singletics = true;
+
+    I_VideoBuffer = Z_Malloc(SCREENWIDTH * SCREENHEIGHT * sizeof(*I_VideoBuffer),
+                             PU_STATIC, NULL);
+    V_RestoreBuffer();
+    memset(I_VideoBuffer, 0, SCREENWIDTH * SCREENHEIGHT * sizeof(*I_VideoBuffer));
+
+    I_SetPalette(W_CacheLumpName(DEH_String("PLAYPAL"), PU_CACHE));
+
+    initialized = true;
+
+    I_AtExit(I_ShutdownGraphics, true);
+}
+
 void I_InitGraphics(void)
 {
     SDL_Event dummy;
     byte *doompal;
     char *env;
 
+    if (I_OffscreenRequested())
+    {
+        InitOffscreenGraphics();
+        return;
+    }
+
     // Pass through the XSCREENSAVER_WINDOW environment variable to 
     // SDL_WINDOWID, to embed the SDL window into the Xscreensaver
     // window.
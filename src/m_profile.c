@@ -0,0 +1,312 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//      Per-frame profiler.  Each frame records the time spent in the
+//      main phases of the game loop; the records are written out as
+//      CSV or JSON when the program exits, along with a summary.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "doomtype.h"
+#include "i_system.h"
+#include "i_timer.h"
+#include "m_argv.h"
+#include "m_misc.h"
+#include "m_profile.h"
+
+typedef struct
+{
+    int gametic;
+    uint32_t phase[NUMPROFPHASES];
+    uint32_t total;
+} profframe_t;
+
+static const char *phase_names[NUMPROFPHASES] =
+{
+    "ticker",
+    "bsp",
+    "planes",
+    "masked",
+    "hud",
+    "update",
+};
+
+boolean profiling = false;
+
+static const char *profile_filename;
+
+static profframe_t *frames = NULL;
+static int numframes = 0;
+static int maxframes = 0;
+
+static profframe_t curframe;
+static uint64_t phase_start[NUMPROFPHASES];
+static uint64_t frame_start;
+static boolean frame_started;
+
+void M_ProfileStart(profphase_t phase)
+{
+    if (!profiling)
+    {
+        return;
+    }
+
+    phase_start[phase] = I_GetTimeUS();
+}
+
+void M_ProfileStop(profphase_t phase)
+{
+    if (!profiling)
+    {
+        return;
+    }
+
+    curframe.phase[phase] += (uint32_t) (I_GetTimeUS() - phase_start[phase]);
+}
+
+void M_ProfileEndFrame(int gametic)
+{
+    uint64_t now;
+
+    if (!profiling)
+    {
+        return;
+    }
+
+    now = I_GetTimeUS();
+
+    // Frames are timed from one frame boundary to the next, so the
+    // first call only starts the clock; what came before it is
+    // startup, not a frame.
+
+    if (!frame_started)
+    {
+        memset(&curframe, 0, sizeof(curframe));
+        frame_start = now;
+        frame_started = true;
+        return;
+    }
+
+    if (numframes >= maxframes)
+    {
+        maxframes = maxframes ? maxframes * 2 : 1024;
+        frames = I_Realloc(frames, maxframes * sizeof(*frames));
+    }
+
+    curframe.gametic = gametic;
+    curframe.total = (uint32_t) (now - frame_start);
+    frames[numframes++] = curframe;
+
+    memset(&curframe, 0, sizeof(curframe));
+    frame_start = now;
+}
+
+static int CompareTimes(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *) a, y = *(const uint32_t *) b;
+
+    return (x > y) - (x < y);
+}
+
+// Fill in min/avg/p99/max for one column of the frame records.  A
+// phase of NUMPROFPHASES means the total frame time.
+
+static void Summarize(uint32_t *times, int phase, uint32_t result[4])
+{
+    uint64_t sum;
+    int i;
+
+    sum = 0;
+
+    for (i = 0; i < numframes; ++i)
+    {
+        if (phase == NUMPROFPHASES)
+        {
+            times[i] = frames[i].total;
+        }
+        else
+        {
+            times[i] = frames[i].phase[phase];
+        }
+
+        sum += times[i];
+    }
+
+    qsort(times, numframes, sizeof(*times), CompareTimes);
+
+    // Nearest-rank 99th percentile.
+
+    result[0] = times[0];
+    result[1] = (uint32_t) (sum / numframes);
+    result[2] = times[(numframes * 99 + 99) / 100 - 1];
+    result[3] = times[numframes - 1];
+}
+
+static void WriteCSV(FILE *stream)
+{
+    int i, p;
+
+    fprintf(stream, "frame,gametic");
+
+    for (p = 0; p < NUMPROFPHASES; ++p)
+    {
+        fprintf(stream, ",%s", phase_names[p]);
+    }
+
+    fprintf(stream, ",total\n");
+
+    for (i = 0; i < numframes; ++i)
+    {
+        fprintf(stream, "%i,%i", i, frames[i].gametic);
+
+        for (p = 0; p < NUMPROFPHASES; ++p)
+        {
+            fprintf(stream, ",%u", frames[i].phase[p]);
+        }
+
+        fprintf(stream, ",%u\n", frames[i].total);
+    }
+}
+
+static void WriteJSON(FILE *stream, uint32_t summary[][4])
+{
+    static const char *stat_names[4] = { "min", "avg", "p99", "max" };
+    int i, p, s;
+
+    fprintf(stream, "{\n  \"units\": \"us\",\n  \"summary\": {\n");
+
+    for (p = 0; p <= NUMPROFPHASES; ++p)
+    {
+        fprintf(stream, "    \"%s\": {",
+                p < NUMPROFPHASES ? phase_names[p] : "total");
+
+        for (s = 0; s < 4; ++s)
+        {
+            fprintf(stream, "%s\"%s\": %u", s > 0 ? ", " : " ",
+                    stat_names[s], summary[p][s]);
+        }
+
+        fprintf(stream, " }%s\n", p < NUMPROFPHASES ? "," : "");
+    }
+
+    fprintf(stream, "  },\n  \"frames\": [\n");
+
+    for (i = 0; i < numframes; ++i)
+    {
+        fprintf(stream, "    { \"gametic\": %i", frames[i].gametic);
+
+        for (p = 0; p < NUMPROFPHASES; ++p)
+        {
+            fprintf(stream, ", \"%s\": %u", phase_names[p], frames[i].phase[p]);
+        }
+
+        fprintf(stream, ", \"total\": %u }%s\n",
+                frames[i].total, i < numframes - 1 ? "," : "");
+    }
+
+    fprintf(stream, "  ]\n}\n");
+}
+
+static void ProfileReport(void)
+{
+    uint32_t summary[NUMPROFPHASES + 1][4];
+    uint32_t *times;
+    FILE *stream;
+    int p;
+
+    if (numframes == 0)
+    {
+        return;
+    }
+
+    times = malloc(numframes * sizeof(*times));
+
+    if (times == NULL)
+    {
+        return;
+    }
+
+    for (p = 0; p <= NUMPROFPHASES; ++p)
+    {
+        Summarize(times, p, summary[p]);
+    }
+
+    free(times);
+
+    printf("Frame profile (%i frames, ms):\n", numframes);
+    printf("  %-8s %9s %9s %9s %9s\n", "phase", "min", "avg", "p99", "max");
+
+    for (p = 0; p <= NUMPROFPHASES; ++p)
+    {
+        printf("  %-8s %9.3f %9.3f %9.3f %9.3f\n",
+               p < NUMPROFPHASES ? phase_names[p] : "total",
+               summary[p][0] / 1000.0, summary[p][1] / 1000.0,
+               summary[p][2] / 1000.0, summary[p][3] / 1000.0);
+    }
+
+    stream = M_fopen(profile_filename, "w");
+
+    if (stream == NULL)
+    {
+        printf("ProfileReport: Failed to open %s for writing\n",
+               profile_filename);
+        return;
+    }
+
+    if (M_StringEndsWith(profile_filename, ".json"))
+    {
+        WriteJSON(stream, summary);
+    }
+    else
+    {
+        WriteCSV(stream);
+    }
+
+    fclose(stream);
+}
+
+void M_InitProfile(void)
+{
+    int p;
+
+    //!
+    // @arg <file>
+    // @category demo
+    //
+    // Time the main phases of every frame (game tic, BSP, planes,
+    // sprites, status bar/HUD, screen update) and write them to
+    // the given file when the program exits.  The file is written
+    // as JSON if its name ends in .json, otherwise as CSV.  Times
+    // are in microseconds; a summary is printed to stdout.
+    // Combined with -timedemo, the program exits normally at the
+    // end of the demo instead of reporting the result as an error.
+    //
+
+    p = M_CheckParmWithArgs("-profile", 1);
+
+    if (p > 0)
+    {
+        profile_filename = myargv[p + 1];
+        profiling = true;
+
+        memset(&curframe, 0, sizeof(curframe));
+        frame_started = false;
+
+        I_AtExit(ProfileReport, true);
+    }
+}
+
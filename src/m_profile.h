@@ -0,0 +1,50 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//      Per-frame profiler.
+//
+
+
+#ifndef __M_PROFILE__
+#define __M_PROFILE__
+
+#include "doomtype.h"
+
+typedef enum
+{
+    PROF_TICKER,        // P_Ticker
+    PROF_BSP,           // R_RenderBSPNode
+    PROF_PLANES,        // R_DrawPlanes
+    PROF_MASKED,        // R_DrawMasked
+    PROF_HUD,           // ST_Drawer, HU_Drawer
+    PROF_UPDATE,        // I_FinishUpdate
+    NUMPROFPHASES
+} profphase_t;
+
+// True if -profile was given.
+extern boolean profiling;
+
+// Check for -profile and register the exit report.
+void M_InitProfile(void);
+
+// Time a phase.  A phase may be started and stopped more than once
+// in a frame; the times are added together.
+void M_ProfileStart(profphase_t phase);
+void M_ProfileStop(profphase_t phase);
+
+// Close the current frame record and start a new one.
+void M_ProfileEndFrame(int gametic);
+
+#endif
+
@@ -85,6 +85,16 @@ struct midi_file_s
     unsigned int buffer_size;
 };
 
+// Data being parsed.  Files are read into memory in one go and parsed
+// from there.
+
+typedef struct
+{
+    const byte *data;
+    size_t len;
+    size_t pos;
+} midi_stream_t;
+
 // Check the header of a chunk:
 
 static boolean CheckChunkHeader(chunk_header_t *chunk,
@@ -108,28 +118,37 @@ static boolean CheckChunkHeader(chunk_header_t *chunk,
 
 // Read a single byte.  Returns false on error.
 
-static boolean ReadByte(byte *result, FILE *stream)
+static boolean ReadByte(byte *result, midi_stream_t *stream)
 {
-    int c;
-
-    c = fgetc(stream);
-
-    if (c == EOF)
+    if (stream->pos >= stream->len)
     {
         fprintf(stderr, "ReadByte: Unexpected end of file\n");
         return false;
     }
-    else
-    {
-        *result = (byte) c;
 
-        return true;
+    *result = stream->data[stream->pos++];
+
+    return true;
+}
+
+// Read a block of data.  Returns false if there is not enough left.
+
+static boolean ReadBlock(void *result, size_t len, midi_stream_t *stream)
+{
+    if (len > stream->len - stream->pos)
+    {
+        return false;
     }
+
+    memcpy(result, stream->data + stream->pos, len);
+    stream->pos += len;
+
+    return true;
 }
 
 // Read a variable-length value.
 
-static boolean ReadVariableLength(unsigned int *result, FILE *stream)
+static boolean ReadVariableLength(unsigned int *result, midi_stream_t *stream)
 {
     int i;
     byte b = 0;
@@ -165,9 +184,8 @@ static boolean ReadVariableLength(unsigned int *result, FILE *stream)
 
 // Read a byte sequence into the data buffer.
 
-static void *ReadByteSequence(unsigned int num_bytes, FILE *stream)
+static void *ReadByteSequence(unsigned int num_bytes, midi_stream_t *stream)
 {
-    unsigned int i;
     byte *result;
 
     // Allocate a buffer. Allocate one extra byte, as malloc(0) is
@@ -183,15 +201,11 @@ static void *ReadByteSequence(unsigned int num_bytes, FILE *stream)
 
     // Read the data:
 
-    for (i=0; i<num_bytes; ++i)
+    if (!ReadBlock(result, num_bytes, stream))
     {
-        if (!ReadByte(&result[i], stream))
-        {
-            fprintf(stderr, "ReadByteSequence: Error while reading byte %u\n",
-                            i);
-            free(result);
-            return NULL;
-        }
+        fprintf(stderr, "ReadByteSequence: Unexpected end of file\n");
+        free(result);
+        return NULL;
     }
 
     return result;
@@ -203,7 +217,7 @@ static void *ReadByteSequence(unsigned int num_bytes, FILE *stream)
 
 static boolean ReadChannelEvent(midi_event_t *event,
                                 byte event_type, boolean two_param,
-                                FILE *stream)
+                                midi_stream_t *stream)
 {
     byte b = 0;
 
@@ -243,7 +257,7 @@ static boolean ReadChannelEvent(midi_event_t *event,
 // Read sysex event:
 
 static boolean ReadSysExEvent(midi_event_t *event, int event_type,
-                              FILE *stream)
+                              midi_stream_t *stream)
 {
     event->event_type = event_type;
 
@@ -269,7 +283,7 @@ static boolean ReadSysExEvent(midi_event_t *event, int event_type,
 
 // Read meta event:
 
-static boolean ReadMetaEvent(midi_event_t *event, FILE *stream)
+static boolean ReadMetaEvent(midi_event_t *event, midi_stream_t *stream)
 {
     byte b = 0;
 
@@ -308,7 +322,7 @@ static boolean ReadMetaEvent(midi_event_t *event, FILE *stream)
 }
 
 static boolean ReadEvent(midi_event_t *event, unsigned int *last_event_type,
-                         FILE *stream)
+                         midi_stream_t *stream)
 {
     byte event_type = 0;
 
@@ -332,12 +346,7 @@ static boolean ReadEvent(midi_event_t *event, unsigned int *last_event_type,
     if ((event_type & 0x80) == 0)
     {
         event_type = *last_event_type;
-
-        if (fseek(stream, -1, SEEK_CUR) < 0)
-        {
-            fprintf(stderr, "ReadEvent: Unable to seek in stream\n");
-            return false;
-        }
+        --stream->pos;
     }
     else
     {
@@ -412,14 +421,11 @@ static void FreeEvent(midi_event_t *event)
 
 // Read and check the track chunk header
 
-static boolean ReadTrackHeader(midi_track_t *track, FILE *stream)
+static boolean ReadTrackHeader(midi_track_t *track, midi_stream_t *stream)
 {
-    size_t records_read;
     chunk_header_t chunk_header;
 
-    records_read = fread(&chunk_header, sizeof(chunk_header_t), 1, stream);
-
-    if (records_read < 1)
+    if (!ReadBlock(&chunk_header, sizeof(chunk_header), stream))
     {
         return false;
     }
@@ -434,14 +440,16 @@ static boolean ReadTrackHeader(midi_track_t *track, FILE *stream)
     return true;
 }
 
-static boolean ReadTrack(midi_track_t *track, FILE *stream)
+static boolean ReadTrack(midi_track_t *track, midi_stream_t *stream)
 {
     midi_event_t *new_events;
     midi_event_t *event;
     unsigned int last_event_type;
+    int max_events;
 
     track->num_events = 0;
     track->events = NULL;
+    max_events = 0;
 
     // Read the header:
 
@@ -456,11 +464,16 @@ static boolean ReadTrack(midi_track_t *track, FILE *stream)
 
     for (;;)
     {
-        // Resize the track slightly larger to hold another event:
+        // Resize the track to hold another event, doubling its size
+        // each time so that long tracks are not copied over and over:
 
-        new_events = I_Realloc(track->events, 
-                             sizeof(midi_event_t) * (track->num_events + 1));
-        track->events = new_events;
+        if (track->num_events >= max_events)
+        {
+            max_events = max_events > 0 ? max_events * 2 : 64;
+            new_events = I_Realloc(track->events,
+                                   sizeof(midi_event_t) * max_events);
+            track->events = new_events;
+        }
 
         // Read the next event:
 
@@ -498,7 +511,7 @@ static void FreeTrack(midi_track_t *track)
     free(track->events);
 }
 
-static boolean ReadAllTracks(midi_file_t *file, FILE *stream)
+static boolean ReadAllTracks(midi_file_t *file, midi_stream_t *stream)
 {
     unsigned int i;
 
@@ -528,14 +541,11 @@ static boolean ReadAllTracks(midi_file_t *file, FILE *stream)
 
 // Read and check the header chunk.
 
-static boolean ReadFileHeader(midi_file_t *file, FILE *stream)
+static boolean ReadFileHeader(midi_file_t *file, midi_stream_t *stream)
 {
-    size_t records_read;
     unsigned int format_type;
 
-    records_read = fread(&file->header, sizeof(midi_header_t), 1, stream);
-
-    if (records_read < 1)
+    if (!ReadBlock(&file->header, sizeof(file->header), stream))
     {
         return false;
     }
@@ -580,10 +590,10 @@ void MIDI_FreeFile(midi_file_t *file)
     free(file);
 }
 
-midi_file_t *MIDI_LoadFile(char *filename)
+midi_file_t *MIDI_LoadFileFromMemory(const void *buf, size_t buflen)
 {
     midi_file_t *file;
-    FILE *stream;
+    midi_stream_t stream;
 
     file = malloc(sizeof(midi_file_t));
 
@@ -597,37 +607,63 @@ midi_file_t *MIDI_LoadFile(char *filename)
     file->buffer = NULL;
     file->buffer_size = 0;
 
-    // Open file
+    stream.data = buf;
+    stream.len = buflen;
+    stream.pos = 0;
 
-    stream = M_fopen(filename, "rb");
+    // Read MIDI file header
 
-    if (stream == NULL)
+    if (!ReadFileHeader(file, &stream))
     {
-        fprintf(stderr, "MIDI_LoadFile: Failed to open '%s'\n", filename);
         MIDI_FreeFile(file);
         return NULL;
     }
 
-    // Read MIDI file header
+    // Read all tracks:
 
-    if (!ReadFileHeader(file, stream))
+    if (!ReadAllTracks(file, &stream))
     {
-        fclose(stream);
         MIDI_FreeFile(file);
         return NULL;
     }
 
-    // Read all tracks:
+    return file;
+}
 
-    if (!ReadAllTracks(file, stream))
+midi_file_t *MIDI_LoadFile(char *filename)
+{
+    midi_file_t *file;
+    FILE *stream;
+    byte *buf;
+    long len;
+
+    // Open file
+
+    stream = M_fopen(filename, "rb");
+
+    if (stream == NULL)
     {
+        fprintf(stderr, "MIDI_LoadFile: Failed to open '%s'\n", filename);
+        return NULL;
+    }
+
+    len = M_FileLength(stream);
+    buf = malloc(len + 1);
+
+    if (buf == NULL || fread(buf, 1, len, stream) < (size_t) len)
+    {
+        fprintf(stderr, "MIDI_LoadFile: Failed to read '%s'\n", filename);
         fclose(stream);
-        MIDI_FreeFile(file);
+        free(buf);
         return NULL;
     }
 
     fclose(stream);
 
+    file = MIDI_LoadFileFromMemory(buf, len);
+
+    free(buf);
+
     return file;
 }
 
@@ -133,6 +133,11 @@ typedef struct
 
 midi_file_t *MIDI_LoadFile(char *filename);
 
+// Load a MIDI file from a buffer in memory.  The buffer is not needed
+// once this returns.
+
+midi_file_t *MIDI_LoadFileFromMemory(const void *buf, size_t buflen);
+
 // Free a MIDI file.
 
 void MIDI_FreeFile(midi_file_t *file);
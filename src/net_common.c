@@ -368,6 +368,66 @@ void NET_Conn_Run(net_connection_t *conn)
     }
 }
 
+// Returns the time in milliseconds until NET_Conn_Run next has something
+// to do for this connection, or -1 if it is only waiting for packets.
+
+int NET_Conn_TimeUntilRun(net_connection_t *conn)
+{
+    int nowtime;
+    int timeout;
+    int t;
+
+    nowtime = I_GetTimeMS();
+
+    if (conn->state == NET_CONN_STATE_CONNECTED)
+    {
+        timeout = NET_TimeUntilExpired(nowtime, conn->keepalive_recv_time,
+                                       CONNECTION_TIMEOUT_LEN * 1000);
+
+        t = NET_TimeUntilExpired(nowtime, conn->keepalive_send_time,
+                                 KEEPALIVE_PERIOD * 1000);
+        if (t < timeout)
+        {
+            timeout = t;
+        }
+
+        if (conn->reliable_packets != NULL)
+        {
+            if (conn->reliable_packets->last_send_time < 0)
+            {
+                t = 0;
+            }
+            else
+            {
+                t = NET_TimeUntilExpired(nowtime,
+                        conn->reliable_packets->last_send_time, 1000);
+            }
+
+            if (t < timeout)
+            {
+                timeout = t;
+            }
+        }
+
+        return timeout;
+    }
+    else if (conn->state == NET_CONN_STATE_DISCONNECTING)
+    {
+        if (conn->last_send_time < 0)
+        {
+            return 0;
+        }
+
+        return NET_TimeUntilExpired(nowtime, conn->last_send_time, 1000);
+    }
+    else if (conn->state == NET_CONN_STATE_DISCONNECTED_SLEEP)
+    {
+        return NET_TimeUntilExpired(nowtime, conn->last_send_time, 5000);
+    }
+
+    return -1;
+}
+
 net_packet_t *NET_Conn_NewReliable(net_connection_t *conn, int packet_type)
 {
     net_packet_t *packet;
@@ -428,6 +488,18 @@ unsigned int NET_ExpandTicNum(unsigned int relative, unsigned int b)
     return result;
 }
 
+// Timers are checked as "nowtime - since > period"; return how long it
+// is until such a check first succeeds.
+
+int NET_TimeUntilExpired(int nowtime, int since, int period)
+{
+    int remaining;
+
+    remaining = since + period + 1 - nowtime;
+
+    return remaining > 0 ? remaining : 0;
+}
+
 // Check that game settings are valid
 
 boolean NET_ValidGameSettings(GameMode_t mode, GameMission_t mission,
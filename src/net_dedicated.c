@@ -28,6 +28,13 @@
 #include "net_common.h"
 #include "net_sdl.h"
 #include "net_server.h"
+#include "net_udp.h"
+
+// Upper limit on how long to block waiting for packets, in milliseconds.
+// The wait is normally limited by the server's own timers; this is only
+// a safety net.
+
+#define MAX_WAIT_TIME 1000
 
 // 
 // People can become confused about how dedicated servers work.  Game
@@ -63,18 +70,49 @@ static void CheckForClientOptions(void)
 
 void NET_DedicatedServer(void)
 {
+    boolean native_udp;
+    int timeout;
+
     CheckForClientOptions();
 
     NET_OpenLog();
     NET_SV_Init();
-    NET_SV_AddModule(&net_sdl_module);
+
+    native_udp = NET_UDP_Requested();
+
+    if (native_udp)
+    {
+        NET_SV_AddModule(&net_udp_module);
+    }
+    else
+    {
+        NET_SV_AddModule(&net_sdl_module);
+    }
+
     NET_SV_RegisterWithMaster();
 
     while (true)
     {
         NET_SV_Run();
-        // TODO: Block on socket instead of polling.
-        I_Sleep(1);
+
+        // Sleep until a packet arrives or the next resend, keepalive or
+        // timeout is due.
+
+        timeout = NET_SV_TimeUntilRun();
+
+        if (timeout < 0 || timeout > MAX_WAIT_TIME)
+        {
+            timeout = MAX_WAIT_TIME;
+        }
+
+        if (native_udp)
+        {
+            NET_UDP_WaitForPacket(timeout);
+        }
+        else
+        {
+            NET_SDL_WaitForPacket(timeout);
+        }
     }
 }
 
@@ -23,15 +23,37 @@
 
 static int total_packet_memory = 0;
 
+// Packets that fit in POOLED_PACKET_SIZE bytes (any UDP datagram that
+// is not fragmented) get a buffer of that size, and are kept on a free
+// list when freed so that they can be reused without allocating.
+
+#define POOLED_PACKET_SIZE 1500
+#define MAX_FREE_PACKETS 256
+
+static net_packet_t *free_packets[MAX_FREE_PACKETS];
+static int num_free_packets = 0;
+
 net_packet_t *NET_NewPacket(int initial_size)
 {
     net_packet_t *packet;
 
-    packet = (net_packet_t *) Z_Malloc(sizeof(net_packet_t), PU_STATIC, 0);
-    
     if (initial_size == 0)
         initial_size = 256;
 
+    if (initial_size <= POOLED_PACKET_SIZE && num_free_packets > 0)
+    {
+        packet = free_packets[--num_free_packets];
+        packet->len = 0;
+        packet->pos = 0;
+
+        return packet;
+    }
+
+    packet = (net_packet_t *) Z_Malloc(sizeof(net_packet_t), PU_STATIC, 0);
+
+    if (initial_size < POOLED_PACKET_SIZE)
+        initial_size = POOLED_PACKET_SIZE;
+
     packet->alloced = initial_size;
     packet->data = Z_Malloc(initial_size, PU_STATIC, 0);
     packet->len = 0;
@@ -61,6 +83,13 @@ net_packet_t *NET_PacketDup(net_packet_t *packet)
 void NET_FreePacket(net_packet_t *packet)
 {
     //printf("%p: destroyed\n", packet);
+
+    if (packet->alloced == POOLED_PACKET_SIZE
+     && num_free_packets < MAX_FREE_PACKETS)
+    {
+        free_packets[num_free_packets++] = packet;
+        return;
+    }
     
     total_packet_memory -= sizeof(net_packet_t) + packet->alloced;
     Z_Free(packet->data);
@@ -0,0 +1,274 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//     Server receive path benchmark.  Replays a packet trace written
+//     by a server run with -nettrace through NET_SV_Run, using a
+//     network module that hands out the recorded packets in the same
+//     batches as they were received, and times it.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "doomtype.h"
+#include "i_system.h"
+#include "i_timer.h"
+#include "m_argv.h"
+#include "m_misc.h"
+#include "net_defs.h"
+#include "net_packet.h"
+#include "net_server.h"
+#include "z_zone.h"
+
+typedef struct
+{
+    unsigned int run;
+    int addr;                   // Index into addrs[]
+    byte *data;
+    unsigned int len;
+} tracepacket_t;
+
+typedef struct
+{
+    net_addr_t net_addr;
+    char *name;
+} traceaddr_t;
+
+static tracepacket_t *packets;
+static int num_packets;
+static int next_packet;
+
+static traceaddr_t *addrs;
+static int num_addrs;
+
+// Number of the NET_SV_Run call being replayed.
+
+static unsigned int current_run;
+
+static unsigned int packets_sent;
+static unsigned int bytes_sent;
+
+static net_module_t replay_module;
+
+static unsigned int ReadTraceInt(byte **p, byte *end, int bytes)
+{
+    unsigned int result;
+    int i;
+
+    if (*p + bytes > end)
+    {
+        I_Error("ReadTraceInt: Trace is truncated");
+    }
+
+    result = 0;
+
+    for (i=0; i<bytes; ++i)
+    {
+        result |= (*p)[i] << (i * 8);
+    }
+
+    *p += bytes;
+
+    return result;
+}
+
+// Addresses are only looked up while loading, so a search will do.
+
+static int TraceAddress(byte *name, unsigned int len)
+{
+    int i;
+
+    for (i=0; i<num_addrs; ++i)
+    {
+        if (strlen(addrs[i].name) == len
+         && !memcmp(addrs[i].name, name, len))
+        {
+            return i;
+        }
+    }
+
+    addrs = I_Realloc(addrs, (num_addrs + 1) * sizeof(*addrs));
+    addrs[num_addrs].name = malloc(len + 1);
+    memcpy(addrs[num_addrs].name, name, len);
+    addrs[num_addrs].name[len] = '\0';
+    addrs[num_addrs].net_addr.module = &replay_module;
+    addrs[num_addrs].net_addr.refcount = 0;
+    addrs[num_addrs].net_addr.handle = &addrs[num_addrs];
+
+    return num_addrs++;
+}
+
+static void LoadTrace(const char *filename)
+{
+    tracepacket_t *packet;
+    byte *buf, *p, *end;
+    unsigned int len;
+    int length;
+    int i;
+
+    length = M_ReadFile(filename, &buf);
+    p = buf;
+    end = buf + length;
+
+    if (length < strlen(NET_TRACE_MAGIC)
+     || memcmp(p, NET_TRACE_MAGIC, strlen(NET_TRACE_MAGIC)) != 0)
+    {
+        I_Error("LoadTrace: %s is not a packet trace", filename);
+    }
+
+    p += strlen(NET_TRACE_MAGIC);
+
+    while (p < end)
+    {
+        packets = I_Realloc(packets, (num_packets + 1) * sizeof(*packets));
+        packet = &packets[num_packets++];
+
+        packet->run = ReadTraceInt(&p, end, 4);
+
+        len = ReadTraceInt(&p, end, 2);
+        if (p + len > end)
+        {
+            I_Error("LoadTrace: Trace is truncated");
+        }
+        packet->addr = TraceAddress(p, len);
+        p += len;
+
+        packet->len = ReadTraceInt(&p, end, 2);
+        if (p + packet->len > end)
+        {
+            I_Error("LoadTrace: Trace is truncated");
+        }
+        packet->data = p;
+        p += packet->len;
+    }
+
+    // addrs[] may have moved while it grew.
+
+    for (i=0; i<num_addrs; ++i)
+    {
+        addrs[i].net_addr.handle = &addrs[i];
+    }
+}
+
+static boolean Replay_Init(void)
+{
+    return true;
+}
+
+static void Replay_SendPacket(net_addr_t *addr, net_packet_t *packet)
+{
+    ++packets_sent;
+    bytes_sent += packet->len;
+}
+
+static boolean Replay_RecvPacket(net_addr_t **addr, net_packet_t **packet)
+{
+    tracepacket_t *p;
+
+    if (next_packet >= num_packets || packets[next_packet].run > current_run)
+    {
+        return false;
+    }
+
+    p = &packets[next_packet++];
+
+    *packet = NET_NewPacket(p->len);
+    memcpy((*packet)->data, p->data, p->len);
+    (*packet)->len = p->len;
+
+    *addr = &addrs[p->addr].net_addr;
+
+    return true;
+}
+
+static void Replay_AddrToString(net_addr_t *addr, char *buffer, int buffer_len)
+{
+    traceaddr_t *traceaddr = addr->handle;
+
+    M_StringCopy(buffer, traceaddr->name, buffer_len);
+}
+
+static void Replay_FreeAddress(net_addr_t *addr)
+{
+    // Addresses live as long as the trace.
+}
+
+static net_addr_t *Replay_ResolveAddress(const char *address)
+{
+    return NULL;
+}
+
+static net_module_t replay_module =
+{
+    Replay_Init,
+    Replay_Init,
+    Replay_SendPacket,
+    Replay_RecvPacket,
+    Replay_AddrToString,
+    Replay_FreeAddress,
+    Replay_ResolveAddress,
+};
+
+void NET_CL_Run(void)
+{
+    // No client, as for the dedicated server.
+}
+
+void D_DoomMain(void)
+{
+    uint64_t start, elapsed;
+    unsigned int runs;
+
+    if (myargc != 2)
+    {
+        printf("Usage: %s <tracefile>\n", myargv[0]);
+        exit(-1);
+    }
+
+    Z_Init();
+
+    LoadTrace(myargv[1]);
+
+    if (num_packets == 0)
+    {
+        I_Error("The trace contains no packets.");
+    }
+
+    NET_SV_Init();
+    NET_SV_AddModule(&replay_module);
+
+    // Replay the trace from its first run to its last, calling
+    // NET_SV_Run once for each.
+
+    runs = 0;
+    start = I_GetTimeUS();
+
+    for (current_run = packets[0].run; next_packet < num_packets;
+         ++current_run)
+    {
+        NET_SV_Run();
+        ++runs;
+    }
+
+    elapsed = I_GetTimeUS() - start;
+
+    printf("%i packets from %i addresses in %u runs: %.3f ms, "
+           "%.2f us per packet\n",
+           num_packets, num_addrs, runs, elapsed / 1000.0,
+           (double) elapsed / num_packets);
+    printf("%u packets (%u bytes) sent in reply\n",
+           packets_sent, bytes_sent);
+}
+
@@ -21,6 +21,7 @@
 
 #include "doomtype.h"
 #include "i_system.h"
+#include "i_timer.h"
 #include "m_argv.h"
 #include "m_misc.h"
 #include "net_defs.h"
@@ -45,21 +46,27 @@ static boolean initted = false;
 static int port = DEFAULT_PORT;
 static UDPsocket udpsocket;
 static UDPpacket *recvpacket;
+static SDLNet_SocketSet socketset = NULL;
 
-typedef struct
+typedef struct addrpair_s
 {
     net_addr_t net_addr;
     IPaddress sdl_addr;
+    struct addrpair_s *next;
 } addrpair_t;
 
+// Addresses are kept in a hash table keyed on host and port, so that
+// the address of a received packet can be found without a search.
+
 static addrpair_t **addr_table;
 static int addr_table_size = -1;
+static int addr_table_count = 0;
 
 // Initializes the address table
 
 static void NET_SDL_InitAddrTable(void)
 {
-    addr_table_size = 16;
+    addr_table_size = 64;
 
     addr_table = Z_Malloc(sizeof(addrpair_t *) * addr_table_size,
                           PU_STATIC, 0);
@@ -72,58 +79,79 @@ static boolean AddressesEqual(IPaddress *a, IPaddress *b)
         && a->port == b->port;
 }
 
+// Bucket for an address; addr_table_size is a power of two.
+
+static int AddressHash(IPaddress *addr)
+{
+    uint32_t hash;
+
+    hash = (addr->host ^ ((uint32_t) addr->port << 16)) * 2654435761U;
+
+    return (hash >> 16) & (addr_table_size - 1);
+}
+
+// Double the size of the table once it is as full as it is large.
+
+static void NET_SDL_GrowAddrTable(void)
+{
+    addrpair_t **old_table;
+    addrpair_t *entry, *next;
+    int old_size;
+    int hash;
+    int i;
+
+    old_table = addr_table;
+    old_size = addr_table_size;
+
+    addr_table_size *= 2;
+    addr_table = Z_Malloc(sizeof(addrpair_t *) * addr_table_size,
+                          PU_STATIC, 0);
+    memset(addr_table, 0, sizeof(addrpair_t *) * addr_table_size);
+
+    for (i=0; i<old_size; ++i)
+    {
+        for (entry = old_table[i]; entry != NULL; entry = next)
+        {
+            next = entry->next;
+            hash = AddressHash(&entry->sdl_addr);
+            entry->next = addr_table[hash];
+            addr_table[hash] = entry;
+        }
+    }
+
+    Z_Free(old_table);
+}
+
 // Finds an address by searching the table.  If the address is not found,
 // it is added to the table.
 
 static net_addr_t *NET_SDL_FindAddress(IPaddress *addr)
 {
     addrpair_t *new_entry;
-    int empty_entry = -1;
-    int i;
+    addrpair_t *entry;
+    int hash;
 
     if (addr_table_size < 0)
     {
         NET_SDL_InitAddrTable();
     }
 
-    for (i=0; i<addr_table_size; ++i)
+    hash = AddressHash(addr);
+
+    for (entry = addr_table[hash]; entry != NULL; entry = entry->next)
     {
-        if (addr_table[i] != NULL
-         && AddressesEqual(addr, &addr_table[i]->sdl_addr))
+        if (AddressesEqual(addr, &entry->sdl_addr))
         {
-            return &addr_table[i]->net_addr;
+            return &entry->net_addr;
         }
-
-        if (empty_entry < 0 && addr_table[i] == NULL)
-            empty_entry = i;
     }
 
     // Was not found in list.  We need to add it.
 
-    // Is there any space in the table? If not, increase the table size
-
-    if (empty_entry < 0)
+    if (addr_table_count >= addr_table_size)
     {
-        addrpair_t **new_addr_table;
-        int new_addr_table_size;
-
-        // after reallocing, we will add this in as the first entry
-        // in the new block of memory
-
-        empty_entry = addr_table_size;
-        
-        // allocate a new array twice the size, init to 0 and copy 
-        // the existing table in.  replace the old table.
-
-        new_addr_table_size = addr_table_size * 2;
-        new_addr_table = Z_Malloc(sizeof(addrpair_t *) * new_addr_table_size,
-                                  PU_STATIC, 0);
-        memset(new_addr_table, 0, sizeof(addrpair_t *) * new_addr_table_size);
-        memcpy(new_addr_table, addr_table, 
-               sizeof(addrpair_t *) * addr_table_size);
-        Z_Free(addr_table);
-        addr_table = new_addr_table;
-        addr_table_size = new_addr_table_size;
+        NET_SDL_GrowAddrTable();
+        hash = AddressHash(addr);
     }
 
     // Add a new entry
@@ -135,22 +163,31 @@ static net_addr_t *NET_SDL_FindAddress(IPaddress *addr)
     new_entry->net_addr.handle = &new_entry->sdl_addr;
     new_entry->net_addr.module = &net_sdl_module;
 
-    addr_table[empty_entry] = new_entry;
+    new_entry->next = addr_table[hash];
+    addr_table[hash] = new_entry;
+    ++addr_table_count;
 
     return &new_entry->net_addr;
 }
 
 static void NET_SDL_FreeAddress(net_addr_t *addr)
 {
-    int i;
-    
-    for (i=0; i<addr_table_size; ++i)
+    addrpair_t **prev;
+    addrpair_t *entry;
+
+    if (addr_table_size > 0)
     {
-        if (addr == &addr_table[i]->net_addr)
+        prev = &addr_table[AddressHash(addr->handle)];
+
+        for (entry = *prev; entry != NULL; prev = &entry->next, entry = *prev)
         {
-            Z_Free(addr_table[i]);
-            addr_table[i] = NULL;
-            return;
+            if (addr == &entry->net_addr)
+            {
+                *prev = entry->next;
+                --addr_table_count;
+                Z_Free(entry);
+                return;
+            }
         }
     }
 
@@ -367,6 +404,37 @@ net_addr_t *NET_SDL_ResolveAddress(const char *address)
     }
 }
 
+void NET_SDL_WaitForPacket(int timeout)
+{
+    if (!initted)
+    {
+        return;
+    }
+
+    if (socketset == NULL)
+    {
+        socketset = SDLNet_AllocSocketSet(1);
+
+        if (socketset == NULL)
+        {
+            I_Error("NET_SDL_WaitForPacket: Unable to allocate socket set: %s",
+                    SDLNet_GetError());
+        }
+
+        SDLNet_UDP_AddSocket(socketset, udpsocket);
+    }
+
+    // A packet may already be queued; SDLNet_CheckSockets returns
+    // straight away in that case.
+
+    if (SDLNet_CheckSockets(socketset, timeout < 0 ? ~0U : timeout) < 0)
+    {
+        // The wait failed (eg. interrupted by a signal); do not spin.
+
+        I_Sleep(1);
+    }
+}
+
 // Complete module
 
 net_module_t net_sdl_module =
@@ -426,6 +494,15 @@ net_addr_t *NET_NULL_ResolveAddress(const char *address)
 }
 
 
+void NET_SDL_WaitForPacket(int timeout)
+{
+    if (timeout > 0)
+    {
+        I_Sleep(timeout);
+    }
+}
+
+
 net_module_t net_sdl_module =
 {
     NET_NULL_InitClient,
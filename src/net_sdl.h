@@ -22,5 +22,10 @@
 
 extern net_module_t net_sdl_module;
 
+// Block until a packet arrives on the socket or the timeout (in
+// milliseconds) expires.  A negative timeout waits indefinitely.
+
+void NET_SDL_WaitForPacket(int timeout);
+
 #endif /* #ifndef NET_SDL_H */
 
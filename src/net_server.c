@@ -38,6 +38,7 @@
 #include "net_server.h"
 #include "net_sdl.h"
 #include "net_structrw.h"
+#include "z_zone.h"
 
 // How often to refresh our registration with the master server.
 #define MASTER_REFRESH_PERIOD 30  /* twice per minute */
@@ -62,11 +63,20 @@ typedef enum
     SERVER_IN_GAME,
 } net_server_state_t;
 
-typedef struct
+struct net_game_s;
+
+typedef struct net_client_s
 {
     boolean active;
     int player_number;
     net_addr_t *addr;
+
+    // Game the client is in, and the next client in the same
+    // client_hash chain.
+
+    struct net_game_s *game;
+    struct net_client_s *hash_next;
+
     net_connection_t connection;
     int last_send_time;
     char *name;
@@ -143,14 +153,47 @@ typedef struct
     net_ticdiff_t diff;
 } net_client_recv_t;
 
-static net_server_state_t server_state;
+// State of one game hosted by the server.  A server normally hosts a
+// single game; with -maxgames it can host several at once, each with
+// its own clients, lobby and receive window.
+
+typedef struct net_game_s
+{
+    net_server_state_t server_state;
+    net_client_t clients[MAXNETNODES];
+    net_client_t *sv_players[NET_MAXPLAYERS];
+    unsigned int sv_gamemode;
+    unsigned int sv_gamemission;
+    net_gamesettings_t sv_settings;
+
+    // receive window
+
+    unsigned int recvwindow_start;
+    net_client_recv_t recvwindow[BACKUPTICS][NET_MAXPLAYERS];
+} net_game_t;
+
 static boolean server_initialized = false;
-static net_client_t clients[MAXNETNODES];
-static net_client_t *sv_players[NET_MAXPLAYERS];
 static net_context_t *server_context;
-static unsigned int sv_gamemode;
-static unsigned int sv_gamemission;
-static net_gamesettings_t sv_settings;
+
+// Packet trace being written (-nettrace), and the number of the current
+// call to NET_SV_Run.
+
+static FILE *trace_file = NULL;
+static unsigned int trace_run = 0;
+
+// Games are allocated as they are needed and reused once they have
+// ended; sv is the game currently being processed.
+
+static net_game_t **games;
+static int num_games;
+static int max_games = 1;
+static net_game_t *sv;
+
+// Active clients of all games, hashed on their address.
+
+#define CLIENT_HASH_SIZE 256
+
+static net_client_t *client_hash[CLIENT_HASH_SIZE];
 
 // For registration with master server:
 
@@ -158,12 +201,7 @@ static net_addr_t *master_server = NULL;
 static unsigned int master_refresh_time;
 static unsigned int master_resolve_time;
 
-// receive window
-
-static unsigned int recvwindow_start;
-static net_client_recv_t recvwindow[BACKUPTICS][NET_MAXPLAYERS];
-
-#define NET_SV_ExpandTicNum(b) NET_ExpandTicNum(recvwindow_start, (b))
+#define NET_SV_ExpandTicNum(b) NET_ExpandTicNum(sv->recvwindow_start, (b))
 
 static void NET_SV_DisconnectClient(net_client_t *client)
 {
@@ -216,9 +254,9 @@ static void NET_SV_BroadcastMessage(const char *s, ...)
 
     for (i=0; i<MAXNETNODES; ++i)
     {
-        if (ClientConnected(&clients[i]))
+        if (ClientConnected(&sv->clients[i]))
         {
-            NET_SV_SendConsoleMessage(&clients[i], "%s", buf);
+            NET_SV_SendConsoleMessage(&sv->clients[i], "%s", buf);
         }
     }
 
@@ -237,24 +275,24 @@ static void NET_SV_AssignPlayers(void)
 
     for (i=0; i<MAXNETNODES; ++i)
     {
-        if (ClientConnected(&clients[i]))
+        if (ClientConnected(&sv->clients[i]))
         {
-            if (!clients[i].drone)
+            if (!sv->clients[i].drone)
             {
-                sv_players[pl] = &clients[i];
-                sv_players[pl]->player_number = pl;
+                sv->sv_players[pl] = &sv->clients[i];
+                sv->sv_players[pl]->player_number = pl;
                 ++pl;
             }
             else
             {
-                clients[i].player_number = -1;
+                sv->clients[i].player_number = -1;
             }
         }
     }
 
     for (; pl<NET_MAXPLAYERS; ++pl)
     {
-        sv_players[pl] = NULL;
+        sv->sv_players[pl] = NULL;
     }
 }
 
@@ -269,7 +307,7 @@ static int NET_SV_NumPlayers(void)
 
     for (i=0; i<NET_MAXPLAYERS; ++i)
     {
-        if (sv_players[i] != NULL && ClientConnected(sv_players[i]))
+        if (sv->sv_players[i] != NULL && ClientConnected(sv->sv_players[i]))
         {
             result += 1;
         }
@@ -287,8 +325,8 @@ static int NET_SV_NumReadyPlayers(void)
 
     for (i = 0; i < MAXNETNODES; ++i)
     {
-        if (ClientConnected(&clients[i])
-         && !clients[i].drone && clients[i].ready)
+        if (ClientConnected(&sv->clients[i])
+         && !sv->clients[i].drone && sv->clients[i].ready)
         {
             ++result;
         }
@@ -305,9 +343,9 @@ static int NET_SV_MaxPlayers(void)
 
     for (i = 0; i < MAXNETNODES; ++i)
     {
-        if (ClientConnected(&clients[i]))
+        if (ClientConnected(&sv->clients[i]))
         {
-            return clients[i].max_players;
+            return sv->clients[i].max_players;
         }
     }
 
@@ -325,7 +363,7 @@ static int NET_SV_NumDrones(void)
 
     for (i=0; i<MAXNETNODES; ++i)
     {
-        if (ClientConnected(&clients[i]) && clients[i].drone)
+        if (ClientConnected(&sv->clients[i]) && sv->clients[i].drone)
         {
             result += 1;
         }
@@ -345,7 +383,7 @@ static int NET_SV_NumClients(void)
 
     for (i=0; i<MAXNETNODES; ++i)
     {
-        if (ClientConnected(&clients[i]))
+        if (ClientConnected(&sv->clients[i]))
         {
             ++count;
         }
@@ -369,14 +407,14 @@ static net_client_t *NET_SV_Controller(void)
     {
         // Can't be controller?
 
-        if (!ClientConnected(&clients[i]) || clients[i].drone)
+        if (!ClientConnected(&sv->clients[i]) || sv->clients[i].drone)
         {
             continue;
         }
 
-        if (best == NULL || clients[i].connect_time < best->connect_time)
+        if (best == NULL || sv->clients[i].connect_time < best->connect_time)
         {
-            best = &clients[i];
+            best = &sv->clients[i];
         }
     }
 
@@ -421,10 +459,10 @@ static void NET_SV_SendWaitingData(net_client_t *client)
     for (i = 0; i < wait_data.num_players; ++i)
     {
         M_StringCopy(wait_data.player_names[i],
-                     sv_players[i]->name,
+                     sv->sv_players[i]->name,
                      MAXPLAYERNAME);
         M_StringCopy(wait_data.player_addrs[i],
-                     NET_AddrToString(sv_players[i]->addr),
+                     NET_AddrToString(sv->sv_players[i]->addr),
                      MAXPLAYERNAME);
     }
 
@@ -450,11 +488,11 @@ static unsigned int NET_SV_LatestAcknowledged(void)
 
     for (i=0; i<MAXNETNODES; ++i) 
     {
-        if (ClientConnected(&clients[i]))
+        if (ClientConnected(&sv->clients[i]))
         {
-            if (clients[i].acknowledged < lowtic)
+            if (sv->clients[i].acknowledged < lowtic)
             {
-                lowtic = clients[i].acknowledged;
+                lowtic = sv->clients[i].acknowledged;
             }
         }
     }
@@ -480,7 +518,7 @@ static void NET_SV_AdvanceWindow(void)
 
     // Advance the recv window until it catches up with lowtic
 
-    while (recvwindow_start < lowtic)
+    while (sv->recvwindow_start < lowtic)
     {
         boolean should_advance;
 
@@ -491,12 +529,12 @@ static void NET_SV_AdvanceWindow(void)
 
         for (i=0; i<NET_MAXPLAYERS; ++i)
         {
-            if (sv_players[i] == NULL || !ClientConnected(sv_players[i]))
+            if (sv->sv_players[i] == NULL || !ClientConnected(sv->sv_players[i]))
             {
                 continue;
             }
 
-            if (!recvwindow[0][i].active)
+            if (!sv->recvwindow[0][i].active)
             {
                 should_advance = false;
                 break;
@@ -514,33 +552,223 @@ static void NET_SV_AdvanceWindow(void)
         
         // Advance the window
 
-        memmove(recvwindow, recvwindow + 1,
-                sizeof(*recvwindow) * (BACKUPTICS - 1));
-        memset(&recvwindow[BACKUPTICS-1], 0, sizeof(*recvwindow));
-        ++recvwindow_start;
-        NET_Log("server: advanced receive window to %d", recvwindow_start);
+        memmove(sv->recvwindow, sv->recvwindow + 1,
+                sizeof(*sv->recvwindow) * (BACKUPTICS - 1));
+        memset(&sv->recvwindow[BACKUPTICS-1], 0, sizeof(*sv->recvwindow));
+        ++sv->recvwindow_start;
+        NET_Log("server: advanced receive window to %d", sv->recvwindow_start);
+    }
+}
+
+static unsigned int ClientHash(net_addr_t *addr)
+{
+    return (unsigned int) (((uintptr_t) addr / sizeof(net_addr_t))
+                           * 2654435761U) % CLIENT_HASH_SIZE;
+}
+
+static void NET_SV_HashClient(net_client_t *client)
+{
+    unsigned int hash;
+
+    hash = ClientHash(client->addr);
+    client->hash_next = client_hash[hash];
+    client_hash[hash] = client;
+}
+
+static void NET_SV_UnhashClient(net_client_t *client)
+{
+    net_client_t **prev;
+
+    for (prev = &client_hash[ClientHash(client->addr)]; *prev != NULL;
+         prev = &(*prev)->hash_next)
+    {
+        if (*prev == client)
+        {
+            *prev = client->hash_next;
+            return;
+        }
     }
 }
 
-// Given an address, find the corresponding client
+// A client is taken out of the hash when it stops being active.
+
+static void NET_SV_DeactivateClient(net_client_t *client)
+{
+    NET_SV_UnhashClient(client);
+    client->active = false;
+}
+
+// Given an address, find the corresponding client.  The game it is in
+// becomes the current game.
 
 static net_client_t *NET_SV_FindClient(net_addr_t *addr)
 {
-    int i;
+    net_client_t *client;
 
-    for (i=0; i<MAXNETNODES; ++i) 
+    for (client = client_hash[ClientHash(addr)]; client != NULL;
+         client = client->hash_next)
     {
-        if (clients[i].active && clients[i].addr == addr)
+        if (client->addr == addr)
         {
             // found the client
 
-            return &clients[i];
+            sv = client->game;
+            return client;
         }
     }
 
     return NULL;
 }
 
+// Set up a game with no clients, waiting for players.
+
+static void NET_SV_InitGame(net_game_t *game)
+{
+    int i;
+
+    sv = game;
+
+    for (i=0; i<MAXNETNODES; ++i) 
+    {
+        sv->clients[i].active = false;
+    }
+
+    NET_SV_AssignPlayers();
+
+    sv->server_state = SERVER_WAITING_LAUNCH;
+    sv->sv_gamemode = indetermined;
+}
+
+static net_game_t *NET_SV_NewGame(void)
+{
+    net_game_t *game;
+
+    game = Z_Malloc(sizeof(net_game_t), PU_STATIC, 0);
+    memset(game, 0, sizeof(net_game_t));
+    NET_SV_InitGame(game);
+
+    games[num_games] = game;
+    ++num_games;
+
+    NET_Log("server: new game %d", num_games - 1);
+
+    return game;
+}
+
+// Choose the game that a new client should join, and make it the
+// current game.  A game still waiting to be launched that has room for
+// the client is preferred, then an empty game, then a new one.  When
+// no more games can be started the first game is used, so the client
+// gets the usual rejection message.
+
+static net_game_t *NET_SV_GameForNewClient(net_connect_data_t *data)
+{
+    net_game_t *empty;
+    int num_players;
+    int g;
+
+    empty = NULL;
+
+    for (g=0; g<num_games; ++g)
+    {
+        sv = games[g];
+
+        if (sv->server_state != SERVER_WAITING_LAUNCH)
+        {
+            continue;
+        }
+
+        NET_SV_AssignPlayers();
+        num_players = NET_SV_NumPlayers();
+
+        if (NET_SV_NumClients() == 0)
+        {
+            if (empty == NULL)
+            {
+                empty = sv;
+            }
+        }
+        else if (NET_SV_NumClients() < MAXNETNODES
+              && data->gamemode == sv->sv_gamemode
+              && data->gamemission == sv->sv_gamemission
+              && (data->drone || num_players < NET_SV_MaxPlayers()))
+        {
+            return sv;
+        }
+    }
+
+    if (empty != NULL)
+    {
+        sv = empty;
+    }
+    else if (num_games < max_games)
+    {
+        sv = NET_SV_NewGame();
+    }
+    else
+    {
+        sv = games[0];
+    }
+
+    return sv;
+}
+
+// Choose the game to describe in reply to a query from an address
+// that is not a client: a game waiting for players, preferring one
+// that already has some, or else what a new game would look like.
+// Unlike NET_SV_GameForNewClient, no game is created and no players
+// are reassigned; the game found is made the current game, and it is
+// up to the caller to restore the old one.
+
+static net_game_t *NET_SV_GameForQuery(void)
+{
+    static net_game_t new_game;
+    net_game_t *empty;
+    int g;
+
+    empty = NULL;
+
+    for (g=0; g<num_games; ++g)
+    {
+        sv = games[g];
+
+        if (sv->server_state != SERVER_WAITING_LAUNCH)
+        {
+            continue;
+        }
+
+        if (NET_SV_NumClients() == 0)
+        {
+            if (empty == NULL)
+            {
+                empty = sv;
+            }
+        }
+        else if (NET_SV_NumClients() < MAXNETNODES)
+        {
+            return sv;
+        }
+    }
+
+    if (empty != NULL)
+    {
+        sv = empty;
+    }
+    else if (num_games < max_games)
+    {
+        memset(&new_game, 0, sizeof(new_game));
+        new_game.server_state = SERVER_WAITING_LAUNCH;
+        new_game.sv_gamemode = indetermined;
+        sv = &new_game;
+    }
+    else
+    {
+        sv = games[0];
+    }
+
+    return sv;
+}
+
 // send a rejection packet to a client
 
 static void NET_SV_SendReject(net_addr_t *addr, const char *msg)
@@ -564,6 +792,8 @@ static void NET_SV_InitNewClient(net_client_t *client, net_addr_t *addr,
     NET_Conn_InitServer(&client->connection, addr, protocol);
     client->addr = addr;
     NET_ReferenceAddress(addr);
+    client->game = sv;
+    NET_SV_HashClient(client);
     client->last_send_time = -1;
 
     // init the ticcmd send queue
@@ -674,11 +904,16 @@ static void NET_SV_ParseSYN(net_packet_t *packet, net_client_t *client,
 
     // At this point we have received a valid SYN.
 
+    if (client == NULL)
+    {
+        NET_SV_GameForNewClient(&data);
+    }
+
     // Not accepting new connections?
-    if (server_state != SERVER_WAITING_LAUNCH)
+    if (sv->server_state != SERVER_WAITING_LAUNCH)
     {
         NET_Log("server: error: not in waiting launch state, server_state=%d",
-                server_state);
+                sv->server_state);
         NET_SV_SendReject(addr,
                           "Server is not currently accepting connections");
         return;
@@ -704,23 +939,23 @@ static void NET_SV_ParseSYN(net_packet_t *packet, net_client_t *client,
     // Adopt the game mode and mission of the first connecting client:
     if (num_players == 0 && !data.drone)
     {
-        sv_gamemode = data.gamemode;
-        sv_gamemission = data.gamemission;
+        sv->sv_gamemode = data.gamemode;
+        sv->sv_gamemission = data.gamemission;
         NET_Log("server: new game, mode=%d, mission=%d",
-                sv_gamemode, sv_gamemission);
+                sv->sv_gamemode, sv->sv_gamemission);
     }
 
     // Check the connecting client is playing the same game as all
     // the other clients
-    if (data.gamemode != sv_gamemode || data.gamemission != sv_gamemission)
+    if (data.gamemode != sv->sv_gamemode || data.gamemission != sv->sv_gamemission)
     {
         char msg[128];
         NET_Log("server: wrong mode/mission, %d != %d || %d != %d",
-                data.gamemode, sv_gamemode, data.gamemission, sv_gamemission);
+                data.gamemode, sv->sv_gamemode, data.gamemission, sv->sv_gamemission);
         M_snprintf(msg, sizeof(msg),
                    "Game mismatch: server is %s (%s), client is %s (%s)",
-                   D_GameMissionString(sv_gamemission),
-                   D_GameModeString(sv_gamemode),
+                   D_GameMissionString(sv->sv_gamemission),
+                   D_GameModeString(sv->sv_gamemode),
                    D_GameMissionString(data.gamemission),
                    D_GameModeString(data.gamemode));
 
@@ -735,9 +970,9 @@ static void NET_SV_ParseSYN(net_packet_t *packet, net_client_t *client,
 
         for (i=0; i<MAXNETNODES; ++i)
         {
-            if (!clients[i].active)
+            if (!sv->clients[i].active)
             {
-                client = &clients[i];
+                client = &sv->clients[i];
                 break;
             }
         }
@@ -754,7 +989,7 @@ static void NET_SV_ParseSYN(net_packet_t *packet, net_client_t *client,
 
         if (client->connection.state == NET_CONN_STATE_DISCONNECTED)
         {
-            client->active = false;
+            NET_SV_DeactivateClient(client);
         }
     }
 
@@ -807,10 +1042,10 @@ static void NET_SV_ParseLaunch(net_packet_t *packet, net_client_t *client)
 
     // Can only launch when we are in the waiting state.
 
-    if (server_state != SERVER_WAITING_LAUNCH)
+    if (sv->server_state != SERVER_WAITING_LAUNCH)
     {
         NET_Log("server: error: not in waiting launch state, state=%d",
-                server_state);
+                sv->server_state);
         return;
     }
 
@@ -821,17 +1056,17 @@ static void NET_SV_ParseLaunch(net_packet_t *packet, net_client_t *client)
 
     for (i=0; i<MAXNETNODES; ++i)
     {
-        if (!ClientConnected(&clients[i]))
+        if (!ClientConnected(&sv->clients[i]))
             continue;
 
-        launchpacket = NET_Conn_NewReliable(&clients[i].connection,
+        launchpacket = NET_Conn_NewReliable(&sv->clients[i].connection,
                                             NET_PACKET_TYPE_LAUNCH);
         NET_WriteInt8(launchpacket, num_players);
     }
 
     // Now in launch state.
 
-    server_state = SERVER_WAITING_START;
+    sv->server_state = SERVER_WAITING_START;
 }
 
 // Transition to the in-game state and send all players the start game
@@ -850,29 +1085,29 @@ static void StartGame(void)
 
     // Check if anyone is recording a demo and set lowres_turn if so.
 
-    sv_settings.lowres_turn = false;
+    sv->sv_settings.lowres_turn = false;
 
     for (i = 0; i < NET_MAXPLAYERS; ++i)
     {
-        if (sv_players[i] != NULL && sv_players[i]->recording_lowres)
+        if (sv->sv_players[i] != NULL && sv->sv_players[i]->recording_lowres)
         {
-            sv_settings.lowres_turn = true;
+            sv->sv_settings.lowres_turn = true;
         }
     }
 
-    sv_settings.num_players = NET_SV_NumPlayers();
+    sv->sv_settings.num_players = NET_SV_NumPlayers();
 
     // Copy player classes:
 
     for (i = 0; i < NET_MAXPLAYERS; ++i)
     {
-        if (sv_players[i] != NULL)
+        if (sv->sv_players[i] != NULL)
         {
-            sv_settings.player_classes[i] = sv_players[i]->player_class;
+            sv->sv_settings.player_classes[i] = sv->sv_players[i]->player_class;
         }
         else
         {
-            sv_settings.player_classes[i] = 0;
+            sv->sv_settings.player_classes[i] = 0;
         }
     }
 
@@ -882,25 +1117,25 @@ static void StartGame(void)
 
     for (i = 0; i < MAXNETNODES; ++i)
     {
-        if (!ClientConnected(&clients[i]))
+        if (!ClientConnected(&sv->clients[i]))
             continue;
 
-        clients[i].last_gamedata_time = nowtime;
+        sv->clients[i].last_gamedata_time = nowtime;
 
-        startpacket = NET_Conn_NewReliable(&clients[i].connection,
+        startpacket = NET_Conn_NewReliable(&sv->clients[i].connection,
                                            NET_PACKET_TYPE_GAMESTART);
 
-        sv_settings.consoleplayer = clients[i].player_number;
+        sv->sv_settings.consoleplayer = sv->clients[i].player_number;
 
-        NET_WriteSettings(startpacket, &sv_settings);
+        NET_WriteSettings(startpacket, &sv->sv_settings);
     }
 
     // Change server state
     NET_Log("server: beginning game state");
-    server_state = SERVER_IN_GAME;
+    sv->server_state = SERVER_IN_GAME;
 
-    memset(recvwindow, 0, sizeof(recvwindow));
-    recvwindow_start = 0;
+    memset(sv->recvwindow, 0, sizeof(sv->recvwindow));
+    sv->recvwindow_start = 0;
 }
 
 // Returns true when all nodes have indicated readiness to start the game.
@@ -911,7 +1146,7 @@ static boolean AllNodesReady(void)
 
     for (i = 0; i < MAXNETNODES; ++i)
     {
-        if (ClientConnected(&clients[i]) && !clients[i].ready)
+        if (ClientConnected(&sv->clients[i]) && !sv->clients[i].ready)
         {
             return false;
         }
@@ -943,9 +1178,9 @@ static void SendAllWaitingData(void)
 
     for (i = 0; i < MAXNETNODES; ++i)
     {
-        if (ClientConnected(&clients[i]) && clients[i].ready)
+        if (ClientConnected(&sv->clients[i]) && sv->clients[i].ready)
         {
-            NET_SV_SendWaitingData(&clients[i]);
+            NET_SV_SendWaitingData(&sv->clients[i]);
         }
     }
 }
@@ -960,10 +1195,10 @@ static void NET_SV_ParseGameStart(net_packet_t *packet, net_client_t *client)
 
     // Can only start a game if we are in the waiting start state.
 
-    if (server_state != SERVER_WAITING_START)
+    if (sv->server_state != SERVER_WAITING_START)
     {
         NET_Log("server: error: not in waiting start state, server_state=%d",
-                server_state);
+                sv->server_state);
         return;
     }
 
@@ -978,13 +1213,13 @@ static void NET_SV_ParseGameStart(net_packet_t *packet, net_client_t *client)
 
         // Check the game settings are valid
 
-        if (!NET_ValidGameSettings(sv_gamemode, sv_gamemission, &settings))
+        if (!NET_ValidGameSettings(sv->sv_gamemode, sv->sv_gamemission, &settings))
         {
             NET_Log("server: error: invalid game settings");
             return;
         }
 
-        sv_settings = settings;
+        sv->sv_settings = settings;
     }
 
     client->ready = true;
@@ -1026,7 +1261,7 @@ static void NET_SV_SendResendRequest(net_client_t *client, int start, int end)
 
     for (i=start; i<=end; ++i)
     {
-        index = i - recvwindow_start;
+        index = i - sv->recvwindow_start;
 
         if (index >= BACKUPTICS)
         {
@@ -1035,7 +1270,7 @@ static void NET_SV_SendResendRequest(net_client_t *client, int start, int end)
             continue;
         }
         
-        recvobj = &recvwindow[index][client->player_number];
+        recvobj = &sv->recvwindow[index][client->player_number];
 
         recvobj->resend_time = nowtime;
     }
@@ -1061,7 +1296,7 @@ static void NET_SV_CheckResends(net_client_t *client)
         net_client_recv_t *recvobj;
         boolean need_resend;
 
-        recvobj = &recvwindow[i][player];
+        recvobj = &sv->recvwindow[i][player];
 
         // if need_resend is true, this tic needs another retransmit
         // request (300ms timeout)
@@ -1084,12 +1319,12 @@ static void NET_SV_CheckResends(net_client_t *client)
             // End of a run of resend tics
             NET_Log("server: resend request to %s timed out for %d-%d (%d)",
                     NET_AddrToString(client->addr),
-                    recvwindow_start + resend_start,
-                    recvwindow_start + resend_end,
-                    &recvwindow[resend_start][player].resend_time);
+                    sv->recvwindow_start + resend_start,
+                    sv->recvwindow_start + resend_end,
+                    &sv->recvwindow[resend_start][player].resend_time);
             NET_SV_SendResendRequest(client, 
-                                     recvwindow_start + resend_start,
-                                     recvwindow_start + resend_end);
+                                     sv->recvwindow_start + resend_start,
+                                     sv->recvwindow_start + resend_end);
 
             resend_start = -1;
         }
@@ -1099,12 +1334,12 @@ static void NET_SV_CheckResends(net_client_t *client)
     {
         NET_Log("server: resend request to %s timed out for %d-%d (%d)",
                 NET_AddrToString(client->addr),
-                recvwindow_start + resend_start,
-                recvwindow_start + resend_end,
-                &recvwindow[resend_start][player].resend_time);
+                sv->recvwindow_start + resend_start,
+                sv->recvwindow_start + resend_end,
+                &sv->recvwindow[resend_start][player].resend_time);
         NET_SV_SendResendRequest(client,
-                                 recvwindow_start + resend_start,
-                                 recvwindow_start + resend_end);
+                                 sv->recvwindow_start + resend_start,
+                                 sv->recvwindow_start + resend_end);
     }
 }
 
@@ -1122,10 +1357,10 @@ static void NET_SV_ParseGameData(net_packet_t *packet, net_client_t *client)
     int resend_start, resend_end;
     int index;
 
-    if (server_state != SERVER_IN_GAME)
+    if (sv->server_state != SERVER_IN_GAME)
     {
         NET_Log("server: error: not in game state: server_state=%d",
-                server_state);
+                sv->server_state);
         return;
     }
 
@@ -1165,12 +1400,12 @@ static void NET_SV_ParseGameData(net_packet_t *packet, net_client_t *client)
         signed int latency;
 
         if (!NET_ReadSInt16(packet, &latency)
-         || !NET_ReadTiccmdDiff(packet, &diff, sv_settings.lowres_turn))
+         || !NET_ReadTiccmdDiff(packet, &diff, sv->sv_settings.lowres_turn))
         {
             return;
         }
 
-        index = seq + i - recvwindow_start;
+        index = seq + i - sv->recvwindow_start;
 
         if (index < 0 || index >= BACKUPTICS)
         {
@@ -1179,7 +1414,7 @@ static void NET_SV_ParseGameData(net_packet_t *packet, net_client_t *client)
             continue;
         }
 
-        recvobj = &recvwindow[index][player];
+        recvobj = &sv->recvwindow[index][player];
         recvobj->active = true;
         recvobj->diff = diff;
         recvobj->latency = latency;
@@ -1202,7 +1437,7 @@ static void NET_SV_ParseGameData(net_packet_t *packet, net_client_t *client)
 
     //printf("SV: %p: %i\n", client, seq);
 
-    resend_end = seq - recvwindow_start;
+    resend_end = seq - sv->recvwindow_start;
 
     if (resend_end <= 0)
         return;
@@ -1215,7 +1450,7 @@ static void NET_SV_ParseGameData(net_packet_t *packet, net_client_t *client)
     
     while (index >= 0)
     {
-        recvobj = &recvwindow[index][player];
+        recvobj = &sv->recvwindow[index][player];
 
         if (recvobj->active)
         {
@@ -1239,11 +1474,11 @@ static void NET_SV_ParseGameData(net_packet_t *packet, net_client_t *client)
     if (resend_start < resend_end)
     {
         NET_Log("server: request resend for %d-%d before %d",
-                recvwindow_start + resend_start,
-                recvwindow_start + resend_end - 1, seq);
+                sv->recvwindow_start + resend_start,
+                sv->recvwindow_start + resend_end - 1, seq);
         NET_SV_SendResendRequest(client, 
-                                 recvwindow_start + resend_start, 
-                                 recvwindow_start + resend_end - 1);
+                                 sv->recvwindow_start + resend_start, 
+                                 sv->recvwindow_start + resend_end - 1);
     }
 }
 
@@ -1253,10 +1488,10 @@ static void NET_SV_ParseGameDataACK(net_packet_t *packet, net_client_t *client)
 
     NET_Log("server: processing game data ack packet");
 
-    if (server_state != SERVER_IN_GAME)
+    if (sv->server_state != SERVER_IN_GAME)
     {
         NET_Log("server: error: not in game state, server_state=%d",
-                server_state);
+                sv->server_state);
         return;
     }
 
@@ -1311,7 +1546,7 @@ static void NET_SV_SendTics(net_client_t *client,
 
         // Add command
        
-        NET_WriteFullTiccmd(packet, cmd, sv_settings.lowres_turn);
+        NET_WriteFullTiccmd(packet, cmd, sv->sv_settings.lowres_turn);
     }
     
     // Send packet
@@ -1383,7 +1618,7 @@ void NET_SV_SendQueryResponse(net_addr_t *addr)
 
     // Server state
 
-    querydata.server_state = server_state;
+    querydata.server_state = sv->server_state;
 
     // Number of players/maximum players
 
@@ -1392,8 +1627,8 @@ void NET_SV_SendQueryResponse(net_addr_t *addr)
 
     // Game mode/mission
 
-    querydata.gamemode = sv_gamemode;
-    querydata.gamemission = sv_gamemission;
+    querydata.gamemode = sv->sv_gamemode;
+    querydata.gamemission = sv->sv_gamemission;
 
     //!
     // @category net
@@ -1482,6 +1717,7 @@ static void NET_SV_MasterPacket(net_packet_t *packet)
 static void NET_SV_Packet(net_packet_t *packet, net_addr_t *addr)
 {
     net_client_t *client;
+    net_game_t *game;
     unsigned int packet_type;
 
     // Response from master server?
@@ -1515,7 +1751,17 @@ static void NET_SV_Packet(net_packet_t *packet, net_addr_t *addr)
     }
     else if (packet_type == NET_PACKET_TYPE_QUERY)
     {
-        NET_SV_SendQueryResponse(addr);
+        if (client == NULL)
+        {
+            game = sv;
+            NET_SV_GameForQuery();
+            NET_SV_SendQueryResponse(addr);
+            sv = game;
+        }
+        else
+        {
+            NET_SV_SendQueryResponse(addr);
+        }
     }
     else if (client == NULL)
     {
@@ -1573,7 +1819,7 @@ static void NET_SV_PumpSendQueue(net_client_t *client)
     
     // Work out the index into the receive window
    
-    recv_index = client->sendseq - recvwindow_start;
+    recv_index = client->sendseq - sv->recvwindow_start;
 
     if (recv_index < 0 || recv_index >= BACKUPTICS)
     {
@@ -1587,19 +1833,19 @@ static void NET_SV_PumpSendQueue(net_client_t *client)
 
     for (i=0; i<NET_MAXPLAYERS; ++i)
     {
-        if (sv_players[i] == client)
+        if (sv->sv_players[i] == client)
         {
             // Client does not rely on itself for data
 
             continue;
         }
 
-        if (sv_players[i] == NULL || !ClientConnected(sv_players[i]))
+        if (sv->sv_players[i] == NULL || !ClientConnected(sv->sv_players[i]))
         {
             continue;
         }
 
-        if (!recvwindow[recv_index][i].active)
+        if (!sv->recvwindow[recv_index][i].active)
         {
             // We do not have this player's ticcmd, so we cannot
             // generate a complete command yet.
@@ -1616,7 +1862,7 @@ static void NET_SV_PumpSendQueue(net_client_t *client)
     // and never stopping. Don't let the server get too far ahead
     // of the client.
 
-    if (num_players == 0 && client->sendseq > recvwindow_start + 10)
+    if (num_players == 0 && client->sendseq > sv->recvwindow_start + 10)
     {
         return;
     }
@@ -1633,7 +1879,7 @@ static void NET_SV_PumpSendQueue(net_client_t *client)
     {
         net_client_recv_t *recvobj;
 
-        if (sv_players[i] == client)
+        if (sv->sv_players[i] == client)
         {
             // Not the player we are sending to
 
@@ -1641,7 +1887,7 @@ static void NET_SV_PumpSendQueue(net_client_t *client)
             continue;
         }
         
-        if (sv_players[i] == NULL || !recvwindow[recv_index][i].active)
+        if (sv->sv_players[i] == NULL || !sv->recvwindow[recv_index][i].active)
         {
             cmd.playeringame[i] = false;
             continue;
@@ -1649,7 +1895,7 @@ static void NET_SV_PumpSendQueue(net_client_t *client)
 
         cmd.playeringame[i] = true;
 
-        recvobj = &recvwindow[recv_index][i];
+        recvobj = &sv->recvwindow[recv_index][i];
 
         cmd.cmds[i] = recvobj->diff;
 
@@ -1665,7 +1911,7 @@ static void NET_SV_PumpSendQueue(net_client_t *client)
 
     // Transmit the new tic to the client
 
-    starttic = client->sendseq - sv_settings.extratics;
+    starttic = client->sendseq - sv->sv_settings.extratics;
     endtic = client->sendseq;
 
     if (starttic < 0)
@@ -1712,16 +1958,16 @@ void NET_SV_CheckDeadlock(net_client_t *client)
 
         for (i=0; i<BACKUPTICS; ++i)
         {
-            if (!recvwindow[i][client->player_number].active)
+            if (!sv->recvwindow[i][client->player_number].active)
             {
                 NET_Log("server: deadlock: sending resend request for %d-%d",
-                        recvwindow_start + i, recvwindow_start + i + 5);
+                        sv->recvwindow_start + i, sv->recvwindow_start + i + 5);
 
                 // Found a tic we haven't received.  Send a resend request.
 
                 NET_SV_SendResendRequest(client,
-                                         recvwindow_start + i,
-                                         recvwindow_start + i + 5);
+                                         sv->recvwindow_start + i,
+                                         sv->recvwindow_start + i + 5);
 
                 client->last_gamedata_time = nowtime;
                 break;
@@ -1749,14 +1995,14 @@ static void NET_SV_GameEnded(void)
 {
     int i;
 
-    server_state = SERVER_WAITING_LAUNCH;
-    sv_gamemode = indetermined;
+    sv->server_state = SERVER_WAITING_LAUNCH;
+    sv->sv_gamemode = indetermined;
 
     for (i=0; i<MAXNETNODES; ++i)
     {
-        if (clients[i].active)
+        if (sv->clients[i].active)
         {
-            NET_SV_DisconnectClient(&clients[i]);
+            NET_SV_DisconnectClient(&sv->clients[i]);
         }
     }
 }
@@ -1782,12 +2028,12 @@ static void NET_SV_RunClient(net_client_t *client)
 
     if (client->connection.state == NET_CONN_STATE_DISCONNECTED)
     {
-        client->active = false;
+        NET_SV_DeactivateClient(client);
 
         // If we were about to start a game, any player disconnecting
         // should cause an abort.
 
-        if (server_state == SERVER_WAITING_START && !client->drone)
+        if (sv->server_state == SERVER_WAITING_START && !client->drone)
         {
             NET_SV_BroadcastMessage("Game startup aborted because "
                                     "player '%s' disconnected.",
@@ -1817,7 +2063,7 @@ static void NET_SV_RunClient(net_client_t *client)
         return;
     }
 
-    if (server_state == SERVER_WAITING_LAUNCH)
+    if (sv->server_state == SERVER_WAITING_LAUNCH)
     {
         // Waiting for the game to start
 
@@ -1831,7 +2077,7 @@ static void NET_SV_RunClient(net_client_t *client)
         }
     }
 
-    if (server_state == SERVER_IN_GAME)
+    if (sv->server_state == SERVER_IN_GAME)
     {
         NET_SV_PumpSendQueue(client);
         NET_SV_CheckDeadlock(client);
@@ -1850,26 +2096,93 @@ void NET_SV_AddModule(net_module_t *module)
 
 void NET_SV_Init(void)
 {
-    int i;
+    int p;
 
     // initialize send/receive context
 
     server_context = NET_NewContext();
 
-    // no clients yet
-   
-    for (i=0; i<MAXNETNODES; ++i) 
+    //!
+    // @category net
+    // @arg <n>
+    //
+    // When running a server, host up to n games at once.  A client
+    // that connects when every game has been launched or is full is
+    // placed in a new game with its own lobby.  The default is 1.
+    //
+
+    p = M_CheckParmWithArgs("-maxgames", 1);
+
+    if (p > 0)
     {
-        clients[i].active = false;
+        max_games = atoi(myargv[p + 1]);
+
+        if (max_games < 1)
+        {
+            I_Error("NET_SV_Init: Invalid value for -maxgames: %s",
+                    myargv[p + 1]);
+        }
     }
 
-    NET_SV_AssignPlayers();
+    //!
+    // @category net
+    // @arg <file>
+    //
+    // When running a server, record every packet received to the
+    // given file, to be replayed by the netreplay benchmark.
+    //
+
+    p = M_CheckParmWithArgs("-nettrace", 1);
+
+    if (p > 0)
+    {
+        trace_file = M_fopen(myargv[p + 1], "wb");
+
+        if (trace_file == NULL)
+        {
+            I_Error("NET_SV_Init: Failed to open %s", myargv[p + 1]);
+        }
+
+        fwrite(NET_TRACE_MAGIC, 1, strlen(NET_TRACE_MAGIC), trace_file);
+    }
+
+    games = Z_Malloc(sizeof(*games) * max_games, PU_STATIC, 0);
+    num_games = 0;
+
+    // no clients yet
+
+    NET_SV_NewGame();
 
-    server_state = SERVER_WAITING_LAUNCH;
-    sv_gamemode = indetermined;
     server_initialized = true;
 }
 
+static void WriteTraceInt(unsigned int value, int bytes)
+{
+    int i;
+
+    for (i=0; i<bytes; ++i)
+    {
+        fputc((value >> (i * 8)) & 0xff, trace_file);
+    }
+}
+
+// Add a received packet to the trace.
+
+static void NET_SV_TracePacket(net_addr_t *addr, net_packet_t *packet)
+{
+    const char *name;
+    size_t len;
+
+    name = NET_AddrToString(addr);
+    len = strlen(name);
+
+    WriteTraceInt(trace_run, 4);
+    WriteTraceInt(len, 2);
+    fwrite(name, 1, len, trace_file);
+    WriteTraceInt(packet->len, 2);
+    fwrite(packet->data, 1, packet->len, trace_file);
+}
+
 static void UpdateMasterServer(void)
 {
     unsigned int now;
@@ -1927,68 +2240,214 @@ void NET_SV_RegisterWithMaster(void)
     }
 }
 
-// Run server code to check for new packets/send packets as the server
-// requires
+// Run the current game
+
+static void NET_SV_RunGame(void)
+{
+    int i;
+
+    // "Run" any clients that may have things to do, independent of responses
+    // to received packets
+
+    for (i=0; i<MAXNETNODES; ++i)
+    {
+        if (sv->clients[i].active)
+        {
+            NET_SV_RunClient(&sv->clients[i]);
+        }
+    }
+
+    switch (sv->server_state)
+    {
+        case SERVER_WAITING_LAUNCH:
+            break;
+
+        case SERVER_WAITING_START:
+            CheckStartGame();
+            break;
+
+        case SERVER_IN_GAME:
+            NET_SV_AdvanceWindow();
+
+            for (i = 0; i < NET_MAXPLAYERS; ++i)
+            {
+                if (sv->sv_players[i] != NULL && ClientConnected(sv->sv_players[i]))
+                {
+                    NET_SV_CheckResends(sv->sv_players[i]);
+                }
+            }
+            break;
+    }
+}
 
 void NET_SV_Run(void)
 {
     net_addr_t *addr;
     net_packet_t *packet;
-    int i;
+    int g;
 
     if (!server_initialized)
     {
         return;
     }
 
+    ++trace_run;
+
     while (NET_RecvPacket(server_context, &addr, &packet))
     {
+        if (trace_file != NULL)
+        {
+            NET_SV_TracePacket(addr, packet);
+        }
+
         NET_SV_Packet(packet, addr);
         NET_FreePacket(packet);
         NET_ReleaseAddress(addr);
     }
 
+    // The server is usually stopped by killing it, so do not leave
+    // the end of the trace in the buffer.
+
+    if (trace_file != NULL)
+    {
+        fflush(trace_file);
+    }
+
     if (master_server != NULL)
     {
         UpdateMasterServer();
     }
 
-    // "Run" any clients that may have things to do, independent of responses
-    // to received packets
+    for (g=0; g<num_games; ++g)
+    {
+        sv = games[g];
+        NET_SV_RunGame();
+    }
+}
+
+static void SetTimeout(int *timeout, int t)
+{
+    if (t >= 0 && (*timeout < 0 || t < *timeout))
+    {
+        *timeout = t;
+    }
+}
+
+// Work out when the timers of the current game next expire.
+
+static void NET_SV_GameTimeout(int nowtime, int *timeout)
+{
+    net_client_t *client;
+    net_client_recv_t *recvobj;
+    int t;
+    int i, j;
 
     for (i=0; i<MAXNETNODES; ++i)
     {
-        if (clients[i].active)
+        client = &sv->clients[i];
+
+        if (!client->active)
         {
-            NET_SV_RunClient(&clients[i]);
+            continue;
         }
-    }
 
-    switch (server_state)
-    {
-        case SERVER_WAITING_LAUNCH:
-            break;
+        SetTimeout(timeout, NET_Conn_TimeUntilRun(&client->connection));
 
-        case SERVER_WAITING_START:
-            CheckStartGame();
-            break;
+        if (!ClientConnected(client))
+        {
+            continue;
+        }
 
-        case SERVER_IN_GAME:
-            NET_SV_AdvanceWindow();
+        if (sv->server_state == SERVER_WAITING_LAUNCH)
+        {
+            if (client->last_send_time < 0)
+            {
+                SetTimeout(timeout, 0);
+            }
+            else
+            {
+                SetTimeout(timeout, NET_TimeUntilExpired(
+                    nowtime, client->last_send_time, 1000));
+            }
+        }
 
-            for (i = 0; i < NET_MAXPLAYERS; ++i)
+        if (sv->server_state == SERVER_IN_GAME && !client->drone)
+        {
+            // If the deadlock check has already expired, it found no
+            // missing tic to ask for; it cannot do anything until more
+            // data arrives, so do not spin on it.
+
+            t = NET_TimeUntilExpired(nowtime, client->last_gamedata_time,
+                                     1000);
+
+            if (t > 0)
+            {
+                SetTimeout(timeout, t);
+            }
+        }
+    }
+
+    if (sv->server_state == SERVER_IN_GAME)
+    {
+        for (i = 0; i < NET_MAXPLAYERS; ++i)
+        {
+            if (sv->sv_players[i] == NULL
+             || !ClientConnected(sv->sv_players[i]))
+            {
+                continue;
+            }
+
+            for (j=0; j<BACKUPTICS; ++j)
             {
-                if (sv_players[i] != NULL && ClientConnected(sv_players[i]))
+                recvobj = &sv->recvwindow[j][i];
+
+                if (!recvobj->active && recvobj->resend_time != 0)
                 {
-                    NET_SV_CheckResends(sv_players[i]);
+                    SetTimeout(timeout, NET_TimeUntilExpired(
+                        nowtime, recvobj->resend_time, 300));
                 }
             }
-            break;
+        }
     }
 }
 
+// Work out when the timers checked by NET_SV_Run and NET_SV_RunClient
+// next expire.  This is called straight after NET_SV_Run.
+
+int NET_SV_TimeUntilRun(void)
+{
+    int nowtime;
+    int timeout;
+    int g;
+
+    if (!server_initialized)
+    {
+        return -1;
+    }
+
+    nowtime = I_GetTimeMS();
+    timeout = -1;
+
+    if (master_server != NULL)
+    {
+        SetTimeout(&timeout, NET_TimeUntilExpired(nowtime, master_resolve_time,
+                                                  MASTER_RESOLVE_PERIOD * 1000));
+        SetTimeout(&timeout, NET_TimeUntilExpired(nowtime, master_refresh_time,
+                                                  MASTER_REFRESH_PERIOD * 1000));
+    }
+
+    for (g=0; g<num_games; ++g)
+    {
+        sv = games[g];
+        NET_SV_GameTimeout(nowtime, &timeout);
+    }
+
+    return timeout;
+}
+
 void NET_SV_Shutdown(void)
 {
+    int g;
     int i;
     boolean running;
     int start_time;
@@ -2002,11 +2461,16 @@ void NET_SV_Shutdown(void)
 
     // Disconnect all clients
     
-    for (i=0; i<MAXNETNODES; ++i)
+    for (g=0; g<num_games; ++g)
     {
-        if (clients[i].active)
+        sv = games[g];
+
+        for (i=0; i<MAXNETNODES; ++i)
         {
-            NET_SV_DisconnectClient(&clients[i]);
+            if (sv->clients[i].active)
+            {
+                NET_SV_DisconnectClient(&sv->clients[i]);
+            }
         }
     }
 
@@ -2021,11 +2485,14 @@ void NET_SV_Shutdown(void)
 
         running = false;
 
-        for (i=0; i<MAXNETNODES; ++i)
+        for (g=0; g<num_games; ++g)
         {
-            if (clients[i].active)
+            for (i=0; i<MAXNETNODES; ++i)
             {
-                running = true;
+                if (games[g]->clients[i].active)
+                {
+                    running = true;
+                }
             }
         }
 
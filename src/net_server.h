@@ -17,6 +17,15 @@
 #ifndef NET_SERVER_H
 #define NET_SERVER_H
 
+// Packet traces written by the server with -nettrace, and replayed by
+// netreplay.  The magic is followed by one record for each packet
+// received: the number of the NET_SV_Run call that received it (32
+// bits), the sender's address as a string (16-bit length, then the
+// text) and the packet (16-bit length, then the data).  Numbers are
+// little-endian.
+
+#define NET_TRACE_MAGIC "NETTRACE"
+
 // initialize server and wait for connections
 
 void NET_SV_Init(void);
@@ -25,6 +34,11 @@ void NET_SV_Init(void);
 
 void NET_SV_Run(void);
 
+// Time in milliseconds until NET_SV_Run next has something to do other
+// than process received packets, or -1 if it is only waiting for packets
+
+int NET_SV_TimeUntilRun(void);
+
 // Shut down the server
 // Blocks until all clients disconnect, or until a 5 second timeout
 
@@ -0,0 +1,629 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//     Networking module which uses native UDP sockets.  Like the
+//     SDL_net module, but received datagrams are read from the
+//     socket in batches with recvmmsg() where it is available, so
+//     that a busy server makes one system call for many packets.
+//
+
+#include "config.h"
+
+#ifdef HAVE_RECVMMSG
+#define _GNU_SOURCE
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "doomtype.h"
+#include "i_system.h"
+#include "i_timer.h"
+#include "m_argv.h"
+#include "m_misc.h"
+#include "net_defs.h"
+#include "net_io.h"
+#include "net_packet.h"
+#include "net_udp.h"
+#include "z_zone.h"
+
+boolean NET_UDP_Requested(void)
+{
+#ifndef _WIN32
+    //!
+    // @category net
+    //
+    // When running a server, receive packets through native UDP
+    // sockets rather than SDL_net, reading them in batches where
+    // the system supports it.  Not available on Windows.
+    //
+
+    return M_ParmExists("-nativeudp");
+#else
+    return false;
+#endif
+}
+
+//
+// NETWORKING
+//
+
+
+#ifndef _WIN32
+
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+
+#define DEFAULT_PORT 2342
+
+// Number of datagrams read from the socket in one go.
+
+#define RECV_BATCH 32
+#define RECV_BUFFER_SIZE 1500
+
+static boolean initted = false;
+static int port = DEFAULT_PORT;
+static int udpsocket = -1;
+
+// Datagrams read from the socket that have not been handed out yet.
+
+static byte recv_buffers[RECV_BATCH][RECV_BUFFER_SIZE];
+static struct sockaddr_in recv_addrs[RECV_BATCH];
+static int recv_lens[RECV_BATCH];
+static int recv_count = 0;
+static int recv_next = 0;
+
+#ifdef HAVE_RECVMMSG
+static struct mmsghdr recv_msgs[RECV_BATCH];
+static struct iovec recv_iovecs[RECV_BATCH];
+#endif
+
+typedef struct addrpair_s
+{
+    net_addr_t net_addr;
+    struct sockaddr_in udp_addr;
+    struct addrpair_s *next;
+} addrpair_t;
+
+// Addresses are kept in a hash table keyed on host and port, so that
+// the address of a received packet can be found without a search.
+
+static addrpair_t **addr_table;
+static int addr_table_size = -1;
+static int addr_table_count = 0;
+
+// Initializes the address table
+
+static void NET_UDP_InitAddrTable(void)
+{
+    addr_table_size = 64;
+
+    addr_table = Z_Malloc(sizeof(addrpair_t *) * addr_table_size,
+                          PU_STATIC, 0);
+    memset(addr_table, 0, sizeof(addrpair_t *) * addr_table_size);
+}
+
+static boolean AddressesEqual(struct sockaddr_in *a, struct sockaddr_in *b)
+{
+    return a->sin_addr.s_addr == b->sin_addr.s_addr
+        && a->sin_port == b->sin_port;
+}
+
+// Bucket for an address; addr_table_size is a power of two.
+
+static int AddressHash(struct sockaddr_in *addr)
+{
+    uint32_t hash;
+
+    hash = (addr->sin_addr.s_addr ^ ((uint32_t) addr->sin_port << 16))
+         * 2654435761U;
+
+    return (hash >> 16) & (addr_table_size - 1);
+}
+
+// Double the size of the table once it is as full as it is large.
+
+static void NET_UDP_GrowAddrTable(void)
+{
+    addrpair_t **old_table;
+    addrpair_t *entry, *next;
+    int old_size;
+    int hash;
+    int i;
+
+    old_table = addr_table;
+    old_size = addr_table_size;
+
+    addr_table_size *= 2;
+    addr_table = Z_Malloc(sizeof(addrpair_t *) * addr_table_size,
+                          PU_STATIC, 0);
+    memset(addr_table, 0, sizeof(addrpair_t *) * addr_table_size);
+
+    for (i=0; i<old_size; ++i)
+    {
+        for (entry = old_table[i]; entry != NULL; entry = next)
+        {
+            next = entry->next;
+            hash = AddressHash(&entry->udp_addr);
+            entry->next = addr_table[hash];
+            addr_table[hash] = entry;
+        }
+    }
+
+    Z_Free(old_table);
+}
+
+// Finds an address by searching the table.  If the address is not found,
+// it is added to the table.
+
+static net_addr_t *NET_UDP_FindAddress(struct sockaddr_in *addr)
+{
+    addrpair_t *new_entry;
+    addrpair_t *entry;
+    int hash;
+
+    if (addr_table_size < 0)
+    {
+        NET_UDP_InitAddrTable();
+    }
+
+    hash = AddressHash(addr);
+
+    for (entry = addr_table[hash]; entry != NULL; entry = entry->next)
+    {
+        if (AddressesEqual(addr, &entry->udp_addr))
+        {
+            return &entry->net_addr;
+        }
+    }
+
+    // Was not found in list.  We need to add it.
+
+    if (addr_table_count >= addr_table_size)
+    {
+        NET_UDP_GrowAddrTable();
+        hash = AddressHash(addr);
+    }
+
+    // Add a new entry
+
+    new_entry = Z_Malloc(sizeof(addrpair_t), PU_STATIC, 0);
+
+    memset(&new_entry->udp_addr, 0, sizeof(new_entry->udp_addr));
+    new_entry->udp_addr.sin_family = AF_INET;
+    new_entry->udp_addr.sin_addr = addr->sin_addr;
+    new_entry->udp_addr.sin_port = addr->sin_port;
+    new_entry->net_addr.refcount = 0;
+    new_entry->net_addr.handle = &new_entry->udp_addr;
+    new_entry->net_addr.module = &net_udp_module;
+
+    new_entry->next = addr_table[hash];
+    addr_table[hash] = new_entry;
+    ++addr_table_count;
+
+    return &new_entry->net_addr;
+}
+
+static void NET_UDP_FreeAddress(net_addr_t *addr)
+{
+    addrpair_t **prev;
+    addrpair_t *entry;
+
+    if (addr_table_size > 0)
+    {
+        prev = &addr_table[AddressHash(addr->handle)];
+
+        for (entry = *prev; entry != NULL; prev = &entry->next, entry = *prev)
+        {
+            if (addr == &entry->net_addr)
+            {
+                *prev = entry->next;
+                --addr_table_count;
+                Z_Free(entry);
+                return;
+            }
+        }
+    }
+
+    I_Error("NET_UDP_FreeAddress: Attempted to remove an unused address!");
+}
+
+// Open a non-blocking socket bound to the given port (0 for any).
+
+static boolean OpenSocket(int bind_port)
+{
+    struct sockaddr_in addr;
+    int broadcast = 1;
+    int flags;
+
+    udpsocket = socket(AF_INET, SOCK_DGRAM, 0);
+
+    if (udpsocket < 0)
+    {
+        return false;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(bind_port);
+
+    flags = fcntl(udpsocket, F_GETFL, 0);
+
+    if (bind(udpsocket, (struct sockaddr *) &addr, sizeof(addr)) < 0
+     || flags < 0 || fcntl(udpsocket, F_SETFL, flags | O_NONBLOCK) < 0)
+    {
+        close(udpsocket);
+        udpsocket = -1;
+        return false;
+    }
+
+    // Needed for LAN queries.
+
+    setsockopt(udpsocket, SOL_SOCKET, SO_BROADCAST,
+               &broadcast, sizeof(broadcast));
+
+    return true;
+}
+
+static boolean NET_UDP_InitClient(void)
+{
+    int p;
+
+    if (initted)
+        return true;
+
+    p = M_CheckParmWithArgs("-port", 1);
+    if (p > 0)
+        port = atoi(myargv[p+1]);
+
+    if (!OpenSocket(0))
+    {
+        I_Error("NET_UDP_InitClient: Unable to open a socket!");
+    }
+
+    initted = true;
+
+    return true;
+}
+
+static boolean NET_UDP_InitServer(void)
+{
+    int p;
+
+    if (initted)
+        return true;
+
+    p = M_CheckParmWithArgs("-port", 1);
+    if (p > 0)
+        port = atoi(myargv[p+1]);
+
+    if (!OpenSocket(port))
+    {
+        I_Error("NET_UDP_InitServer: Unable to bind to port %i", port);
+    }
+
+    initted = true;
+
+    return true;
+}
+
+static void NET_UDP_SendPacket(net_addr_t *addr, net_packet_t *packet)
+{
+    struct sockaddr_in ip;
+
+    if (addr == &net_broadcast_addr)
+    {
+        memset(&ip, 0, sizeof(ip));
+        ip.sin_family = AF_INET;
+        ip.sin_addr.s_addr = htonl(INADDR_BROADCAST);
+        ip.sin_port = htons(port);
+    }
+    else
+    {
+        ip = *((struct sockaddr_in *) addr->handle);
+    }
+
+    if (sendto(udpsocket, packet->data, packet->len, 0,
+               (struct sockaddr *) &ip, sizeof(ip)) < 0)
+    {
+        // A full send buffer loses the packet, as any network might.
+
+        if (errno != EAGAIN && errno != EWOULDBLOCK
+         && errno != ENOBUFS && errno != EINTR)
+        {
+            I_Error("NET_UDP_SendPacket: Error transmitting packet: %s",
+                    strerror(errno));
+        }
+    }
+}
+
+// Read as many waiting datagrams as fit in the receive buffers.
+// Returns the number read.
+
+static int ReadBatch(void)
+{
+#ifdef HAVE_RECVMMSG
+    int result;
+    int i;
+
+    for (i=0; i<RECV_BATCH; ++i)
+    {
+        recv_iovecs[i].iov_base = recv_buffers[i];
+        recv_iovecs[i].iov_len = RECV_BUFFER_SIZE;
+        memset(&recv_msgs[i].msg_hdr, 0, sizeof(recv_msgs[i].msg_hdr));
+        recv_msgs[i].msg_hdr.msg_name = &recv_addrs[i];
+        recv_msgs[i].msg_hdr.msg_namelen = sizeof(recv_addrs[i]);
+        recv_msgs[i].msg_hdr.msg_iov = &recv_iovecs[i];
+        recv_msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    result = recvmmsg(udpsocket, recv_msgs, RECV_BATCH, MSG_DONTWAIT, NULL);
+
+    for (i=0; i<result; ++i)
+    {
+        recv_lens[i] = recv_msgs[i].msg_len;
+    }
+#else
+    socklen_t addrlen;
+    int result;
+
+    addrlen = sizeof(recv_addrs[0]);
+    result = recvfrom(udpsocket, recv_buffers[0], RECV_BUFFER_SIZE, 0,
+                      (struct sockaddr *) &recv_addrs[0], &addrlen);
+
+    if (result >= 0)
+    {
+        recv_lens[0] = result;
+        result = 1;
+    }
+#endif
+
+    if (result < 0)
+    {
+        // Nothing waiting.  An ICMP error for an earlier send can also
+        // show up here; it is not an error on this socket.
+
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR
+         || errno == ECONNREFUSED)
+        {
+            return 0;
+        }
+
+        I_Error("NET_UDP_RecvPacket: Error receiving packet: %s",
+                strerror(errno));
+    }
+
+    return result;
+}
+
+static boolean NET_UDP_RecvPacket(net_addr_t **addr, net_packet_t **packet)
+{
+    int i;
+
+    if (recv_next >= recv_count)
+    {
+        recv_count = ReadBatch();
+        recv_next = 0;
+
+        // no packets received
+
+        if (recv_count == 0)
+            return false;
+    }
+
+    i = recv_next++;
+
+    // Put the data into a new packet structure
+
+    *packet = NET_NewPacket(recv_lens[i]);
+    memcpy((*packet)->data, recv_buffers[i], recv_lens[i]);
+    (*packet)->len = recv_lens[i];
+
+    // Address
+
+    *addr = NET_UDP_FindAddress(&recv_addrs[i]);
+
+    return true;
+}
+
+static void NET_UDP_AddrToString(net_addr_t *addr, char *buffer, int buffer_len)
+{
+    struct sockaddr_in *ip;
+    uint32_t host;
+    uint16_t port;
+
+    ip = (struct sockaddr_in *) addr->handle;
+    host = ntohl(ip->sin_addr.s_addr);
+    port = ntohs(ip->sin_port);
+
+    M_snprintf(buffer, buffer_len, "%i.%i.%i.%i",
+               (host >> 24) & 0xff, (host >> 16) & 0xff,
+               (host >> 8) & 0xff, host & 0xff);
+
+    // As for the SDL_net module, only show the port if it is not the
+    // default one.
+    if (port != DEFAULT_PORT)
+    {
+        char portbuf[10];
+        M_snprintf(portbuf, sizeof(portbuf), ":%i", port);
+        M_StringConcat(buffer, portbuf, buffer_len);
+    }
+}
+
+static net_addr_t *NET_UDP_ResolveAddress(const char *address)
+{
+    struct addrinfo hints;
+    struct addrinfo *result;
+    struct sockaddr_in ip;
+    char *addr_hostname;
+    int addr_port;
+    int error;
+    char *colon;
+
+    colon = strchr(address, ':');
+
+    addr_hostname = M_StringDuplicate(address);
+    if (colon != NULL)
+    {
+        addr_hostname[colon - address] = '\0';
+        addr_port = atoi(colon + 1);
+    }
+    else
+    {
+        addr_port = port;
+    }
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+
+    error = getaddrinfo(addr_hostname, NULL, &hints, &result);
+
+    free(addr_hostname);
+
+    if (error != 0 || result == NULL)
+    {
+        // unable to resolve
+
+        return NULL;
+    }
+
+    ip = *((struct sockaddr_in *) result->ai_addr);
+    ip.sin_port = htons(addr_port);
+    freeaddrinfo(result);
+
+    return NET_UDP_FindAddress(&ip);
+}
+
+void NET_UDP_WaitForPacket(int timeout)
+{
+    struct pollfd pfd;
+
+    if (!initted)
+    {
+        return;
+    }
+
+    // Packets from the last batch may still be waiting to be handed
+    // out.
+
+    if (recv_next < recv_count)
+    {
+        return;
+    }
+
+    pfd.fd = udpsocket;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    if (poll(&pfd, 1, timeout) < 0)
+    {
+        // The wait failed (eg. interrupted by a signal); do not spin.
+
+        I_Sleep(1);
+    }
+}
+
+// Complete module
+
+net_module_t net_udp_module =
+{
+    NET_UDP_InitClient,
+    NET_UDP_InitServer,
+    NET_UDP_SendPacket,
+    NET_UDP_RecvPacket,
+    NET_UDP_AddrToString,
+    NET_UDP_FreeAddress,
+    NET_UDP_ResolveAddress,
+};
+
+
+#else // _WIN32
+
+// no-op implementation; NET_UDP_Requested() is always false
+
+
+static boolean NET_NULL_InitClient(void)
+{
+    return false;
+}
+
+
+static boolean NET_NULL_InitServer(void)
+{
+    return false;
+}
+
+
+static void NET_NULL_SendPacket(net_addr_t *addr, net_packet_t *packet)
+{
+}
+
+
+static boolean NET_NULL_RecvPacket(net_addr_t **addr, net_packet_t **packet)
+{
+    return false;
+}
+
+
+static void NET_NULL_AddrToString(net_addr_t *addr, char *buffer, int buffer_len)
+{
+
+}
+
+
+static void NET_NULL_FreeAddress(net_addr_t *addr)
+{
+}
+
+
+static net_addr_t *NET_NULL_ResolveAddress(const char *address)
+{
+    return NULL;
+}
+
+
+void NET_UDP_WaitForPacket(int timeout)
+{
+    if (timeout > 0)
+    {
+        I_Sleep(timeout);
+    }
+}
+
+
+net_module_t net_udp_module =
+{
+    NET_NULL_InitClient,
+    NET_NULL_InitServer,
+    NET_NULL_SendPacket,
+    NET_NULL_RecvPacket,
+    NET_NULL_AddrToString,
+    NET_NULL_FreeAddress,
+    NET_NULL_ResolveAddress,
+};
+
+
+#endif // _WIN32
+
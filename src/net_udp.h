@@ -0,0 +1,36 @@
+//
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//     Networking module which uses native UDP sockets
+//
+
+#ifndef NET_UDP_H
+#define NET_UDP_H
+
+#include "net_defs.h"
+
+extern net_module_t net_udp_module;
+
+// Block until a packet arrives on the socket or the timeout (in
+// milliseconds) expires.  A negative timeout waits indefinitely.
+
+void NET_UDP_WaitForPacket(int timeout);
+
+// True if -nativeudp was given, to use net_udp_module in place of
+// net_sdl_module for the server.
+
+boolean NET_UDP_Requested(void);
+
+#endif /* #ifndef NET_UDP_H */
+
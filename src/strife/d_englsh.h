@@ -43,6 +43,7 @@
 #define QSAVESPOT	"you haven't picked a\nquicksave slot yet!\n\n"PRESSKEY
 // [STRIFE] modified:
 #define SAVEDEAD 	"you're not playing a game\n\n"PRESSKEY
+#define SAVEFAILED	"couldn't write to the save slot!\n\n"PRESSKEY
 #define QSPROMPT 	"quicksave over your game named\n\n'%s'?\n\n"PRESSYN
 // [STRIFE] modified:
 #define QLPROMPT	"do you want to quickload\n\n'%s'?\n\n"PRESSYN
@@ -1873,6 +1873,7 @@ void D_DoomMain (void)
     if(devparm) // [STRIFE]
         DEH_printf("S_Init: Setting up sound.\n");
     S_Init (sfxVolume * 8, musicVolume * 8, voiceVolume * 8); // [STRIFE]: voice
+    I_CheckRenderMusic();
     D_IntroTick(); // [STRIFE]
 
     // Check for -file in shareware
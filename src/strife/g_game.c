@@ -1675,23 +1675,30 @@ void G_LoadGame (char* name)
 void G_DoLoadGame (boolean userload) 
 {
     int savedleveltime;
+    byte *savebuffer;
+    int savelength;
 
     gameaction = ga_nothing;
 
-    save_stream = M_fopen(loadpath, "rb");
+    // loadpath always names a map in the current slot; see G_LoadPath.
+    savelength = M_ReadSaveFile(savepathtemp, M_BaseName(loadpath),
+                                &savebuffer);
 
     // [STRIFE] If the file does not exist, G_DoLoadLevel is called.
-    if (save_stream == NULL)
+    if (savelength < 0)
     {
         G_DoLoadLevel();
         return;
     }
 
+    save_stream = mem_fopen_read(savebuffer, savelength);
+
     savegame_error = false;
 
     if (!P_ReadSaveGameHeader())
     {
-        fclose(save_stream);
+        mem_fclose(save_stream);
+        Z_Free(savebuffer);
         return;
     }
 
@@ -1721,7 +1728,8 @@ void G_DoLoadGame (boolean userload)
     if (!P_ReadSaveGameEOF())
         I_Error ("Bad savegame");
 
-    fclose(save_stream);
+    mem_fclose(save_stream);
+    Z_Free(savebuffer);
     
     if (setsizeneeded)
         R_ExecuteSetViewSize ();
@@ -1740,7 +1748,6 @@ void G_DoLoadGame (boolean userload)
 boolean G_WriteSaveName(int slot, const char *charname)
 {
     //char savedir[16];
-    char *tmpname;
     boolean retval;
 
     savegameslot = slot;
@@ -1763,13 +1770,8 @@ boolean G_WriteSaveName(int slot, const char *charname)
     memset(character_name, 0, CHARACTER_NAME_LEN);
     M_StringCopy(character_name, charname, sizeof(character_name));
 
-    // haleyjd: use M_SafeFilePath
-    tmpname = M_SafeFilePath(savepathtemp, "name");
-
     // Write the "name" file under the directory
-    retval = M_WriteFile(tmpname, character_name, 32);
-
-    Z_Free(tmpname);
+    retval = M_WriteSaveFile(savepathtemp, "name", character_name, 32);
 
     return retval;
 }
@@ -1795,41 +1797,30 @@ G_SaveGame
 
 void G_DoSaveGame (char *path)
 { 
-    char *current_path;
-    char *savegame_file;
-    char *temp_savegame_file;
     byte gamemapbytes[4];
     char gamemapstr[33];
+    void *savebuffer;
+    size_t savelength;
 
-    temp_savegame_file = P_TempSaveGameFile();
-    
     // [STRIFE] custom save file path logic
     memset(gamemapstr, 0, sizeof(gamemapstr));
     M_snprintf(gamemapstr, sizeof(gamemapstr), "%d", gamemap);
-    savegame_file = M_SafeFilePath(path, gamemapstr);
 
     // [STRIFE] write the "current" file, which tells which hub map
     //   the save slot is currently on.
-    current_path = M_SafeFilePath(path, "current");
     // haleyjd: endian-agnostic IO
     gamemapbytes[0] = (byte)( gamemap        & 0xff);
     gamemapbytes[1] = (byte)((gamemap >>  8) & 0xff);
     gamemapbytes[2] = (byte)((gamemap >> 16) & 0xff);
     gamemapbytes[3] = (byte)((gamemap >> 24) & 0xff);
-    M_WriteFile(current_path, gamemapbytes, 4);
-    Z_Free(current_path);
+    M_WriteSaveFile(path, "current", gamemapbytes, 4);
 
-    // Open the savegame file for writing.  We write to a temporary file
-    // and then rename it at the end if it was successfully written.
+    // The savegame is built in memory and only then written out (to a
+    // temporary file that is renamed into place, if the slot is on disk).
     // This prevents an existing savegame from being overwritten by 
     // a corrupted one, or if a savegame buffer overrun occurs.
 
-    save_stream = M_fopen(temp_savegame_file, "wb");
-
-    if (save_stream == NULL)
-    {
-        return;
-    }
+    save_stream = mem_fopen_write();
 
     savegame_error = false;
 
@@ -1846,23 +1837,16 @@ void G_DoSaveGame (char *path)
     // except if the vanilla_savegame_limit setting is turned off.
     // [STRIFE]: Verified subject to same limit.
 
-    if (vanilla_savegame_limit && ftell(save_stream) > SAVEGAMESIZE)
+    if (vanilla_savegame_limit && mem_ftell(save_stream) > SAVEGAMESIZE)
     {
         I_Error ("Savegame buffer overrun");
     }
     
-    // Finish up, close the savegame file.
-
-    fclose(save_stream);
+    // Finish up, write out the savegame file.
 
-    // Now rename the temporary savegame file to the actual savegame
-    // file, overwriting the old savegame if there was one there.
-
-    M_remove(savegame_file);
-    M_rename(temp_savegame_file, savegame_file);
-    
-    // haleyjd: free the savegame_file path
-    Z_Free(savegame_file);
+    mem_get_buf(save_stream, &savebuffer, &savelength);
+    M_WriteSaveFile(path, gamemapstr, savebuffer, savelength);
+    mem_fclose(save_stream);
 
     gameaction = ga_nothing; 
     //M_StringCopy(savedescription, "", sizeof(savedescription));
@@ -606,8 +606,13 @@ void M_DoNameChar(int choice)
     G_WriteSaveName(choice, savegamestrings[choice]);
     quickSaveSlot = choice;  
     SaveDef.lastOn = choice;
-    ClearSlot();
-    FromCurr();
+
+    if(!FromCurr())
+    {
+        sendsave = 0;
+        M_StartMessage(DEH_String(SAVEFAILED), NULL, false);
+        return;
+    }
     
     if(isdemoversion)
         map = 33;
@@ -736,8 +741,12 @@ void M_DoSave(int slot)
         // of files here, which vanilla did not do. As a result, 1.31 had 
         // broken save behavior to the point of unusability. fraggle agrees 
         // this is detrimental enough to be fixed - unconditionally, for now.
-        ClearSlot();        
-        FromCurr();
+        // FromCurr does the clearing, once the new files are written.
+        if(!FromCurr())
+        {
+            sendsave = 0;
+            M_StartMessage(DEH_String(SAVEFAILED), NULL, false);
+        }
     }
     else
         M_StartMessage(DEH_String(QSAVESPOT), NULL, false);
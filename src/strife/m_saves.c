@@ -45,41 +45,216 @@ char *loadpath;     // Path used while loading the game
 char character_name[CHARACTER_NAME_LEN]; // Name of "character" for saveslot
 
 //
-// ClearTmp
+// Current Slot
 //
-// Clear the temporary save directory
+// The temporary save slot, savepathtemp, is rewritten on every map change,
+// so its files are kept in memory rather than on disk. They only reach the
+// disk when FromCurr copies them into a save slot, and are read back in by
+// ToCurr when a slot is loaded.
 //
-void ClearTmp(void)
+typedef struct savefile_s
 {
-    glob_t *glob;
+    char *name;
+    byte *data;
+    int   length;
+    struct savefile_s *next;
+} savefile_t;
 
-    if(savepathtemp == NULL)
-        I_Error("you fucked up savedir man!");
+static savefile_t *currfiles;
 
-    glob = I_StartGlob(savepathtemp, "*", 0);
-    if (glob == NULL)
-        I_Error("ClearTmp: Couldn't open dir %s", savepathtemp);
+static boolean IsCurrPath(const char *path)
+{
+    return savepathtemp != NULL && !strcmp(path, savepathtemp);
+}
 
-    for (;;)
-    {
-        const char *path = I_NextGlob(glob);
+//
+// FindCurrFile
+//
+// Returns the link to the named file in the current slot, which points to
+// NULL if there is no such file.
+//
+static savefile_t **FindCurrFile(const char *name)
+{
+    savefile_t **link;
 
-        if (path == NULL)
-        {
+    for(link = &currfiles; *link != NULL; link = &(*link)->next)
+    {
+        if(!strcmp((*link)->name, name))
             break;
-        }
-        M_remove(path);
     }
 
-    I_EndGlob(glob);
+    return link;
+}
+
+static void FreeCurrFile(savefile_t **link)
+{
+    savefile_t *file = *link;
+
+    *link = file->next;
+    free(file->data);
+    free(file->name);
+    free(file);
+}
+
+//
+// SetCurrFile
+//
+// Stores a copy of a file in the current slot, replacing any existing file
+// of the same name.
+//
+static void SetCurrFile(const char *name, const void *source, int length)
+{
+    savefile_t **link = FindCurrFile(name);
+
+    if(*link == NULL)
+    {
+        *link = I_Realloc(NULL, sizeof(savefile_t));
+        (*link)->name = M_StringDuplicate(name);
+        (*link)->data = NULL;
+        (*link)->next = NULL;
+    }
+
+    (*link)->data = I_Realloc((*link)->data, length + 1);
+    memcpy((*link)->data, source, length);
+    (*link)->data[length] = '\0';
+    (*link)->length = length;
+}
+
+//
+// M_ReadSaveFile
+//
+// Reads a file from a save slot directory into a Z_Malloc'd buffer, which
+// the caller must free. Returns -1 if the file does not exist.
+//
+int M_ReadSaveFile(const char *path, const char *name, byte **buffer)
+{
+    savefile_t *file;
+    char *filename;
+    int length;
+
+    if(IsCurrPath(path))
+    {
+        if((file = *FindCurrFile(name)) == NULL)
+            return -1;
+
+        *buffer = Z_Malloc(file->length + 1, PU_STATIC, NULL);
+        memcpy(*buffer, file->data, file->length);
+        (*buffer)[file->length] = '\0';
+
+        return file->length;
+    }
+
+    filename = M_SafeFilePath(path, name);
+
+    if(M_FileExists(filename))
+        length = M_ReadFile(filename, buffer);
+    else
+        length = -1;
+
+    Z_Free(filename);
+    return length;
+}
+
+//
+// M_WriteSaveFile
+//
+// Writes a file to a save slot directory. On disk, the file is written
+// under a temporary name and then renamed, so that a failed write leaves
+// any existing file in place.
+//
+boolean M_WriteSaveFile(const char *path, const char *name,
+                        const void *source, int length)
+{
+    char *filename;
+    char *tempname;
+    boolean result;
+
+    if(IsCurrPath(path))
+    {
+        SetCurrFile(name, source, length);
+        return true;
+    }
+
+    filename = M_SafeFilePath(path, name);
+    tempname = M_StringJoin(filename, ".tmp", NULL);
+
+    result = M_WriteFile(tempname, source, length);
+    if(result)
+    {
+        M_remove(filename);
+        M_rename(tempname, filename);
+    }
+    else
+        M_remove(tempname);
+
+    free(tempname);
+    Z_Free(filename);
+    return result;
+}
+
+//
+// RenameSaveFile
+//
+// Renames a file within a save slot directory, replacing any existing file
+// of the new name. Nothing happens if the file does not exist.
+//
+static void RenameSaveFile(const char *path, const char *oldname,
+                           const char *newname)
+{
+    savefile_t **link;
+    savefile_t *file;
+    char *oldpath;
+    char *newpath;
+
+    if(IsCurrPath(path))
+    {
+        if((file = *FindCurrFile(oldname)) == NULL)
+            return;
+
+        if(*(link = FindCurrFile(newname)) != NULL)
+            FreeCurrFile(link);
+
+        free(file->name);
+        file->name = M_StringDuplicate(newname);
+        return;
+    }
+
+    // haleyjd: use M_SafeFilePath, not sprintf
+    oldpath = M_SafeFilePath(path, oldname);
+    newpath = M_SafeFilePath(path, newname);
+
+    // haleyjd: use M_FileExists, not access
+    if(M_FileExists(oldpath))
+    {
+        M_remove(newpath);
+        M_rename(oldpath, newpath);
+    }
+
+    Z_Free(oldpath);
+    Z_Free(newpath);
+}
+
+//
+// ClearTmp
+//
+// Clear the temporary save directory
+//
+void ClearTmp(void)
+{
+    if(savepathtemp == NULL)
+        I_Error("you fucked up savedir man!");
+
+    while(currfiles != NULL)
+        FreeCurrFile(&currfiles);
 }
 
 //
 // ClearSlot
 //
-// Clear a single save slot folder
+// Clear a single save slot folder of any files which are not in the current
+// slot.
 //
-void ClearSlot(void)
+static void ClearSlot(void)
 {
     glob_t *glob;
 
@@ -99,7 +274,10 @@ void ClearSlot(void)
             break;
         }
 
-        M_remove(filepath);
+        if (*FindCurrFile(M_BaseName(filepath)) == NULL)
+        {
+            M_remove(filepath);
+        }
     }
 
     I_EndGlob(glob);
@@ -108,40 +286,54 @@ void ClearSlot(void)
 //
 // FromCurr
 //
-// Copying files from savepathtemp to savepath
+// Copying files from savepathtemp to savepath. Every file is written under a
+// temporary name first, and only once all of them have been written are
+// they renamed over the old files and the rest of the old save cleared. If
+// a write fails, the old save is left as it was and false is returned.
 //
-void FromCurr(void)
+boolean FromCurr(void)
 {
-    glob_t *glob;
+    savefile_t *file;
+    char *filename;
+    char *tempname;
+    boolean result = true;
+
+    for (file = currfiles; file != NULL && result; file = file->next)
+    {
+        filename = M_SafeFilePath(savepath, file->name);
+        tempname = M_StringJoin(filename, ".tmp", NULL);
 
-    glob = I_StartGlob(savepathtemp, "*", 0);
+        result = M_WriteFile(tempname, file->data, file->length);
 
-    if (glob == NULL)
-        I_Error("FromCurr: Couldn't open dir %s", savepathtemp);
+        free(tempname);
+        Z_Free(filename);
+    }
 
-    for (;;)
+    for (file = currfiles; file != NULL; file = file->next)
     {
-        byte *filebuffer;
-        int filelen;
-        const char *srcfilename;
-        char *dstfilename;
+        filename = M_SafeFilePath(savepath, file->name);
+        tempname = M_StringJoin(filename, ".tmp", NULL);
 
-        srcfilename = I_NextGlob(glob);
-        if (srcfilename == NULL)
+        if (result)
         {
-            break;
+            M_remove(filename);
+            M_rename(tempname, filename);
+        }
+        else
+        {
+            M_remove(tempname);
         }
 
-        dstfilename = M_SafeFilePath(savepath, M_BaseName(srcfilename));
-
-        filelen = M_ReadFile(srcfilename, &filebuffer);
-        M_WriteFile(dstfilename, filebuffer, filelen);
+        free(tempname);
+        Z_Free(filename);
+    }
 
-        Z_Free(filebuffer);
-        Z_Free(dstfilename);
+    if (result)
+    {
+        ClearSlot();
     }
 
-    I_EndGlob(glob);
+    return result;
 }
 
 //
@@ -166,7 +358,6 @@ void ToCurr(void)
         byte *filebuffer;
         int filelen;
         const char *srcfilename;
-        char *dstfilename;
 
         srcfilename = I_NextGlob(glob);
         if (srcfilename == NULL)
@@ -174,13 +365,9 @@ void ToCurr(void)
             break;
         }
 
-        dstfilename = M_SafeFilePath(savepathtemp, M_BaseName(srcfilename));
-
         filelen = M_ReadFile(srcfilename, &filebuffer);
-        M_WriteFile(dstfilename, filebuffer, filelen);
-
+        SetCurrFile(M_BaseName(srcfilename), filebuffer, filelen);
         Z_Free(filebuffer);
-        Z_Free(dstfilename);
     }
 
     I_EndGlob(glob);
@@ -193,26 +380,12 @@ void ToCurr(void)
 //
 void M_SaveMoveMapToHere(void)
 {
-    char *mapsave  = NULL;
-    char *heresave = NULL;
     char tmpnum[33];
 
     // haleyjd: no itoa available...
     M_snprintf(tmpnum, sizeof(tmpnum), "%d", gamemap);
 
-    // haleyjd: use M_SafeFilePath, not sprintf
-    mapsave  = M_SafeFilePath(savepath, tmpnum);
-    heresave = M_SafeFilePath(savepath, "here");
-
-    // haleyjd: use M_FileExists, not access
-    if(M_FileExists(mapsave))
-    {
-        M_remove(heresave);
-        M_rename(mapsave, heresave);
-    }
-
-    Z_Free(mapsave);
-    Z_Free(heresave);
+    RenameSaveFile(savepath, tmpnum, "here");
 }
 
 //
@@ -222,24 +395,12 @@ void M_SaveMoveMapToHere(void)
 //
 void M_SaveMoveHereToMap(void)
 {
-    char *mapsave  = NULL;
-    char *heresave = NULL;
     char tmpnum[33];
 
     // haleyjd: no itoa available...
     M_snprintf(tmpnum, sizeof(tmpnum), "%d", gamemap);
 
-    mapsave  = M_SafeFilePath(savepathtemp, tmpnum);
-    heresave = M_SafeFilePath(savepathtemp, "here");
-
-    if(M_FileExists(heresave))
-    {
-        M_remove(mapsave);
-        M_rename(heresave, mapsave);
-    }
-
-    Z_Free(mapsave);
-    Z_Free(heresave);
+    RenameSaveFile(savepathtemp, "here", tmpnum);
 }
 
 //
@@ -249,15 +410,7 @@ void M_SaveMoveHereToMap(void)
 //
 boolean M_SaveMisObj(const char *path)
 {
-    boolean result;
-    char *destpath = NULL;
-
-    // haleyjd 20110210: use M_SafeFilePath, not sprintf
-    destpath = M_SafeFilePath(path, "mis_obj");
-    result   = M_WriteFile(destpath, mission_objective, OBJECTIVE_LEN);
-
-    Z_Free(destpath);
-    return result;
+    return M_WriteSaveFile(path, "mis_obj", mission_objective, OBJECTIVE_LEN);
 }
 
 //
@@ -267,23 +420,20 @@ boolean M_SaveMisObj(const char *path)
 //
 void M_ReadMisObj(void)
 {
-    FILE *f = NULL;
-    char *srcpath = NULL;
+    byte *buffer;
+    int length;
 
-    // haleyjd: use M_SafeFilePath, not sprintf
-    srcpath = M_SafeFilePath(savepathtemp, "mis_obj");
+    length = M_ReadSaveFile(savepathtemp, "mis_obj", &buffer);
 
-    if((f = M_fopen(srcpath, "rb")))
+    if(length >= 0)
     {
-        int retval = fread(mission_objective, 1, OBJECTIVE_LEN, f);
-        fclose(f);
-        if (retval != OBJECTIVE_LEN)
+        if(length < OBJECTIVE_LEN)
         {
             I_Error("M_ReadMisObj: error while reading mission objective");
         }
+        memcpy(mission_objective, buffer, OBJECTIVE_LEN);
+        Z_Free(buffer);
     }
-
-    Z_Free(srcpath);
 }
 
 //=============================================================================
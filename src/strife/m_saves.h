@@ -31,12 +31,16 @@ extern char character_name[CHARACTER_NAME_LEN];
 
 // Strife Savegame Functions
 void ClearTmp(void);
-void ClearSlot(void);
-void FromCurr(void);
+boolean FromCurr(void);
 void ToCurr(void);
 void M_SaveMoveMapToHere(void);
 void M_SaveMoveHereToMap(void);
 
+// Files in save slot directories; those of savepathtemp are held in memory
+int     M_ReadSaveFile(const char *path, const char *name, byte **buffer);
+boolean M_WriteSaveFile(const char *path, const char *name,
+                        const void *source, int length);
+
 boolean M_SaveMisObj(const char *path);
 void    M_ReadMisObj(void);
 
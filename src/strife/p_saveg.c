@@ -37,26 +37,10 @@
 // haleyjd 09/28/10: [STRIFE] VERSIONSIZE == 8
 #define VERSIONSIZE 8 
 
-FILE *save_stream;
+MEMFILE *save_stream;
 int savegamelength;
 boolean savegame_error;
 
-// Get the filename of a temporary file to write the savegame to.  After
-// the file has been successfully saved, it will be renamed to the 
-// real file.
-
-char *P_TempSaveGameFile(void)
-{
-    static char *filename = NULL;
-
-    if (filename == NULL)
-    {
-        filename = M_StringJoin(savegamedir, "temp.dsg", NULL);
-    }
-
-    return filename;
-}
-
 // Get the filename of the save game file to use for the specified slot.
 
 char *P_SaveGameFile(int slot)
@@ -84,7 +68,7 @@ static byte saveg_read8(void)
 {
     byte result;
 
-    if (fread(&result, 1, 1, save_stream) < 1)
+    if (mem_fread(&result, 1, 1, save_stream) < 1)
     {
         if (!savegame_error)
         {
@@ -100,7 +84,7 @@ static byte saveg_read8(void)
 
 static void saveg_write8(byte value)
 {
-    if (fwrite(&value, 1, 1, save_stream) < 1)
+    if (mem_fwrite(&value, 1, 1, save_stream) < 1)
     {
         if (!savegame_error)
         {
@@ -155,7 +139,7 @@ static void saveg_read_pad(void)
     int padding;
     int i;
 
-    pos = ftell(save_stream);
+    pos = mem_ftell(save_stream);
 
     padding = (4 - (pos & 3)) & 3;
 
@@ -171,7 +155,7 @@ static void saveg_write_pad(void)
     int padding;
     int i;
 
-    pos = ftell(save_stream);
+    pos = mem_ftell(save_stream);
 
     padding = (4 - (pos & 3)) & 3;
 
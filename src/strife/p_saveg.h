@@ -22,14 +22,12 @@
 
 #include <stdio.h>
 
+#include "memio.h"
+
 // maximum size of a savegame description
 
 #define SAVESTRINGSIZE 24
 
-// temporary filename to use while saving.
-
-char *P_TempSaveGameFile(void);
-
 // filename to use for a savegame slot
 
 char *P_SaveGameFile(int slot);
@@ -55,7 +53,7 @@ void P_UnArchiveThinkers (void);
 void P_ArchiveSpecials (void);
 void P_UnArchiveSpecials (void);
 
-extern FILE *save_stream;
+extern MEMFILE *save_stream;
 extern boolean savegame_error;
 
 
@@ -88,6 +88,15 @@ void V_RestoreBuffer(void);
 
 void V_ScreenShot(const char *format);
 
+// Write a paletted image out as a PCX or PNG file.  WritePNGfile is
+// only available when built with libpng (HAVE_LIBPNG in config.h).
+void WritePCXfile(char *filename, pixel_t *data, int width, int height,
+                  byte *palette);
+#ifdef HAVE_LIBPNG
+void WritePNGfile(char *filename, pixel_t *data, int width, int height,
+                  byte *palette);
+#endif
+
 // Load the lookup table for translucency calculations from the TINTTAB
 // lump.
 
@@ -550,6 +550,8 @@ static void DoMerge(void)
     free(lumpinfo);
     lumpinfo = newlumps;
     numlumps = num_newlumps;
+
+    W_GenerateHashTable();
 }
 
 void W_PrintDirectory(void)
@@ -664,6 +666,8 @@ void W_NWTMergeFile(const char *filename, int flags)
     // Discard the PWAD
 
     numlumps = old_numlumps;
+
+    W_GenerateHashTable();
 }
 
 // Simulates the NWT -merge command line parameter.  What this does is load
@@ -709,6 +713,7 @@ void W_NWTDashMerge(const char *filename)
             // nwt -merge does.
 
             M_StringCopy(iwad_sprites.lumps[i]->name, "", 8);
+            iwad_sprites.lumps[i]->key = 0;
         }
     }
 
@@ -717,6 +722,8 @@ void W_NWTDashMerge(const char *filename)
 
     numlumps = old_numlumps;
 
+    W_GenerateHashTable();
+
     W_CloseFile(wad_file);
 }
 
@@ -56,8 +56,12 @@ typedef PACKED_STRUCT (
 lumpinfo_t **lumpinfo;
 unsigned int numlumps = 0;
 
-// Hash table for fast lookups
+// Hash table for fast lookups.  Lumps [0, numhashedlumps) are in the
+// table; lumps from newly added files are hooked in as they are
+// loaded.
 static lumpindex_t *lumphash;
+static unsigned int lumphashbits;
+static unsigned int numhashedlumps;
 
 // Variables for the reload hack: filename of the PWAD to reload, and the
 // lumps from WADs before the reload file, so we can resent numlumps and
@@ -78,6 +82,38 @@ unsigned int W_LumpNameHash(const char *s)
     return result;
 }
 
+// Pack a lump name into an integer key, upper-cased, so that names can
+// be compared case-insensitively with a single compare.  Like the
+// names themselves, only the first 8 characters count.
+uint64_t W_LumpNameKey(const char *s)
+{
+    uint64_t result = 0;
+    for (unsigned int i=0; i < 8 && s[i] != '\0'; ++i)
+        result |= (uint64_t) (toupper((unsigned char) s[i]) & 0xff) << (i * 8);
+    return result;
+}
+
+// Hash of a lump name key, as an index into lumphash.
+static unsigned int LumpKeyHash(uint64_t key)
+{
+    return (unsigned int) ((key * 0x9e3779b97f4a7c15ULL) >> (64 - lumphashbits));
+}
+
+// Hook lumps [numhashedlumps, numlumps) into the hash table.  Later
+// lumps go on the front of the chains, so that lumps from PWADs take
+// precedence over the IWAD.
+static void HashNewLumps(void)
+{
+    for (; numhashedlumps < numlumps; ++numhashedlumps)
+    {
+        lumpinfo_t *lump_p = lumpinfo[numhashedlumps];
+        unsigned int hash = LumpKeyHash(lump_p->key);
+
+        lump_p->next = lumphash[hash];
+        lumphash[hash] = numhashedlumps;
+    }
+}
+
 //
 // LUMP BASED ROUTINES.
 //
@@ -187,16 +223,23 @@ wad_file_t *W_AddFile (const char *filename)
         lump_p->size = LONG(filerover->size);
         lump_p->cache = NULL;
         strncpy(lump_p->name, filerover->name, 8);
+        lump_p->key = W_LumpNameKey(lump_p->name);
         lumpinfo[lump_idx] = lump_p;
         ++filerover;
     }
 
     Z_Free(fileinfo);
 
-    if (lumphash != NULL)
+    // Add the new lumps to the hash table, or start again with a
+    // bigger table if there are now too many of them.
+    if (lumphash != NULL && numhashedlumps == startlump
+     && numlumps <= (1U << lumphashbits))
     {
-        Z_Free(lumphash);
-        lumphash = NULL;
+        HashNewLumps();
+    }
+    else
+    {
+        W_GenerateHashTable();
     }
 
     // If this is the reload file, we need to save some details about the
@@ -217,26 +260,18 @@ wad_file_t *W_AddFile (const char *filename)
 //
 lumpindex_t W_CheckNumForName(const char *name)
 {
-    // Do we have a hash table yet?
-    if (lumphash != NULL)
-    {
-        // We do! Excellent.
-        u_int hash = W_LumpNameHash(name) % numlumps;
-        for (lumpindex_t i = lumphash[hash]; i != -1; i = lumpinfo[i]->next)
-        {
-            if (!strncasecmp(lumpinfo[i]->name, name, 8))
-                return i;
-        }
-    }
-    else
+    uint64_t key;
+
+    if (lumphash == NULL)
+        return -1;
+
+    // The first lump on the chain is the last one loaded, so patch lump
+    // files take precedence.
+    key = W_LumpNameKey(name);
+    for (lumpindex_t i = lumphash[LumpKeyHash(key)]; i != -1; i = lumpinfo[i]->next)
     {
-        // We don't have a hash table generated yet. Linear search :-(
-        // scan backwards so patch lump files take precedence
-        for (lumpindex_t i = (lumpindex_t) numlumps - 1; i >= 0; --i)
-        {
-            if (!strncasecmp(lumpinfo[i]->name, name, 8))
-                return i;
-        }
+        if (lumpinfo[i]->key == key)
+            return i;
     }
     return -1; // TFB. Not found.
 }
@@ -370,33 +405,31 @@ void W_ReleaseLumpName(const char *name)
 }
 
 
-// Generate a hash table for fast lookups
+// Generate a hash table for fast lookups.  W_AddFile keeps the table
+// up to date, but it must be regenerated if the lump directory is
+// changed in any other way (eg. by the merge code).
 void W_GenerateHashTable(void)
 {
-    lumpindex_t lump_idx;
+    unsigned int size;
 
     // Free the old hash table, if there is one:
     if (lumphash != NULL)
         Z_Free(lumphash);
 
-    // Generate hash table
-    if (numlumps > 0)
-    {
-        int size = (int) (sizeof(lumpindex_t) * numlumps);
-        lumphash = Z_Malloc(size, PU_STATIC, NULL);
+    // Power of two size, at least one slot per lump
+    lumphashbits = 1;
+    while ((1U << lumphashbits) < numlumps)
+        ++lumphashbits;
 
-        for (lump_idx = 0; lump_idx < numlumps; ++lump_idx)
-            lumphash[lump_idx] = -1;
+    size = 1U << lumphashbits;
+    lumphash = Z_Malloc(size * sizeof(lumpindex_t), PU_STATIC, NULL);
 
-        for (lump_idx = 0; lump_idx < numlumps; ++lump_idx)
-        {
-            unsigned int hash = W_LumpNameHash(lumpinfo[lump_idx]->name) % numlumps;
+    for (unsigned int i = 0; i < size; ++i)
+        lumphash[i] = -1;
 
-            // Hook into the hash table
-            lumpinfo[lump_idx]->next = lumphash[hash];
-            lumphash[hash] = lump_idx;
-        }
-    }
+    // Generate hash table
+    numhashedlumps = 0;
+    HashNewLumps();
 }
 
 // The Doom reload hack. The idea here is that if you give a WAD file to -file
@@ -444,3 +477,94 @@ boolean W_IsIWADLump(const lumpinfo_t *lump)
 {
 	return lump->wad_file == lumpinfo[0]->wad_file;
 }
+
+#ifdef STANDALONE
+
+// Lookup benchmark: load a set of WAD files the way the game does at
+// startup, then time W_CheckNumForName for every lump name in the
+// directory, and for names that are not there.
+
+#include "i_timer.h"
+
+#define BENCH_PASSES 100
+
+// There is no screen to draw the disk icon on.
+void V_BeginRead(size_t nbytes)
+{
+}
+
+int main(int argc, char *argv[])
+{
+    char (*names)[9];
+    char missing[9];
+    uint64_t start, load_time, lookup_time;
+    unsigned int lookups;
+    lumpindex_t i;
+    long found;
+    int pass;
+
+    if (argc < 2)
+    {
+        printf("Usage: %s <wadfile> [<wadfile>...]\n", argv[0]);
+        exit(-1);
+    }
+
+    Z_Init();
+
+    start = I_GetTimeUS();
+
+    for (i = 1; i < argc; ++i)
+    {
+        if (W_AddFile(argv[i]) == NULL)
+        {
+            fprintf(stderr, "Failed to load %s\n", argv[i]);
+            exit(-1);
+        }
+    }
+
+    W_GenerateHashTable();
+
+    load_time = I_GetTimeUS() - start;
+
+    // Copy the names out first, as the game passes its own strings.
+
+    names = malloc(numlumps * sizeof(*names));
+
+    for (i = 0; i < numlumps; ++i)
+    {
+        M_StringCopy(names[i], lumpinfo[i]->name, sizeof(names[i]));
+    }
+
+    found = 0;
+    lookups = 0;
+    start = I_GetTimeUS();
+
+    for (pass = 0; pass < BENCH_PASSES; ++pass)
+    {
+        for (i = 0; i < numlumps; ++i)
+        {
+            found += W_CheckNumForName(names[i]) >= 0;
+
+            // Misses walk a whole chain, like checks for optional
+            // lumps do.
+            M_snprintf(missing, sizeof(missing), "ZZ%06i", i);
+            found += W_CheckNumForName(missing) >= 0;
+
+            lookups += 2;
+        }
+    }
+
+    lookup_time = I_GetTimeUS() - start;
+
+    printf("%i lumps in %i files, loaded in %.3f ms\n",
+           numlumps, argc - 1, load_time / 1000.0);
+    printf("%u lookups (%ld found) in %.3f ms, %.1f ns per lookup\n",
+           lookups, found, lookup_time / 1000.0,
+           lookups > 0 ? (lookup_time * 1000.0) / lookups : 0.0);
+
+    free(names);
+
+    return 0;
+}
+
+#endif
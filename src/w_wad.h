@@ -44,6 +44,10 @@ struct lumpinfo_s
     int	 size;
     void *cache;
 
+    // The name, upper-cased and packed into an integer; see
+    // W_LumpNameKey.  Must be updated if the name is changed.
+    uint64_t key;
+
     // Used for hash table lookups
     lumpindex_t next;
 };
@@ -67,6 +71,7 @@ void *W_CacheLumpName(const char *name, int tag);
 void W_GenerateHashTable(void);
 
 extern unsigned int W_LumpNameHash(const char *s);
+uint64_t W_LumpNameKey(const char *s);
 
 void W_ReleaseLumpNum(lumpindex_t lump);
 void W_ReleaseLumpName(const char *name);
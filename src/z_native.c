@@ -45,6 +45,10 @@ struct memblock_s
  
 static memblock_t *allocated_blocks[PU_NUM_TAGS];
 
+// Called before purgable blocks are thrown out; see Z_SetPurgeHook.
+
+static void (*purge_hook)(void) = NULL;
+
 #ifdef TESTING
 
 static int test_malloced = 0;
@@ -187,6 +191,11 @@ static boolean ClearCache(int size)
         return false;
     }
 
+    if (purge_hook != NULL)
+    {
+        purge_hook();
+    }
+
     // Search to the end of the PU_CACHE list.  The blocks at the end
     // of the list are the ones that have been free for longer and
     // are more likely to be unneeded now.
@@ -504,3 +513,12 @@ unsigned int Z_ZoneSize(void)
     return 0;
 }
 
+//
+// Z_SetPurgeHook
+//
+
+void Z_SetPurgeHook(void (*hook)(void))
+{
+    purge_hook = hook;
+}
+
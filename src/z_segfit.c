@@ -0,0 +1,578 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	Zone Memory Allocation, segregated fit version.
+//
+//	This implements the zone memory API over the same fixed size
+//	heap as z_zone.c, but instead of a rover walking a single list
+//	of blocks, free blocks are kept in lists by size class and
+//	allocated blocks in a list for each tag.  Allocating does not
+//	depend on the size of the heap, and Z_FreeTags only visits the
+//	blocks it frees.
+//
+
+#include <string.h>
+
+#include "doomtype.h"
+#include "i_system.h"
+#include "m_argv.h"
+
+#include "z_zone.h"
+
+
+//
+// ZONE MEMORY ALLOCATION
+//
+// As in z_zone.c, there is never any space between memblocks, and
+//  there will never be two contiguous free memblocks: next/prev
+//  link the blocks in address order so that they can be merged.
+//
+// Each block is also on exactly one other list through listnext/
+//  listprev: a free block on the list for its size class, a used
+//  block on the list for its tag.  New blocks go on the front, so
+//  the back of a tag list holds the oldest blocks.
+//
+// Purgable blocks are thrown out, oldest first, only when no free
+//  block is big enough for an allocation.
+//
+
+#define MEM_ALIGN (int) sizeof(void *)
+#define ZONEID	0x1d4a11
+#define MINFRAGMENT 64
+
+// Free block size classes: class n holds blocks of [2^n, 2^(n+1)) bytes.
+#define NUMSIZECLASSES 32
+
+typedef struct memblock_s
+{
+    int	    size;	// including the header and possibly tiny fragments
+    void**  user;
+    int	    tag;	// PU_FREE if this is free
+    int	    id;	    // should be ZONEID
+    struct memblock_s* next;
+    struct memblock_s* prev;
+    struct memblock_s* listnext;
+    struct memblock_s* listprev;
+} memblock_t;
+
+typedef struct
+{
+    int size; // total bytes malloced, including header
+    memblock_t  blocklist; // start / end cap for linked list
+} memzone_t;
+
+static memzone_t *mainzone;
+static boolean zero_on_free;
+
+// Called before purgable blocks are thrown out; see Z_SetPurgeHook.
+
+static void (*purge_hook)(void) = NULL;
+
+// List heads for free blocks by size class, and used blocks by tag.
+static memblock_t freelists[NUMSIZECLASSES];
+static memblock_t taglists[PU_NUM_TAGS];
+
+// Bit n set if freelists[n] is not empty.
+static unsigned int freemask;
+
+
+static void Z_ListInit(memblock_t *head)
+{
+    head->listnext = head->listprev = head;
+}
+
+static void Z_ListInsert(memblock_t *head, memblock_t *block)
+{
+    block->listprev = head;
+    block->listnext = head->listnext;
+    block->listnext->listprev = block;
+    head->listnext = block;
+}
+
+static void Z_ListRemove(memblock_t *block)
+{
+    if (block->listnext->listprev != block
+     || block->listprev->listnext != block)
+    {
+        I_Error("Z_ListRemove: Doubly-linked list corrupted!");
+    }
+
+    block->listprev->listnext = block->listnext;
+    block->listnext->listprev = block->listprev;
+}
+
+static int Z_SizeClass(int size)
+{
+    int result = 0;
+
+    while (size > 1)
+    {
+        size >>= 1;
+        ++result;
+    }
+
+    return result;
+}
+
+static void Z_InsertFree(memblock_t *block)
+{
+    int sizeclass = Z_SizeClass(block->size);
+
+    Z_ListInsert(&freelists[sizeclass], block);
+    freemask |= 1U << sizeclass;
+}
+
+static void Z_RemoveFree(memblock_t *block)
+{
+    int sizeclass = Z_SizeClass(block->size);
+
+    Z_ListRemove(block);
+
+    if (freelists[sizeclass].listnext == &freelists[sizeclass])
+    {
+        freemask &= ~(1U << sizeclass);
+    }
+}
+
+// Find a free block of at least size bytes.  Any block from a class
+// above the one size falls in is big enough; the class of size itself
+// is only searched if there is nothing bigger.
+
+static memblock_t *Z_FindFree(int size)
+{
+    memblock_t *block;
+    int sizeclass;
+    int i;
+
+    sizeclass = Z_SizeClass(size);
+
+    for (i = sizeclass + 1; i < NUMSIZECLASSES; ++i)
+    {
+        if (freemask & (1U << i))
+        {
+            return freelists[i].listnext;
+        }
+    }
+
+    for (block = freelists[sizeclass].listnext;
+         block != &freelists[sizeclass];
+         block = block->listnext)
+    {
+        if (block->size >= size)
+        {
+            return block;
+        }
+    }
+
+    return NULL;
+}
+
+
+//
+// Z_Init
+// Zone memory allocation
+//
+void Z_Init (void)
+{
+    memblock_t*	block;
+    int	size;
+    int i;
+
+    mainzone = (memzone_t *)I_ZoneBase (&size);
+    mainzone->size = size;
+
+    for (i = 0; i < NUMSIZECLASSES; ++i)
+        Z_ListInit(&freelists[i]);
+
+    for (i = 0; i < PU_NUM_TAGS; ++i)
+        Z_ListInit(&taglists[i]);
+
+    freemask = 0;
+
+    // set the entire zone to one free block
+    block = (memblock_t *)( (byte *)mainzone + sizeof(memzone_t));
+    mainzone->blocklist.next = block;
+    mainzone->blocklist.prev = block;
+    mainzone->blocklist.user = (void *)mainzone;
+    mainzone->blocklist.tag = PU_STATIC;
+
+    block->prev = block->next = &mainzone->blocklist;
+
+    // free block
+    block->tag = PU_FREE;
+    block->user = NULL;
+    block->id = 0;
+    block->size = mainzone->size - (int) sizeof(memzone_t);
+    Z_InsertFree(block);
+
+    // [Deliberately undocumented]
+    // Zone memory debugging flag. If set, memory is zeroed after it is freed
+    // to deliberately break any code that attempts to use it after free.
+    //
+    zero_on_free = M_ParmExists("-zonezero");
+
+    printf("zone memory: Using segregated fit allocator.\n");
+}
+
+// Free a block, merging it with any free neighbours.  Returns the
+// resulting free block.
+
+static memblock_t *Z_FreeBlock(memblock_t *block)
+{
+    memblock_t*	other;
+
+    if (block->user != NULL)
+	    *block->user = 0; // clear the user's mark
+
+    Z_ListRemove(block);
+
+    // mark as free
+    block->tag = PU_FREE;
+    block->user = NULL;
+    block->id = 0;
+
+    // If the -zonezero flag is provided, we zero out the block on free
+    // to break code that depends on reading freed memory.
+    if (zero_on_free)
+        memset((byte *) block + sizeof(memblock_t), 0,
+               block->size - sizeof(memblock_t));
+
+    other = block->prev;
+
+    if (other->tag == PU_FREE)
+    {
+        // merge with previous free block
+        Z_RemoveFree(other);
+        other->size += block->size;
+        other->next = block->next;
+        other->next->prev = other;
+
+        block = other;
+    }
+
+    other = block->next;
+    if (other->tag == PU_FREE)
+    {
+        // merge the next free block onto the end
+        Z_RemoveFree(other);
+        block->size += other->size;
+        block->next = other->next;
+        block->next->prev = block;
+    }
+
+    Z_InsertFree(block);
+
+    return block;
+}
+
+//
+// Z_Free
+//
+void Z_Free (void* ptr)
+{
+    memblock_t*	block;
+
+    block = (memblock_t *) ( (byte *)ptr - sizeof(memblock_t));
+
+    if (block->id != ZONEID)
+	    I_Error ("Z_Free: freed a pointer without ZONEID");
+
+    Z_FreeBlock(block);
+}
+
+// Throw out purgable blocks, oldest first, until a free block of the
+// given size has been made.  Returns NULL if everything purgable has
+// gone and there is still no room.
+
+static memblock_t *Z_PurgeFor(int size)
+{
+    memblock_t *block;
+    int tag;
+
+    if (purge_hook != NULL)
+    {
+        purge_hook();
+    }
+
+    for (tag = PU_NUM_TAGS - 1; tag >= PU_PURGELEVEL; --tag)
+    {
+        while (taglists[tag].listprev != &taglists[tag])
+        {
+            block = Z_FreeBlock(taglists[tag].listprev);
+
+            if (block->size >= size)
+            {
+                return block;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+
+//
+// Z_Malloc
+// You can pass a NULL user if the tag is < PU_PURGELEVEL.
+//
+void* Z_Malloc (int size, int tag, void* user)
+{
+    int extra;
+    memblock_t* newblock;
+    memblock_t*	base;
+    void *result;
+
+    size = (size + MEM_ALIGN - 1) & ~(MEM_ALIGN - 1);
+
+    // account for size of block header
+    size += sizeof(memblock_t);
+
+    if (tag < 0 || tag >= PU_NUM_TAGS || tag == PU_FREE)
+        I_Error("Z_Malloc: attempted to allocate a block with an invalid "
+                "tag: %i", tag);
+
+    if (user == NULL && tag >= PU_PURGELEVEL)
+        I_Error ("Z_Malloc: an owner is required for purgable blocks");
+
+    base = Z_FindFree(size);
+
+    if (base == NULL)
+    {
+        base = Z_PurgeFor(size);
+
+        if (base == NULL)
+        {
+            I_Error ("Z_Malloc: failed on allocation of %i bytes", size);
+        }
+    }
+
+    Z_RemoveFree(base);
+
+    // found a block big enough
+    extra = base->size - size;
+
+    if (extra >  MINFRAGMENT)
+    {
+        // there will be a free fragment after the allocated block
+        newblock = (memblock_t *) ((byte *)base + size );
+        newblock->size = extra;
+
+        newblock->tag = PU_FREE;
+        newblock->user = NULL;
+        newblock->id = 0;
+        newblock->prev = base;
+        newblock->next = base->next;
+        newblock->next->prev = newblock;
+
+        base->next = newblock;
+        base->size = size;
+
+        Z_InsertFree(newblock);
+    }
+
+    base->user = user;
+    base->tag = tag;
+    base->id = ZONEID;
+
+    Z_ListInsert(&taglists[tag], base);
+
+    result  = (void *) ((byte *)base + sizeof(memblock_t));
+
+    if (base->user)
+    {
+        *base->user = result;
+    }
+
+    return result;
+}
+
+
+
+//
+// Z_FreeTags
+//
+void Z_FreeTags (int lowtag, int hightag)
+{
+    int tag;
+
+    for (tag = lowtag; tag <= hightag; ++tag)
+    {
+        if (tag < 0 || tag >= PU_NUM_TAGS || tag == PU_FREE)
+            continue;
+
+        while (taglists[tag].listnext != &taglists[tag])
+            Z_FreeBlock(taglists[tag].listnext);
+    }
+}
+
+
+
+//
+// Z_DumpHeap
+// Note: TFileDumpHeap( stdout ) ?
+//
+void Z_DumpHeap (int lowtag, int hightag)
+{
+    memblock_t*	block;
+    printf("zone size: %i  location: %p\n", mainzone->size, mainzone);
+    printf("tag range: %i to %i\n", lowtag, hightag);
+
+    for (block = mainzone->blocklist.next ;; block = block->next)
+    {
+        if (block->tag >= lowtag && block->tag <= hightag)
+            printf("block:%p    size:%7i    user:%p    tag:%3i\n",
+                   block, block->size, block->user, block->tag);
+
+        if (block->next == &mainzone->blocklist)
+            break; // all blocks have been hit
+
+        if ((byte *)block + block->size != (byte *)block->next)
+            printf ("ERROR: block size does not touch the next block\n");
+
+        if (block->next->prev != block)
+            printf ("ERROR: next block doesn't have proper back link\n");
+
+        if (block->tag == PU_FREE && block->next->tag == PU_FREE)
+            printf ("ERROR: two consecutive free blocks\n");
+    }
+}
+
+
+//
+// Z_FileDumpHeap
+//
+void Z_FileDumpHeap (FILE* f)
+{
+    memblock_t*	block;
+    fprintf(f,"zone size: %i  location: %p\n", mainzone->size,mainzone);
+
+    for (block = mainzone->blocklist.next ;; block = block->next)
+    {
+        fprintf(f,"block:%p    size:%7i    user:%p    tag:%3i\n",
+                block, block->size, block->user, block->tag);
+
+        if (block->next == &mainzone->blocklist)
+        {
+            break; // all blocks have been hit
+        }
+
+        if ((byte *)block + block->size != (byte *)block->next)
+            fprintf (f,"ERROR: block size does not touch the next block\n");
+
+        if (block->next->prev != block)
+            fprintf (f,"ERROR: next block doesn't have proper back link\n");
+
+        if (block->tag == PU_FREE && block->next->tag == PU_FREE)
+            fprintf (f,"ERROR: two consecutive free blocks\n");
+    }
+}
+
+
+
+//
+// Z_CheckHeap
+//
+void Z_CheckHeap (void)
+{
+    memblock_t*	block;
+    for (block = mainzone->blocklist.next ; ; block = block->next)
+    {
+        if (block->listnext->listprev != block
+         || block->listprev->listnext != block)
+            I_Error ("Z_CheckHeap: block list links corrupted\n");
+
+        if (block->next == &mainzone->blocklist)
+            break; // all blocks have been hit
+
+        if ( (byte *)block + block->size != (byte *)block->next)
+            I_Error ("Z_CheckHeap: block size does not touch the next block\n");
+
+        if ( block->next->prev != block)
+            I_Error ("Z_CheckHeap: next block doesn't have proper back link\n");
+
+        if (block->tag == PU_FREE && block->next->tag == PU_FREE)
+            I_Error ("Z_CheckHeap: two consecutive free blocks\n");
+    }
+}
+
+
+//
+// Z_ChangeTag
+//
+void Z_ChangeTag2(void *ptr, int tag, const char *file, int line)
+{
+    memblock_t*	block;
+    block = (memblock_t *) ((byte *)ptr - sizeof(memblock_t));
+
+    if (block->id != ZONEID)
+        I_Error("%s:%i: Z_ChangeTag: block without a ZONEID!",
+                file, line);
+
+    if (tag >= PU_PURGELEVEL && block->user == NULL)
+        I_Error("%s:%i: Z_ChangeTag: an owner is required "
+                "for purgable blocks", file, line);
+
+    // Move to the front of the list for the new tag, so that a block
+    // just released to the cache is the last to be purged.
+    Z_ListRemove(block);
+    block->tag = tag;
+    Z_ListInsert(&taglists[tag], block);
+}
+
+void Z_ChangeUser(void *ptr, void **user)
+{
+    memblock_t*	block;
+    block = (memblock_t *) ((byte *)ptr - sizeof(memblock_t));
+
+    if (block->id != ZONEID)
+        I_Error("Z_ChangeUser: Tried to change user for invalid block!");
+
+    block->user = user;
+    *user = ptr;
+}
+
+
+//
+// Z_FreeMemory
+//
+int Z_FreeMemory (void)
+{
+    memblock_t* block;
+    int free = 0;
+
+    for (block = mainzone->blocklist.next;
+         block != &mainzone->blocklist;
+         block = block->next)
+    {
+        if (block->tag == PU_FREE || block->tag >= PU_PURGELEVEL)
+            free += block->size;
+    }
+    return free;
+}
+
+unsigned int Z_ZoneSize(void)
+{
+    return mainzone->size;
+}
+
+//
+// Z_SetPurgeHook
+//
+
+void Z_SetPurgeHook(void (*hook)(void))
+{
+    purge_hook = hook;
+}
+
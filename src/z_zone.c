@@ -61,6 +61,10 @@ static memzone_t *mainzone;
 static boolean zero_on_free;
 static boolean scan_on_free;
 
+// Called before purgable blocks are thrown out; see Z_SetPurgeHook.
+
+static void (*purge_hook)(void) = NULL;
+
 //
 // Z_ClearZone
 //
@@ -270,6 +274,11 @@ void* Z_Malloc (int size, int tag, void* user)
             {
                 // free the rover block (adding the size to base)
 
+                if (purge_hook != NULL)
+                {
+                    purge_hook();
+                }
+
                 // the rover can be the base block
                 base = base->prev;
                 Z_Free ((byte *)rover+sizeof(memblock_t));
@@ -491,3 +500,12 @@ unsigned int Z_ZoneSize(void)
     return mainzone->size;
 }
 
+//
+// Z_SetPurgeHook
+//
+
+void Z_SetPurgeHook(void (*hook)(void))
+{
+    purge_hook = hook;
+}
+
@@ -62,6 +62,10 @@ void    Z_ChangeUser(void *ptr, void **user);
 int     Z_FreeMemory (void);
 unsigned int Z_ZoneSize(void);
 
+// Set a function to be called before any purgable block is thrown
+// out to make room for an allocation.
+void    Z_SetPurgeHook(void (*hook)(void));
+
 //
 // This is used to get the local FILE:LINE info from CPP
 // prior to really call the function in question.